@@ -2,11 +2,16 @@
 #define ORDER_HPP
 
 #include "core/types.hpp"
+#include <algorithm>
 #include <chrono>
+#include <memory>
 #include <string>
 
 namespace trading {
 
+class PriceLevel;
+class AccountOrders;
+
 class Order {
 public:
     // Constructor for limit orders
@@ -17,10 +22,40 @@ public:
         , side_(side)
         , type_(type)
         , price_(price)
+        , stopPrice_(0)
+        , quantity_(quantity)
+        , remainingQuantity_(quantity)
+        , displayQuantity_(0)
+        , visibleQuantity_(0)
+        , status_(OrderStatus::NEW)
+        , timeInForce_(TimeInForce::GTC)
+        , selfTradePrevention_(SelfTradePrevention::NONE)
+        , postOnly_(PostOnlyMode::NONE)
+        , accountId_(0)
+        , timestamp_(getCurrentTimestamp())
+        , expireTime_(0)
+    {}
+
+    // Constructor for stop (price ignored) and stop-limit orders
+    Order(OrderId id, Symbol symbol, Side side, OrderType type,
+          Price price, Price stopPrice, Quantity quantity)
+        : id_(id)
+        , symbol_(std::move(symbol))
+        , side_(side)
+        , type_(type)
+        , price_(type == OrderType::STOP ? 0 : price)
+        , stopPrice_(stopPrice)
         , quantity_(quantity)
         , remainingQuantity_(quantity)
+        , displayQuantity_(0)
+        , visibleQuantity_(0)
         , status_(OrderStatus::NEW)
+        , timeInForce_(TimeInForce::GTC)
+        , selfTradePrevention_(SelfTradePrevention::NONE)
+        , postOnly_(PostOnlyMode::NONE)
+        , accountId_(0)
         , timestamp_(getCurrentTimestamp())
+        , expireTime_(0)
     {}
 
     // Constructor for market orders (no price)
@@ -30,10 +65,18 @@ public:
         , side_(side)
         , type_(OrderType::MARKET)
         , price_(0)
+        , stopPrice_(0)
         , quantity_(quantity)
         , remainingQuantity_(quantity)
+        , displayQuantity_(0)
+        , visibleQuantity_(0)
         , status_(OrderStatus::NEW)
+        , timeInForce_(TimeInForce::GTC)
+        , selfTradePrevention_(SelfTradePrevention::NONE)
+        , postOnly_(PostOnlyMode::NONE)
+        , accountId_(0)
         , timestamp_(getCurrentTimestamp())
+        , expireTime_(0)
     {}
 
     // Getters
@@ -42,19 +85,69 @@ public:
     Side getSide() const { return side_; }
     OrderType getType() const { return type_; }
     Price getPrice() const { return price_; }
+    Price getStopPrice() const { return stopPrice_; }
     Quantity getQuantity() const { return quantity_; }
     Quantity getRemainingQuantity() const { return remainingQuantity_; }
+    Quantity getDisplayQuantity() const { return displayQuantity_; }
     OrderStatus getStatus() const { return status_; }
     Timestamp getTimestamp() const { return timestamp_; }
+    TimeInForce getTimeInForce() const { return timeInForce_; }
+    Timestamp getExpireTime() const { return expireTime_; }
+    AccountId getAccountId() const { return accountId_; }
+    SelfTradePrevention getSelfTradePrevention() const { return selfTradePrevention_; }
+    PostOnlyMode getPostOnly() const { return postOnly_; }
+
+    // Iceberg orders show at most displayQuantity; the rest is a hidden reserve
+    bool isIceberg() const { return displayQuantity_ != 0; }
+
+    Quantity getVisibleQuantity() const {
+        return displayQuantity_ != 0 ? visibleQuantity_ : remainingQuantity_;
+    }
+
+    Quantity getHiddenQuantity() const {
+        return remainingQuantity_ - getVisibleQuantity();
+    }
 
     // Modifiers
     void setStatus(OrderStatus status) { status_ = status; }
+
+    void setAccountId(AccountId accountId) { accountId_ = accountId; }
+    void setSelfTradePrevention(SelfTradePrevention mode) { selfTradePrevention_ = mode; }
+    void setPostOnly(PostOnlyMode mode) { postOnly_ = mode; }
+
+    // Make this an iceberg showing displayQty at a time (0 = fully displayed)
+    void setDisplayQuantity(Quantity displayQty) {
+        displayQuantity_ = displayQty < remainingQuantity_ ? displayQty : 0;
+        resetDisplay();
+    }
+
+    // Show a full slice (capped by what is left)
+    void resetDisplay() {
+        visibleQuantity_ = std::min(displayQuantity_, remainingQuantity_);
+    }
+
+    /**
+     * Refresh an exhausted slice from the reserve. The refreshed slice
+     * loses time priority. Returns the newly displayed quantity.
+     */
+    Quantity replenish() {
+        resetDisplay();
+        timestamp_ = getCurrentTimestamp();
+        return visibleQuantity_;
+    }
+
+    // expireTime (nanoseconds since epoch) is used by GTD; the engine sets it for DAY
+    void setTimeInForce(TimeInForce tif, Timestamp expireTime = 0) {
+        timeInForce_ = tif;
+        expireTime_ = expireTime;
+    }
     
     void fillQuantity(Quantity qty) {
         if (qty > remainingQuantity_) {
             qty = remainingQuantity_;
         }
         remainingQuantity_ -= qty;
+        visibleQuantity_ -= std::min(qty, visibleQuantity_);
         
         if (remainingQuantity_ == 0) {
             status_ = OrderStatus::FILLED;
@@ -63,9 +156,57 @@ public:
         }
     }
 
+    /**
+     * Reduce open quantity in place; time priority is kept.
+     * Filled quantity is unchanged, so the order total shrinks by the same amount.
+     */
+    void reduceQuantity(Quantity newRemaining) {
+        if (newRemaining >= remainingQuantity_) return;
+        quantity_ -= remainingQuantity_ - newRemaining;
+        remainingQuantity_ = newRemaining;
+        visibleQuantity_ = std::min(visibleQuantity_, newRemaining);
+    }
+
+    /**
+     * Replace price and open quantity. The order loses time priority,
+     * so it is re-stamped and must be re-queued by the caller.
+     */
+    void amend(Price newPrice, Quantity newRemaining) {
+        quantity_ = quantity_ - remainingQuantity_ + newRemaining;
+        remainingQuantity_ = newRemaining;
+        price_ = newPrice;
+        timestamp_ = getCurrentTimestamp();
+        resetDisplay();
+    }
+
     void cancel() {
         status_ = OrderStatus::CANCELLED;
         remainingQuantity_ = 0;
+        visibleQuantity_ = 0;
+    }
+
+    // Stop orders wait in the trigger book until the last trade reaches stopPrice
+    bool isStopOrder() const {
+        return type_ == OrderType::STOP || type_ == OrderType::STOP_LIMIT;
+    }
+
+    // Buy stops trigger at or above the stop price, sell stops at or below
+    bool isTriggeredBy(Price lastTradePrice) const {
+        return side_ == Side::BUY ? lastTradePrice >= stopPrice_
+                                  : lastTradePrice <= stopPrice_;
+    }
+
+    /**
+     * Convert a triggered stop into its working order
+     * (STOP -> MARKET, STOP_LIMIT -> LIMIT). Time priority starts now.
+     */
+    void trigger() {
+        if (type_ == OrderType::STOP) {
+            type_ = OrderType::MARKET;
+        } else if (type_ == OrderType::STOP_LIMIT) {
+            type_ = OrderType::LIMIT;
+        }
+        timestamp_ = getCurrentTimestamp();
     }
 
     // Check if order is active
@@ -120,10 +261,36 @@ private:
     Side side_;
     OrderType type_;
     Price price_;
+    Price stopPrice_;
     Quantity quantity_;
     Quantity remainingQuantity_;
+    Quantity displayQuantity_;   // Iceberg slice size, 0 if fully displayed
+    Quantity visibleQuantity_;   // Iceberg only: shown part of the current slice
     OrderStatus status_;
+    TimeInForce timeInForce_;
+    SelfTradePrevention selfTradePrevention_;
+    PostOnlyMode postOnly_;
+    AccountId accountId_;
     Timestamp timestamp_;
+    Timestamp expireTime_;
+
+    // Intrusive queue links, so leaving a queue is O(1). A price level
+    // owns its orders through levelNext; account links are non-owning.
+    // A copy of an order is a detached snapshot: links are never copied.
+    struct QueueLinks {
+        std::shared_ptr<Order> levelNext;
+        Order* levelPrev = nullptr;
+        Order* accountPrev = nullptr;
+        Order* accountNext = nullptr;
+
+        QueueLinks() = default;
+        QueueLinks(const QueueLinks&) {}
+        QueueLinks& operator=(const QueueLinks&) { return *this; }
+    };
+
+    friend class PriceLevel;
+    friend class AccountOrders;
+    QueueLinks links_;
 
     // Get current timestamp in nanoseconds
     static Timestamp getCurrentTimestamp() {
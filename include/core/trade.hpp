@@ -20,6 +20,8 @@ public:
         , price_(price)
         , quantity_(quantity)
         , timestamp_(getCurrentTimestamp())
+        , buyAccountId_(0)
+        , sellAccountId_(0)
     {}
 
     // Getters
@@ -30,9 +32,23 @@ public:
     Quantity getQuantity() const { return quantity_; }
     Timestamp getTimestamp() const { return timestamp_; }
 
-    // Calculate trade value
+    // Owners of the two orders (0 = no account), stamped by the engine
+    AccountId getBuyAccountId() const { return buyAccountId_; }
+    AccountId getSellAccountId() const { return sellAccountId_; }
+
+    void setAccounts(AccountId buyAccountId, AccountId sellAccountId) {
+        buyAccountId_ = buyAccountId;
+        sellAccountId_ = sellAccountId;
+    }
+
+    // Trade value in fixed point (see Notional)
+    Notional getNotional() const {
+        return notionalOf(price_, quantity_);
+    }
+
+    // Trade value in dollars, for display
     double getValue() const {
-        return priceToDouble(price_) * quantity_;
+        return notionalToDouble(getNotional());
     }
 
     // Check if order was involved in this trade
@@ -75,6 +91,8 @@ private:
     Price price_;
     Quantity quantity_;
     Timestamp timestamp_;
+    AccountId buyAccountId_;
+    AccountId sellAccountId_;
 
     static Timestamp getCurrentTimestamp() {
         auto now = std::chrono::high_resolution_clock::now();
@@ -1,6 +1,7 @@
 #ifndef TYPES_HPP
 #define TYPES_HPP
 
+#include <cmath>
 #include <cstdint>
 #include <string>
 
@@ -9,9 +10,11 @@ namespace trading {
 // Type aliases for clarity and maintainability
 using OrderId = uint64_t;
 using Price = int64_t;        // Fixed-point: divide by 100 for actual price
+using Notional = int64_t;     // Money (values, P&L, limits) at the same scale as Price
 using Quantity = uint64_t;
 using Timestamp = uint64_t;   // Nanoseconds since epoch
 using Symbol = std::string;
+using AccountId = uint32_t;   // 0 = no account
 
 // Order side enumeration
 enum class Side : uint8_t {
@@ -33,7 +36,17 @@ enum class OrderStatus : uint8_t {
     PARTIALLY_FILLED = 1,
     FILLED = 2,
     CANCELLED = 3,
-    REJECTED = 4
+    REJECTED = 4,
+    EXPIRED = 5
+};
+
+// Time in force (values follow FIX tag 59)
+enum class TimeInForce : uint8_t {
+    DAY = 0,   // Expires at session end
+    GTC = 1,   // Good till cancelled
+    IOC = 3,   // Immediate or cancel: unfilled remainder is cancelled
+    FOK = 4,   // Fill or kill: fully filled on arrival or not at all
+    GTD = 6    // Good till date: expires at the order's expire time
 };
 
 // Trade side (aggressor)
@@ -42,6 +55,21 @@ enum class TradeSide : uint8_t {
     SELL = 1
 };
 
+// Self-trade prevention policy, taken from the incoming order
+enum class SelfTradePrevention : uint8_t {
+    NONE = 0,
+    CANCEL_NEWEST = 1,   // Cancel the incoming order's remainder
+    CANCEL_OLDEST = 2,   // Cancel the resting order and keep matching
+    DECREMENT_BOTH = 3   // Reduce both by the overlap, no trade
+};
+
+// Post-only handling when the order would take liquidity
+enum class PostOnlyMode : uint8_t {
+    NONE = 0,
+    REJECT = 1,
+    REPRICE = 2          // Rest one tick inside the opposite best instead
+};
+
 // Convert enums to strings for logging
 inline const char* sideToString(Side side) {
     return side == Side::BUY ? "BUY" : "SELL";
@@ -64,6 +92,18 @@ inline const char* orderStatusToString(OrderStatus status) {
         case OrderStatus::FILLED: return "FILLED";
         case OrderStatus::CANCELLED: return "CANCELLED";
         case OrderStatus::REJECTED: return "REJECTED";
+        case OrderStatus::EXPIRED: return "EXPIRED";
+        default: return "UNKNOWN";
+    }
+}
+
+inline const char* timeInForceToString(TimeInForce tif) {
+    switch (tif) {
+        case TimeInForce::DAY: return "DAY";
+        case TimeInForce::GTC: return "GTC";
+        case TimeInForce::IOC: return "IOC";
+        case TimeInForce::FOK: return "FOK";
+        case TimeInForce::GTD: return "GTD";
         default: return "UNKNOWN";
     }
 }
@@ -77,6 +117,26 @@ inline Price doubleToPrice(double price) {
     return static_cast<Price>(price * 100.0);
 }
 
+// Money conversions; for config and display only, never on the fill path
+inline double notionalToDouble(Notional value) {
+    return static_cast<double>(value) / 100.0;
+}
+
+inline Notional doubleToNotional(double value) {
+    return static_cast<Notional>(std::llround(value * 100.0));
+}
+
+// Intermediate for products of notionals and quantities that may pass 2^63
+__extension__ typedef __int128 WideNotional;
+
+// Intermediate for quantity products (pro-rata shares)
+__extension__ typedef unsigned __int128 WideQuantity;
+
+// Price * quantity; exact while the product fits (about $92 trillion)
+inline Notional notionalOf(Price price, Quantity quantity) {
+    return price * static_cast<Notional>(quantity);
+}
+
 } // namespace trading
 
 #endif // TYPES_HPP
\ No newline at end of file
@@ -0,0 +1,110 @@
+#ifndef ACCOUNT_ORDERS_HPP
+#define ACCOUNT_ORDERS_HPP
+
+#include "core/order.hpp"
+#include "utils/memory_pool.hpp"
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace trading {
+
+/**
+ * AccountOrders threads an intrusive list per account and side through
+ * the orders a container holds, so everything an account has resting can
+ * be found without scanning the book. Linking and unlinking are O(1);
+ * collecting an account's orders is O(orders returned).
+ *
+ * Links are non-owning: the container's own index keeps the orders
+ * alive. Orders without an account (id 0) are not tracked. The per-account
+ * table allocates from the owner's PoolResource when one is given.
+ */
+class AccountOrders {
+public:
+    explicit AccountOrders(utils::PoolResource* resource = nullptr)
+        : lists_(TableAllocator(resource)) {}
+
+    void add(Order& order) {
+        AccountId accountId = order.getAccountId();
+        if (accountId == 0) return;
+
+        List& list = lists_[accountId][sideIndex(order.getSide())];
+        order.links_.accountPrev = nullptr;
+        order.links_.accountNext = list.head;
+        if (list.head) {
+            list.head->links_.accountPrev = &order;
+        }
+        list.head = &order;
+        list.size++;
+    }
+
+    void remove(Order& order) {
+        AccountId accountId = order.getAccountId();
+        if (accountId == 0) return;
+
+        auto it = lists_.find(accountId);
+        if (it == lists_.end()) return;
+
+        List& list = it->second[sideIndex(order.getSide())];
+        if (order.links_.accountPrev) {
+            order.links_.accountPrev->links_.accountNext = order.links_.accountNext;
+        } else if (list.head == &order) {
+            list.head = order.links_.accountNext;
+        } else {
+            return;  // Not linked here
+        }
+        if (order.links_.accountNext) {
+            order.links_.accountNext->links_.accountPrev = order.links_.accountPrev;
+        }
+        order.links_.accountPrev = nullptr;
+        order.links_.accountNext = nullptr;
+        list.size--;
+
+        auto& sides = it->second;
+        if (sides[0].size == 0 && sides[1].size == 0) {
+            lists_.erase(it);
+        }
+    }
+
+    // Append the account's orders on one side to out
+    void collect(AccountId accountId, Side side, std::vector<Order*>& out) const {
+        auto it = lists_.find(accountId);
+        if (it == lists_.end()) return;
+
+        for (Order* order = it->second[sideIndex(side)].head; order; order = order->links_.accountNext) {
+            out.push_back(order);
+        }
+    }
+
+    size_t count(AccountId accountId) const {
+        auto it = lists_.find(accountId);
+        return it == lists_.end() ? 0 : it->second[0].size + it->second[1].size;
+    }
+
+    size_t count(AccountId accountId, Side side) const {
+        auto it = lists_.find(accountId);
+        return it == lists_.end() ? 0 : it->second[sideIndex(side)].size;
+    }
+
+private:
+    struct List {
+        Order* head = nullptr;
+        size_t size = 0;
+    };
+
+    using Sides = std::array<List, 2>;
+    using TableAllocator = utils::PoolAllocator<std::pair<const AccountId, Sides>>;
+
+    std::unordered_map<AccountId, Sides, std::hash<AccountId>, std::equal_to<AccountId>,
+                       TableAllocator> lists_;
+
+    static size_t sideIndex(Side side) {
+        return side == Side::BUY ? 0 : 1;
+    }
+};
+
+} // namespace trading
+
+#endif // ACCOUNT_ORDERS_HPP
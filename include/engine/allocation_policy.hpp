@@ -0,0 +1,128 @@
+#ifndef ALLOCATION_POLICY_HPP
+#define ALLOCATION_POLICY_HPP
+
+#include "core/order.hpp"
+#include "engine/price_level.hpp"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace trading {
+
+/**
+ * Allocation policies decide how an incoming order's quantity is split
+ * across the resting orders of one price level. The engine takes the
+ * policy as a template parameter, so the default FIFO build compiles
+ * none of the pro-rata code.
+ */
+
+/**
+ * Price-time priority: the match loop fills the front order in turn.
+ */
+struct FifoAllocation {
+    static constexpr bool IS_FIFO = true;
+};
+
+/**
+ * Pro-rata allocation over a level's displayed quantity.
+ *
+ *   1. FifoPercent of the incoming quantity (hybrid mode) goes to the
+ *      queue in time priority.
+ *   2. With TopOrderPriority, the front order is then filled first.
+ *   3. The rest is split in proportion to displayed size, rounded down;
+ *      shares below MinAllocation are dropped to zero.
+ *   4. Rounding leftovers are handed out in time priority.
+ *
+ * All integer arithmetic, so the outcome depends only on the queue.
+ */
+template<Quantity MinAllocation = 1, bool TopOrderPriority = true, unsigned FifoPercent = 0>
+class ProRataAllocation {
+public:
+    static_assert(FifoPercent <= 100, "FifoPercent is a percentage");
+
+    static constexpr bool IS_FIFO = false;
+
+    struct Allocation {
+        std::shared_ptr<Order> order;
+        Quantity quantity;
+    };
+
+    /**
+     * Split `quantity` across the level. Returns the non-zero allocations
+     * in queue order; valid until the next call.
+     */
+    const std::vector<Allocation>& allocate(const PriceLevel& level, Quantity quantity) {
+        allocations_.clear();
+        level.forEachOrder([this](const std::shared_ptr<Order>& order) {
+            allocations_.push_back({order, 0});
+        });
+
+        Quantity left = std::min(quantity, level.getDisplayedQuantity());
+
+        // Hybrid: a fixed share of the quantity in time priority
+        if (FifoPercent > 0) {
+            left -= fillInTimePriority(mulDiv(left, FifoPercent, 100));
+        }
+
+        if (TopOrderPriority && left > 0 && !allocations_.empty()) {
+            left -= give(allocations_.front(), left);
+        }
+
+        // Pro-rata over what is still unallocated on each order
+        Quantity base = left;
+        Quantity open = 0;
+        for (const auto& allocation : allocations_) {
+            open += capacity(allocation);
+        }
+
+        if (base > 0 && open > 0) {
+            for (auto& allocation : allocations_) {
+                Quantity share = mulDiv(base, capacity(allocation), open);
+                if (share < MinAllocation) continue;
+                left -= give(allocation, share);
+            }
+        }
+
+        left -= fillInTimePriority(left);
+
+        allocations_.erase(
+            std::remove_if(allocations_.begin(), allocations_.end(),
+                [](const Allocation& allocation) { return allocation.quantity == 0; }),
+            allocations_.end());
+        return allocations_;
+    }
+
+private:
+    std::vector<Allocation> allocations_;  // Reused across calls
+
+    static Quantity capacity(const Allocation& allocation) {
+        return allocation.order->getVisibleQuantity() - allocation.quantity;
+    }
+
+    static Quantity give(Allocation& allocation, Quantity quantity) {
+        Quantity given = std::min(quantity, capacity(allocation));
+        allocation.quantity += given;
+        return given;
+    }
+
+    Quantity fillInTimePriority(Quantity quantity) {
+        Quantity given = 0;
+        for (auto& allocation : allocations_) {
+            if (given == quantity) break;
+            given += give(allocation, quantity - given);
+        }
+        return given;
+    }
+
+    // a * b / c without intermediate overflow, rounded down
+    static Quantity mulDiv(Quantity a, Quantity b, Quantity c) {
+        return static_cast<Quantity>(static_cast<WideQuantity>(a) * b / c);
+    }
+};
+
+// Common hybrid: 40% FIFO, 60% pro-rata with top-order priority
+using HybridAllocation = ProRataAllocation<1, true, 40>;
+
+} // namespace trading
+
+#endif // ALLOCATION_POLICY_HPP
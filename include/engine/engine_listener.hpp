@@ -0,0 +1,92 @@
+#ifndef ENGINE_LISTENER_HPP
+#define ENGINE_LISTENER_HPP
+
+#include "core/order.hpp"
+#include "core/trade.hpp"
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+namespace trading {
+
+/**
+ * Listeners receive the engine's trades and order updates. The engine
+ * takes the listener as a template parameter and calls it directly, so
+ * a listener whose hooks are visible to the compiler is inlined into the
+ * match loop instead of going through a std::function per fill.
+ *
+ * A listener derives from EngineListener<Derived> and hides the hooks it
+ * wants; the rest default to nothing:
+ *
+ *   onOrderUpdate(order)          fills, rests, cancels, rejects, expiries
+ *   onTrade(trade)                every trade, in execution order
+ *   onFills(order, trades, count) with BATCHED = true, instead of onTrade:
+ *                                 all trades of one submitted order
+ *                                 (including the stop cascade it set off)
+ *                                 at once; order is nullptr for an
+ *                                 auction uncross
+ *
+ * Order updates are passed by const reference; take a copy of the
+ * shared_ptr only to keep the order.
+ */
+template<typename Derived>
+class EngineListener {
+public:
+    static constexpr bool BATCHED = false;
+
+    void onOrderUpdate(const std::shared_ptr<Order>&) {}
+
+    void onTrade(const Trade&) {}
+
+    void onFills(const Order*, const Trade* trades, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            self().onTrade(trades[i]);
+        }
+    }
+
+protected:
+    Derived& self() { return static_cast<Derived&>(*this); }
+};
+
+/**
+ * Discards everything; for engines driven only through return values.
+ */
+struct NullListener : EngineListener<NullListener> {};
+
+/**
+ * Run-time callbacks, for consumers wired up after construction. This is
+ * the default listener, so MatchingEngine keeps its callback setters.
+ */
+class CallbackListener : public EngineListener<CallbackListener> {
+public:
+    using TradeCallback = std::function<void(const Trade&)>;
+    using OrderUpdateCallback = std::function<void(const std::shared_ptr<Order>&)>;
+
+    void setTradeCallback(TradeCallback callback) {
+        tradeCallback_ = std::move(callback);
+    }
+
+    void setOrderUpdateCallback(OrderUpdateCallback callback) {
+        orderUpdateCallback_ = std::move(callback);
+    }
+
+    void onOrderUpdate(const std::shared_ptr<Order>& order) {
+        if (orderUpdateCallback_) {
+            orderUpdateCallback_(order);
+        }
+    }
+
+    void onTrade(const Trade& trade) {
+        if (tradeCallback_) {
+            tradeCallback_(trade);
+        }
+    }
+
+private:
+    TradeCallback tradeCallback_;
+    OrderUpdateCallback orderUpdateCallback_;
+};
+
+} // namespace trading
+
+#endif // ENGINE_LISTENER_HPP
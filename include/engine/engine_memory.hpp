@@ -0,0 +1,70 @@
+#ifndef ENGINE_MEMORY_HPP
+#define ENGINE_MEMORY_HPP
+
+#include "core/order.hpp"
+#include "utils/config.hpp"
+#include "utils/logger.hpp"
+#include "utils/memory_arena.hpp"
+#include "utils/memory_pool.hpp"
+#include <memory>
+#include <utility>
+
+namespace trading {
+
+/**
+ * EngineMemory - the trading session's memory, reserved at startup.
+ *
+ * One arena (memory.arena_mb, memory.huge_pages, memory.lock) is mapped
+ * and pre-faulted when the process starts, and the order pool is carved
+ * from it up front for memory.max_orders live orders. Orders made here
+ * during the session reuse resident slots; the pool only falls back to
+ * the heap past that reservation, and logStats() reports when it did.
+ * Other long-lived pools can be carved from getArena().
+ */
+class EngineMemory {
+public:
+    static constexpr int DEFAULT_MAX_ORDERS = 100000;
+
+    explicit EngineMemory(const utils::Config& config = utils::Config::getInstance())
+        : arena_(utils::ArenaSettings::fromConfig("memory", config))
+        , orders_(&arena_)
+    {
+        int maxOrders = config.getInt("memory.max_orders", DEFAULT_MAX_ORDERS);
+        orders_.reserve(maxOrders > 0 ? static_cast<size_t>(maxOrders) : 0);
+    }
+
+    EngineMemory(const EngineMemory&) = delete;
+    EngineMemory& operator=(const EngineMemory&) = delete;
+
+    // Same arguments as the Order constructors; any thread (e.g. every
+    // client reader), and the order may be released on any other
+    template<typename... Args>
+    std::shared_ptr<Order> makeOrder(Args&&... args) {
+        return orders_.make(std::forward<Args>(args)...);
+    }
+
+    utils::MemoryArena& getArena() { return arena_; }
+    const utils::SharedPool<Order>& getOrderPool() const { return orders_; }
+
+    void logStats() const {
+        auto arena = arena_.getStats();
+        auto orders = orders_.getStats();
+        LOG_INFO("Memory arena: ", arena.used >> 20, " of ", arena.capacity >> 20, " MB used",
+                 arena.hugePages ? ", hugepages" : ", normal pages",
+                 arena.locked ? ", locked" : ", not locked");
+        LOG_INFO("Order pool: ", orders.totalCapacity, " slots in ", orders.blocksAllocated,
+                 " blocks (", orders.arenaBlocks, " from the arena)");
+        if (orders.heapBlocks > 0) {
+            LOG_WARN("Order pool outgrew the arena: ", orders.heapBlocks,
+                     " blocks from the heap; raise memory.arena_mb or memory.max_orders");
+        }
+    }
+
+private:
+    utils::MemoryArena arena_;
+    utils::SharedPool<Order> orders_;  // After arena_: carved from it
+};
+
+} // namespace trading
+
+#endif // ENGINE_MEMORY_HPP
@@ -0,0 +1,478 @@
+#ifndef ENGINE_RUNNER_HPP
+#define ENGINE_RUNNER_HPP
+
+#include "core/order.hpp"
+#include "core/trade.hpp"
+#include "engine/matching_engine.hpp"
+#include "engine/top_of_book.hpp"
+#include "risk/risk_shard.hpp"
+#include "utils/latency_trace.hpp"
+#include "utils/ring_buffer.hpp"
+#include "utils/metrics.hpp"
+#include "utils/thread_runtime.hpp"
+#include "utils/logger.hpp"
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <thread>
+
+namespace trading {
+
+enum class EngineCommandType : uint8_t {
+    NEW_ORDER,
+    CANCEL,
+    MODIFY,
+    MASS_CANCEL
+};
+
+/**
+ * A request to the matching thread. Slots are reused in place, so only
+ * the fields of the command's type are meaningful.
+ */
+struct EngineCommand {
+    EngineCommandType type = EngineCommandType::NEW_ORDER;
+    uint64_t clientTag = 0;        // Opaque producer context, echoed on events
+    std::shared_ptr<Order> order;  // NEW_ORDER; owned by the engine once published
+    OrderId orderId = 0;           // CANCEL, MODIFY
+    Price price = 0;               // MODIFY
+    Quantity quantity = 0;         // MODIFY
+    AccountId accountId = 0;       // MASS_CANCEL
+    utils::TraceRecord trace{};    // NEW_ORDER; the producer's detached trace, if any
+};
+
+enum class EngineEventType : uint8_t {
+    ORDER_UPDATE,  // Order state changed (ack, fill, cancel, expiry)
+    TRADE,
+    REJECT,        // Cancel or modify of an unknown order
+    BOOK_UPDATE    // Best bid/offer changed
+};
+
+/**
+ * An output of the matching thread, read in place by every consumer.
+ * As with commands, only the fields of the event's type are meaningful.
+ */
+struct EngineEvent {
+    EngineEventType type = EngineEventType::ORDER_UPDATE;
+    uint64_t clientTag = 0;      // Tag of the command this answers, 0 if unsolicited
+    OrderId orderId = 0;
+    std::optional<Order> order;  // ORDER_UPDATE: detached snapshot after the change
+    std::optional<Trade> trade;  // TRADE
+    TopOfBook::Level bestBid{};  // BOOK_UPDATE; zero quantity if the side is empty
+    TopOfBook::Level bestAsk{};
+    utils::TraceRecord trace{};  // ORDER_UPDATE: first answer to a traced order;
+                                 // the reply stage resumes and finishes it
+};
+
+/**
+ * EngineRunner owns a matching engine on a dedicated (optionally pinned)
+ * thread. Any number of threads enqueue commands into a preallocated
+ * multi-producer ring; the matching thread applies them in arrival order
+ * and publishes acks, fills, trades and book changes to a broadcast ring.
+ *
+ * Each downstream stage (gateway, market data, risk, journal) registers
+ * its own consumer and polls on its own thread at its own pace, so the
+ * stages run in parallel and read events in place without copies. The
+ * engine itself is only ever touched by the matching thread.
+ *
+ * ThreadSettings (usually ThreadSettings::fromConfig("engine")) pin and
+ * prioritize the matching thread and choose how it waits for commands.
+ * Stages that park should wait on getEventSignal(), which is notified
+ * after every batch of commands.
+ */
+template<typename AllocationPolicy>
+class BasicEngineRunner {
+    class Listener;
+
+public:
+    // The engine calls straight into the runner to publish its output
+    using Engine = BasicMatchingEngine<AllocationPolicy, Listener>;
+
+    static constexpr size_t COMMAND_RING_SIZE = 16384;
+    static constexpr size_t EVENT_RING_SIZE = 16384;
+    static constexpr size_t MAX_BATCH = 256;  // Commands per ring drain
+
+    using CommandRing = utils::MPSCRing<EngineCommand, COMMAND_RING_SIZE>;
+    using EventRing = utils::BroadcastRing<EngineEvent, EVENT_RING_SIZE>;
+    using Consumer = typename EventRing::Consumer;
+
+    explicit BasicEngineRunner(const Symbol& symbol,
+                               const utils::ThreadSettings& settings = utils::ThreadSettings(),
+                               utils::MemoryArena* arena = nullptr)
+        : engine_(symbol, arena, Listener(this))
+        , commands_(std::make_unique<CommandRing>())
+        , events_(std::make_unique<EventRing>())
+        , settings_(settings)
+        , running_(false)
+        , stopRequested_(false)
+        , commandsProcessed_(0)
+    {}
+
+    ~BasicEngineRunner() {
+        stop();
+    }
+
+    BasicEngineRunner(const BasicEngineRunner&) = delete;
+    BasicEngineRunner& operator=(const BasicEngineRunner&) = delete;
+
+    /**
+     * Check new orders against per-account limits on the matching thread
+     * and track every account's positions from the fills. Orders that
+     * fail are answered with a REJECTED order update. Call before start().
+     */
+    void enableRisk(const risk::RiskLimits& limits = risk::RiskLimits(),
+                    size_t maxAccounts = risk::RiskShard::DEFAULT_MAX_ACCOUNTS) {
+        risk_ = std::make_unique<risk::RiskShard>(
+            std::vector<Symbol>{engine_.getOrderBook().getSymbol()}, limits, maxAccounts);
+    }
+
+    // The shard's risk state; only while stopped, like getEngine()
+    const risk::RiskShard* getRiskShard() const { return risk_.get(); }
+
+    // Register a downstream stage; call before start()
+    Consumer addConsumer() {
+        return events_->addConsumer();
+    }
+
+    bool start() {
+        if (running_) return false;
+        stopRequested_.store(false, std::memory_order_relaxed);
+        running_ = true;
+        thread_ = std::thread(&BasicEngineRunner::run, this);
+        return true;
+    }
+
+    /**
+     * Stop after applying every command already in the ring. Consumers
+     * must keep polling until this returns, or the matching thread may
+     * wait on a full event ring.
+     */
+    void stop() {
+        if (!running_) return;
+        stopRequested_.store(true, std::memory_order_release);
+        commandSignal_.notify();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        running_ = false;
+    }
+
+    bool isRunning() const { return running_; }
+
+    // Producers (any thread). Each blocks only while the command ring is full.
+
+    // The calling thread's trace, if any, continues on the matching thread
+    // and comes back on the order's first ORDER_UPDATE
+    void submitOrder(std::shared_ptr<Order> order, uint64_t clientTag = 0) {
+        commands_->publish([&](EngineCommand& command) {
+            command.type = EngineCommandType::NEW_ORDER;
+            command.clientTag = clientTag;
+            command.order = std::move(order);
+            utils::LatencyTracer::detach(command.trace);
+        });
+        wakeMatchingThread();
+    }
+
+    void cancelOrder(OrderId orderId, uint64_t clientTag = 0) {
+        commands_->publish([&](EngineCommand& command) {
+            command.type = EngineCommandType::CANCEL;
+            command.clientTag = clientTag;
+            command.orderId = orderId;
+        });
+        wakeMatchingThread();
+    }
+
+    void modifyOrder(OrderId orderId, Price price, Quantity quantity, uint64_t clientTag = 0) {
+        commands_->publish([&](EngineCommand& command) {
+            command.type = EngineCommandType::MODIFY;
+            command.clientTag = clientTag;
+            command.orderId = orderId;
+            command.price = price;
+            command.quantity = quantity;
+        });
+        wakeMatchingThread();
+    }
+
+    void massCancel(AccountId accountId, uint64_t clientTag = 0) {
+        commands_->publish([&](EngineCommand& command) {
+            command.type = EngineCommandType::MASS_CANCEL;
+            command.clientTag = clientTag;
+            command.accountId = accountId;
+        });
+        wakeMatchingThread();
+    }
+
+    // Commands applied so far (any thread)
+    uint64_t getCommandsProcessed() const {
+        return commandsProcessed_.load(std::memory_order_acquire);
+    }
+
+    // Events published so far (any thread)
+    uint64_t getEventsPublished() const {
+        return events_->getCursor();
+    }
+
+    size_t getQueueDepth() const {
+        return commands_->size();
+    }
+
+    // Notified after each batch of commands; for consumers that park
+    utils::WakeSignal& getEventSignal() { return eventSignal_; }
+
+    const utils::ThreadSettings& getThreadSettings() const { return settings_; }
+
+    // Snapshot readers (getTopOfBook, getStatsSnapshot) are safe from any thread
+    const OrderBook& getOrderBook() const {
+        return engine_.getOrderBook();
+    }
+
+    // The engine itself; only while stopped (setup, inspection in tests)
+    Engine& getEngine() { return engine_; }
+    const Engine& getEngine() const { return engine_; }
+
+private:
+    class Listener : public EngineListener<Listener> {
+    public:
+        explicit Listener(BasicEngineRunner* runner) : runner_(runner) {}
+
+        void onOrderUpdate(const std::shared_ptr<Order>& order) {
+            runner_->publishOrder(*order, runner_->tagFor(order->getId()));
+        }
+
+        void onTrade(const Trade& trade) {
+            if (runner_->risk_) {
+                runner_->risk_->onTrade(trade);
+            }
+            runner_->publishTrade(trade);
+        }
+
+    private:
+        BasicEngineRunner* runner_;
+    };
+
+    Engine engine_;
+    std::unique_ptr<CommandRing> commands_;
+    std::unique_ptr<EventRing> events_;
+    utils::ThreadSettings settings_;
+    utils::WakeSignal commandSignal_;
+    utils::WakeSignal eventSignal_;
+    bool running_;
+    std::atomic<bool> stopRequested_;
+    std::atomic<uint64_t> commandsProcessed_;
+    std::thread thread_;
+    std::unique_ptr<risk::RiskShard> risk_;
+
+    // Matching thread only
+    uint64_t currentTag_ = 0;
+    OrderId currentOrderId_ = 0;
+    utils::TraceRecord* pendingTrace_ = nullptr;  // Until the order's first update
+    bool tagAllUpdates_ = false;    // Mass cancel: every update answers the command
+    bool commandReported_ = false;  // The command's own order was reported
+    TopOfBook::Level lastBid_{};
+    TopOfBook::Level lastAsk_{};
+    std::optional<Price> lastMark_;  // Price positions were last valued at
+
+    void run() {
+        utils::ThreadRuntime::apply("matching", settings_);
+        if (settings_.numaLocal && settings_.cpu >= 0) {
+            // The rings were built by the constructing thread; move them
+            // next to the core that reads and writes them
+            utils::ThreadRuntime::placeOnLocalNode(commands_.get(), sizeof(CommandRing));
+            utils::ThreadRuntime::placeOnLocalNode(events_.get(), sizeof(EventRing));
+        }
+
+        utils::SystemMetrics& metrics = utils::SystemMetrics::getInstance();
+        auto apply = [this](EngineCommand& command) { process(command); };
+        utils::IdleStrategy idle(settings_.wait, &commandSignal_);
+        auto ready = [this] {
+            return !commands_->empty() || stopRequested_.load(std::memory_order_acquire);
+        };
+
+        for (;;) {
+            // Read before draining: exit only once the ring was found empty
+            // after the stop request, so earlier commands are all applied
+            bool stopping = stopRequested_.load(std::memory_order_acquire);
+
+            size_t applied = commands_->consume(apply, MAX_BATCH);
+            if (applied > 0) {
+                markPositions();
+                commandsProcessed_.fetch_add(applied, std::memory_order_release);
+                metrics.setGauge(utils::SystemMetrics::Gauge::QUEUE_DEPTH,
+                                 static_cast<int64_t>(commands_->size()));
+                eventSignal_.notify();
+                idle.reset();
+                continue;
+            }
+
+            if (stopping) break;
+            idle.idle(ready);
+        }
+    }
+
+    void process(EngineCommand& command) {
+        currentTag_ = command.clientTag;
+        commandReported_ = false;
+        tagAllUpdates_ = false;
+
+        switch (command.type) {
+            case EngineCommandType::NEW_ORDER: {
+                std::shared_ptr<Order> order = std::move(command.order);
+                currentOrderId_ = order->getId();
+                utils::TraceResume trace(command.trace);
+                pendingTrace_ = command.trace.stageMask != 0 ? &command.trace : nullptr;
+                if (risk_ && !passesRisk(*order)) {
+                    publishOrder(*order, currentTag_);
+                    break;
+                }
+                engine_.submitOrder(order);
+                // Resting in the stop book or auction produces no update of its own
+                if (!commandReported_) {
+                    publishOrder(*order, currentTag_);
+                }
+                break;
+            }
+            case EngineCommandType::CANCEL:
+                currentOrderId_ = command.orderId;
+                if (!engine_.cancelOrder(command.orderId)) {
+                    publishReject(command.orderId);
+                }
+                break;
+            case EngineCommandType::MODIFY:
+                currentOrderId_ = command.orderId;
+                if (!engine_.modifyOrder(command.orderId, command.price, command.quantity)) {
+                    publishReject(command.orderId);
+                }
+                break;
+            case EngineCommandType::MASS_CANCEL:
+                currentOrderId_ = 0;
+                tagAllUpdates_ = true;
+                engine_.massCancel(command.accountId);
+                break;
+        }
+
+        publishBookIfChanged();
+        currentTag_ = 0;
+        currentOrderId_ = 0;
+        pendingTrace_ = nullptr;
+    }
+
+    // Pre-trade check; market orders are valued at the last trade
+    bool passesRisk(Order& order) {
+        std::optional<Price> last = engine_.getLastTradePrice();
+        auto result = risk_->validateOrder(order, last ? *last : 0);
+        if (result == risk::RiskShard::ValidationResult::ACCEPTED) {
+            return true;
+        }
+        order.setStatus(OrderStatus::REJECTED);
+        LOG_WARN("Order ", order.getId(), " rejected: ",
+                 risk::RiskManager::validationResultToString(result));
+        return false;
+    }
+
+    // Revalue positions once per batch if the mark moved: the mid while
+    // both sides are quoted, otherwise the last trade
+    void markPositions() {
+        if (!risk_) return;
+        std::optional<Price> mark = engine_.getLastTradePrice();
+        if (lastBid_.quantity > 0 && lastAsk_.quantity > 0) {
+            mark = (lastBid_.price + lastAsk_.price) / 2;
+        }
+        if (!mark || mark == lastMark_) return;
+        lastMark_ = mark;
+        risk_->markToMarket(engine_.getOrderBook().getSymbol(), *mark);
+    }
+
+    uint64_t tagFor(OrderId orderId) {
+        if (tagAllUpdates_ || orderId == currentOrderId_) {
+            commandReported_ = commandReported_ || orderId == currentOrderId_;
+            return currentTag_;
+        }
+        return 0;
+    }
+
+    void publishOrder(const Order& order, uint64_t clientTag) {
+        // The order's first update is its answer: matching ends here for
+        // the trace (the engine's own MATCH stamp comes after publishing)
+        utils::TraceRecord* trace = nullptr;
+        if (pendingTrace_ && order.getId() == currentOrderId_) {
+            if (order.getStatus() != OrderStatus::REJECTED) {
+                TRACE_STAGE(MATCH);
+            }
+            trace = pendingTrace_;
+            pendingTrace_ = nullptr;
+        }
+
+        events_->publish([&](EngineEvent& event) {
+            event.type = EngineEventType::ORDER_UPDATE;
+            event.clientTag = clientTag;
+            event.orderId = order.getId();
+            event.order.emplace(order);
+            event.trade.reset();
+            if (trace) event.trace = *trace;
+            else event.trace.stageMask = 0;
+        });
+    }
+
+    void publishTrade(const Trade& trade) {
+        events_->publish([&](EngineEvent& event) {
+            event.type = EngineEventType::TRADE;
+            event.clientTag = currentTag_;
+            event.orderId = currentOrderId_;
+            event.order.reset();
+            event.trade.emplace(trade);
+            event.trace.stageMask = 0;
+        });
+    }
+
+    void publishReject(OrderId orderId) {
+        events_->publish([&](EngineEvent& event) {
+            event.type = EngineEventType::REJECT;
+            event.clientTag = currentTag_;
+            event.orderId = orderId;
+            event.order.reset();
+            event.trade.reset();
+            event.trace.stageMask = 0;
+        });
+    }
+
+    void publishBookIfChanged() {
+        TopOfBook::Level bid = levelOf(engine_.getOrderBook().getBestBidLevel());
+        TopOfBook::Level ask = levelOf(engine_.getOrderBook().getBestAskLevel());
+        if (sameLevel(bid, lastBid_) && sameLevel(ask, lastAsk_)) return;
+
+        lastBid_ = bid;
+        lastAsk_ = ask;
+        events_->publish([&](EngineEvent& event) {
+            event.type = EngineEventType::BOOK_UPDATE;
+            event.clientTag = 0;
+            event.orderId = 0;
+            event.order.reset();
+            event.trade.reset();
+            event.bestBid = bid;
+            event.bestAsk = ask;
+            event.trace.stageMask = 0;
+        });
+    }
+
+    static TopOfBook::Level levelOf(const PriceLevel* level) {
+        if (!level) return {0, 0, 0};
+        return {level->getPrice(), level->getDisplayedQuantity(), level->getOrderCount()};
+    }
+
+    static bool sameLevel(const TopOfBook::Level& a, const TopOfBook::Level& b) {
+        return a.price == b.price && a.quantity == b.quantity && a.orderCount == b.orderCount;
+    }
+
+    // Only a parked matching thread needs the futex wake
+    void wakeMatchingThread() {
+        if (settings_.wait == utils::WaitStrategy::PARK) {
+            commandSignal_.notify();
+        }
+    }
+};
+
+// Runner for the default price-time engine
+using EngineRunner = BasicEngineRunner<FifoAllocation>;
+
+} // namespace trading
+
+#endif // ENGINE_RUNNER_HPP
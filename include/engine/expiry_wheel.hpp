@@ -0,0 +1,176 @@
+#ifndef EXPIRY_WHEEL_HPP
+#define EXPIRY_WHEEL_HPP
+
+#include "core/types.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+namespace trading {
+
+/**
+ * ExpiryWheel - hierarchical timing wheel for order expiry.
+ *
+ * Four levels of 256 slots; level L slots each span 256^L ticks, so with
+ * the default 1 ms tick the wheel covers ~49 days. Scheduling is O(1);
+ * advancing costs one slot visit per tick plus one re-bucketing of each
+ * entry per level it descends through. Expiries further out than the
+ * wheel's range are parked in the last reachable slot and re-bucketed
+ * when they come round.
+ *
+ * Entries are never removed: owners check on expiry whether the order is
+ * still live (lazy deletion), which keeps cancels and fills free of any
+ * wheel bookkeeping.
+ */
+class ExpiryWheel {
+public:
+    struct Entry {
+        OrderId orderId;
+        Timestamp expireTime;  // Nanoseconds since epoch
+    };
+
+    static constexpr size_t LEVELS = 4;
+    static constexpr size_t SLOT_BITS = 8;
+    static constexpr size_t SLOTS = size_t{1} << SLOT_BITS;
+    static constexpr uint64_t DEFAULT_TICK_NANOS = 1000000;  // 1 ms
+
+    explicit ExpiryWheel(uint64_t tickNanos = DEFAULT_TICK_NANOS)
+        : tickNanos_(tickNanos)
+        , currentTick_(0)
+        , started_(false)
+        , size_(0)
+    {}
+
+    void schedule(OrderId orderId, Timestamp expireTime) {
+        size_++;
+
+        // The current slot has already fired, and before the first
+        // advance there is no time base yet: hold until the next advance
+        if (!started_ || toTicks(expireTime) <= currentTick_) {
+            due_.push_back({orderId, expireTime});
+            return;
+        }
+        insert({orderId, expireTime});
+    }
+
+    /**
+     * Move the wheel to `now`, calling onExpire(entry) for every entry whose
+     * expire time has been reached. Returns the number of entries fired.
+     */
+    template<typename Callback>
+    size_t advance(Timestamp now, Callback&& onExpire) {
+        uint64_t target = now / tickNanos_;
+        if (!started_) {
+            currentTick_ = target;
+            started_ = true;
+        }
+
+        size_t fired = fireDue(onExpire);
+
+        while (currentTick_ < target) {
+            if (size_ == 0) {
+                currentTick_ = target;
+                break;
+            }
+
+            currentTick_++;
+            cascade(1);
+
+            std::vector<Entry>& slot = levels_[0][currentTick_ & (SLOTS - 1)];
+            if (slot.empty()) continue;
+
+            scratch_.swap(slot);
+            for (const Entry& entry : scratch_) {
+                if (toTicks(entry.expireTime) > currentTick_) {
+                    insert(entry);  // Parked beyond the wheel's range
+                } else {
+                    size_--;
+                    onExpire(entry);
+                    fired++;
+                }
+            }
+            scratch_.clear();
+        }
+
+        return fired;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    uint64_t getTickNanos() const { return tickNanos_; }
+
+    // Time of the last advance, in wheel resolution
+    Timestamp now() const { return currentTick_ * tickNanos_; }
+
+private:
+    using Slots = std::array<std::vector<Entry>, SLOTS>;
+
+    uint64_t tickNanos_;
+    uint64_t currentTick_;
+    bool started_;
+    size_t size_;
+    std::array<Slots, LEVELS> levels_;
+    std::vector<Entry> due_;      // Already expired when scheduled
+    std::vector<Entry> scratch_;  // Reused while draining a slot
+
+    uint64_t toTicks(Timestamp time) const {
+        return time / tickNanos_;
+    }
+
+    // Bucket an entry due at or after the current tick
+    void insert(const Entry& entry) {
+        // Clamp to the wheel's range; advance() re-buckets parked entries
+        const uint64_t maxDelta = (uint64_t{1} << (SLOT_BITS * LEVELS)) - 1;
+        uint64_t delta = std::min(toTicks(entry.expireTime) - currentTick_, maxDelta);
+        uint64_t slotTick = currentTick_ + delta;
+
+        size_t level = 0;
+        while (level + 1 < LEVELS && delta >= (uint64_t{1} << (SLOT_BITS * (level + 1)))) {
+            level++;
+        }
+
+        levels_[level][(slotTick >> (SLOT_BITS * level)) & (SLOTS - 1)].push_back(entry);
+    }
+
+    // When a level wraps, redistribute the next slot of the level above
+    void cascade(size_t level) {
+        if (level >= LEVELS) return;
+        if ((currentTick_ & ((uint64_t{1} << (SLOT_BITS * level)) - 1)) != 0) return;
+
+        cascade(level + 1);
+
+        std::vector<Entry>& slot = levels_[level][(currentTick_ >> (SLOT_BITS * level)) & (SLOTS - 1)];
+        if (slot.empty()) return;
+
+        std::vector<Entry> entries;
+        entries.swap(slot);
+        for (const Entry& entry : entries) {
+            insert(entry);
+        }
+    }
+
+    template<typename Callback>
+    size_t fireDue(Callback& onExpire) {
+        if (due_.empty()) return 0;
+
+        size_t fired = 0;
+        std::vector<Entry> entries;
+        entries.swap(due_);
+        for (const Entry& entry : entries) {
+            if (toTicks(entry.expireTime) > currentTick_) {
+                insert(entry);
+            } else {
+                size_--;
+                onExpire(entry);
+                fired++;
+            }
+        }
+        return fired;
+    }
+};
+
+} // namespace trading
+
+#endif // EXPIRY_WHEEL_HPP
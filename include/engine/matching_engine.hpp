@@ -4,81 +4,401 @@
 #include "core/order.hpp"
 #include "core/trade.hpp"
 #include "engine/order_book.hpp"
+#include "engine/stop_book.hpp"
+#include "engine/expiry_wheel.hpp"
+#include "engine/allocation_policy.hpp"
+#include "engine/engine_listener.hpp"
 #include "utils/logger.hpp"
+#include "utils/latency_trace.hpp"
 #include <vector>
+#include <deque>
 #include <memory>
-#include <functional>
+#include <optional>
+#include <tuple>
+#include <utility>
 
 namespace trading {
 
+/**
+ * The taker's side, fixed at compile time for the match loop: which
+ * book side it takes from, which resting prices its limit accepts, and
+ * which way round the trade's buy and sell ids and accounts go.
+ */
+template<Side S>
+struct MatchSide {
+    static constexpr Side MAKER = S == Side::BUY ? Side::SELL : Side::BUY;
+
+    static constexpr bool accepts(Price limit, Price resting) {
+        if constexpr (S == Side::BUY) {
+            return resting <= limit;
+        } else {
+            return resting >= limit;
+        }
+    }
+
+    static Trade makeTrade(const Order& taker, const Order& maker, const Symbol& symbol,
+                           Price price, Quantity quantity) {
+        if constexpr (S == Side::BUY) {
+            Trade trade(taker.getId(), maker.getId(), symbol, price, quantity);
+            trade.setAccounts(taker.getAccountId(), maker.getAccountId());
+            return trade;
+        } else {
+            Trade trade(maker.getId(), taker.getId(), symbol, price, quantity);
+            trade.setAccounts(maker.getAccountId(), taker.getAccountId());
+            return trade;
+        }
+    }
+};
+
+/**
+ * How an order type behaves in the match loop. An order type that sweeps
+ * the book gets a specialization here rather than its own loops.
+ */
+template<OrderType T>
+struct MatchType;
+
+template<>
+struct MatchType<OrderType::MARKET> {
+    static constexpr bool HAS_LIMIT = false;  // Takes any price
+    static constexpr bool RESTS = false;      // Remainder is dropped
+};
+
+template<>
+struct MatchType<OrderType::LIMIT> {
+    static constexpr bool HAS_LIMIT = true;
+    static constexpr bool RESTS = true;       // Unless IOC/FOK
+};
+
+enum class BatchCommandType : uint8_t {
+    NEW_ORDER,
+    CANCEL,
+    MODIFY
+};
+
+/**
+ * One entry of a submitBatch() burst, applied exactly as the matching
+ * single call (submitOrder, cancelOrder, modifyOrder) would be.
+ */
+struct BatchCommand {
+    BatchCommandType type = BatchCommandType::NEW_ORDER;
+    std::shared_ptr<Order> order;  // NEW_ORDER
+    OrderId orderId = 0;           // CANCEL, MODIFY
+    Price price = 0;               // MODIFY
+    Quantity quantity = 0;         // MODIFY
+    bool applied = false;          // Out: CANCEL/MODIFY succeeded (the single call's result)
+
+    static BatchCommand newOrder(std::shared_ptr<Order> order) {
+        BatchCommand command;
+        command.order = std::move(order);
+        return command;
+    }
+
+    static BatchCommand cancel(OrderId orderId) {
+        BatchCommand command;
+        command.type = BatchCommandType::CANCEL;
+        command.orderId = orderId;
+        return command;
+    }
+
+    static BatchCommand modify(OrderId orderId, Price price, Quantity quantity) {
+        BatchCommand command;
+        command.type = BatchCommandType::MODIFY;
+        command.orderId = orderId;
+        command.price = price;
+        command.quantity = quantity;
+        return command;
+    }
+};
+
 /**
  * MatchingEngine executes trades by matching incoming orders
- * against the order book using price-time priority.
+ * against the order book. Price priority always applies; within a
+ * level the AllocationPolicy decides (FIFO time priority by default,
+ * see allocation_policy.hpp for pro-rata and hybrid). Trades and order
+ * updates go to the Listener (see engine_listener.hpp), called directly;
+ * the default CallbackListener forwards to run-time callbacks.
  */
-class MatchingEngine {
+template<typename AllocationPolicy, typename Listener = CallbackListener>
+class BasicMatchingEngine {
 public:
     // Callback for trade notifications
-    using TradeCallback = std::function<void(const Trade&)>;
+    using TradeCallback = CallbackListener::TradeCallback;
     
     // Callback for order updates (fills, cancellations)
-    using OrderUpdateCallback = std::function<void(std::shared_ptr<Order>)>;
+    using OrderUpdateCallback = CallbackListener::OrderUpdateCallback;
 
-    explicit MatchingEngine(const Symbol& symbol)
-        : orderBook_(symbol)
+    // arena: optional pre-faulted memory for the book's node pools
+    explicit BasicMatchingEngine(const Symbol& symbol, utils::MemoryArena* arena = nullptr,
+                                 Listener listener = Listener())
+        : orderBook_(symbol, arena)
         , symbol_(symbol)
         , nextOrderId_(1)
+        , listener_(std::move(listener))
     {}
 
     // Submit a new order and return trades generated
     std::vector<Trade> submitOrder(std::shared_ptr<Order> order) {
-        std::vector<Trade> trades;
+        // Publish the book snapshot once for the whole match, not per fill
+        OrderBook::PublishBatch batch(orderBook_);
 
-        if (order->getSymbol() != symbol_) {
-            LOG_ERROR("Order symbol mismatch: ", order->getSymbol(), 
-                           " vs ", symbol_);
-            return trades;
+        std::vector<Trade> trades = processOrder(order);
+        deliverTrades(order.get(), trades.data(), trades.size());
+
+        TRACE_STAGE(MATCH);
+        return trades;
+    }
+
+    /**
+     * Apply a burst of commands (e.g. everything decoded from one packet)
+     * in arrival order. Trades, book state, order updates and the cancel
+     * and modify results (in each command's `applied`) are the same as
+     * making the single calls one by one, but the book snapshot is
+     * published once, the next order's memory and the book slots it will
+     * touch are prefetched while the current one matches, and the burst's
+     * trades are appended to `trades` and delivered to the listener
+     * together at the end. Returns the number of trades appended.
+     */
+    size_t submitBatch(BatchCommand* commands, size_t count, std::vector<Trade>& trades) {
+        OrderBook::PublishBatch batch(orderBook_);
+        size_t first = trades.size();
+
+        // Two stages ahead: the order object first, then (once it is
+        // cached) the book slots it will touch
+        for (size_t i = 0; i < count && i < 2; ++i) {
+            prefetchObject(commands[i].order.get());
         }
 
-        // Match based on order type
-        if (order->getType() == OrderType::MARKET) {
-            trades = matchMarketOrder(order);
-        } else if (order->getType() == OrderType::LIMIT) {
-            trades = matchLimitOrder(order);
+        batchEnds_.clear();
+        for (size_t i = 0; i < count; ++i) {
+            if (i + 2 < count && commands[i + 2].order) {
+                prefetchObject(commands[i + 2].order.get());
+            }
+            if (i + 1 < count && commands[i + 1].type == BatchCommandType::NEW_ORDER) {
+                orderBook_.prefetchFor(*commands[i + 1].order);
+            }
+
+            BatchCommand& command = commands[i];
+            switch (command.type) {
+                case BatchCommandType::NEW_ORDER: {
+                    std::vector<Trade> orderTrades = processOrder(command.order);
+                    trades.insert(trades.end(), orderTrades.begin(), orderTrades.end());
+                    break;
+                }
+                case BatchCommandType::CANCEL:
+                    command.applied = cancelOrder(command.orderId);
+                    break;
+                case BatchCommandType::MODIFY:
+                    command.applied = modifyOrder(command.orderId, command.price,
+                                                  command.quantity);
+                    break;
+            }
+            if constexpr (Listener::BATCHED) {
+                batchEnds_.push_back(trades.size());
+            }
         }
 
-        // Notify callbacks
-        for (const auto& trade : trades) {
-            if (tradeCallback_) {
-                tradeCallback_(trade);
+        if constexpr (Listener::BATCHED) {
+            // Still one delivery per order, each with that order's fills
+            size_t begin = first;
+            for (size_t i = 0; i < count; ++i) {
+                deliverTrades(commands[i].order.get(), trades.data() + begin,
+                              batchEnds_[i] - begin);
+                begin = batchEnds_[i];
             }
+        } else {
+            deliverTrades(nullptr, trades.data() + first, trades.size() - first);
         }
 
+        TRACE_STAGE(MATCH);
+        return trades.size() - first;
+    }
+
+    // A burst of new orders only
+    std::vector<Trade> submitBatch(const std::vector<std::shared_ptr<Order>>& orders) {
+        std::vector<BatchCommand> commands;
+        commands.reserve(orders.size());
+        for (const auto& order : orders) {
+            commands.push_back(BatchCommand::newOrder(order));
+        }
+        std::vector<Trade> trades;
+        submitBatch(commands.data(), commands.size(), trades);
         return trades;
     }
 
-    // Cancel an order
+    // Cancel an order (resting or untriggered stop)
     bool cancelOrder(OrderId orderId) {
-        return orderBook_.cancelOrder(orderId);
+        auto order = orderBook_.getOrder(orderId);
+        if (order) {
+            orderBook_.cancelOrder(orderId);
+        } else {
+            order = stopBook_.removeStop(orderId);
+            if (!order) return false;
+            order->cancel();
+        }
+
+        listener_.onOrderUpdate(order);
+        return true;
     }
 
-    // Modify an order (cancel and replace)
+    /**
+     * Cancel all of an account's orders, resting and untriggered stops,
+     * optionally only for one symbol and/or side. Cost is proportional
+     * to the number of orders cancelled. Each cancelled order is reported
+     * to the listener as an order update. Returns the number cancelled.
+     */
+    size_t massCancel(AccountId accountId,
+                      std::optional<Symbol> symbol = std::nullopt,
+                      std::optional<Side> side = std::nullopt) {
+        if (accountId == 0 || (symbol && *symbol != symbol_)) {
+            return 0;
+        }
+
+        OrderBook::PublishBatch batch(orderBook_);
+
+        auto cancelled = orderBook_.massCancel(accountId, side);
+        for (auto& stop : stopBook_.removeAccount(accountId, side)) {
+            stop->cancel();
+            cancelled.push_back(std::move(stop));
+        }
+
+        stats_.ordersMassCancelled += cancelled.size();
+        for (const auto& order : cancelled) {
+            listener_.onOrderUpdate(order);
+        }
+        return cancelled.size();
+    }
+
+    // Modify an order; size reductions at the same price keep queue priority.
+    // Amends that would cross the opposite side are rejected.
     bool modifyOrder(OrderId orderId, Price newPrice, Quantity newQuantity) {
-        return orderBook_.modifyOrder(orderId, newPrice, newQuantity);
+        auto order = orderBook_.getOrder(orderId);
+        if (!order) {
+            return false;
+        }
+
+        if (!inAuction_ && newPrice != order->getPrice()) {
+            auto opposite = order->getSide() == Side::BUY ? orderBook_.getBestAsk()
+                                                          : orderBook_.getBestBid();
+            bool crosses = opposite && (order->getSide() == Side::BUY ? newPrice >= *opposite
+                                                                      : newPrice <= *opposite);
+            if (crosses) {
+                return false;
+            }
+        }
+
+        if (!orderBook_.amendOrder(orderId, newPrice, newQuantity)) {
+            return false;
+        }
+
+        listener_.onOrderUpdate(order);
+        return true;
+    }
+
+    /**
+     * Session end used as the expire time of DAY orders rested from now on.
+     * Without one, DAY orders rest like GTC.
+     */
+    void setSessionEnd(Timestamp sessionEnd) { sessionEnd_ = sessionEnd; }
+
+    /**
+     * Expire DAY/GTD orders due by `now` (nanoseconds since epoch).
+     * Driven by the caller's clock; returns the number of orders expired.
+     */
+    size_t advanceTime(Timestamp now) {
+        OrderBook::PublishBatch batch(orderBook_);
+
+        size_t expired = 0;
+        expiryWheel_.advance(now, [this, &expired](const ExpiryWheel::Entry& entry) {
+            if (expireOrder(entry)) expired++;
+        });
+        return expired;
+    }
+
+    /**
+     * Enter a call auction: limit orders rest without matching (the book
+     * may cross) until uncrossAuction(). Market, IOC and FOK orders are
+     * rejected while the auction is open.
+     */
+    void startAuction() { inAuction_ = true; }
+
+    bool isInAuction() const { return inAuction_; }
+
+    // Price and volume the auction would uncross at right now
+    OrderBook::UncrossResult getIndicativeUncross() const {
+        return orderBook_.computeUncross(lastTradePrice_);
+    }
+
+    /**
+     * Close the auction: execute everything executable at the single
+     * equilibrium price (see OrderBook::computeUncross), pairing bids and
+     * asks in price-time priority, then resume continuous matching.
+     * Self-trade prevention does not apply to the uncross.
+     */
+    std::vector<Trade> uncrossAuction() {
+        std::vector<Trade> trades;
+        if (!inAuction_) return trades;
+        inAuction_ = false;
+
+        OrderBook::PublishBatch batch(orderBook_);
+        OrderBook::UncrossResult uncross = orderBook_.computeUncross(lastTradePrice_);
+
+        Quantity left = uncross.crossed ? uncross.volume : 0;
+        while (left > 0) {
+            auto buyOrder = getBestBidOrder();
+            auto sellOrder = getBestAskOrder();
+            if (!buyOrder || !sellOrder) break;
+
+            Quantity fillQty = std::min({left, buyOrder->getVisibleQuantity(),
+                                         sellOrder->getVisibleQuantity()});
+
+            Trade trade(buyOrder->getId(), sellOrder->getId(),
+                        symbol_, uncross.price, fillQty);
+            trade.setAccounts(buyOrder->getAccountId(), sellOrder->getAccountId());
+            trades.push_back(trade);
+
+            orderBook_.fillOrder(buyOrder, fillQty);
+            orderBook_.fillOrder(sellOrder, fillQty);
+            left -= fillQty;
+
+            stats_.totalTrades++;
+            stats_.totalVolume += fillQty;
+            stats_.totalValue += trade.getNotional();
+
+            listener_.onOrderUpdate(buyOrder);
+            listener_.onOrderUpdate(sellOrder);
+        }
+
+        if (!trades.empty()) {
+            lastTradePrice_ = uncross.price;
+            stats_.auctionsUncrossed++;
+        }
+        processTriggeredStops(trades);
+
+        deliverTrades(nullptr, trades.data(), trades.size());
+        return trades;
     }
 
     // Get the order book
     const OrderBook& getOrderBook() const { return orderBook_; }
     OrderBook& getOrderBook() { return orderBook_; }
 
-    // Set callbacks
+    // Untriggered stop and stop-limit orders
+    const StopBook& getStopBook() const { return stopBook_; }
+
+    std::optional<Price> getLastTradePrice() const { return lastTradePrice_; }
+
+    // Set callbacks (CallbackListener only)
     void setTradeCallback(TradeCallback callback) {
-        tradeCallback_ = std::move(callback);
+        listener_.setTradeCallback(std::move(callback));
     }
 
     void setOrderUpdateCallback(OrderUpdateCallback callback) {
-        orderUpdateCallback_ = std::move(callback);
+        listener_.setOrderUpdateCallback(std::move(callback));
     }
 
+    Listener& getListener() { return listener_; }
+    const Listener& getListener() const { return listener_; }
+
     // Generate next order ID
     OrderId getNextOrderId() { return nextOrderId_++; }
 
@@ -86,303 +406,464 @@ public:
     struct MatchingStats {
         uint64_t totalTrades;
         uint64_t totalVolume;
-        double totalValue;
+        Notional totalValue;         // Fixed point, see notionalToDouble
         uint64_t marketOrdersMatched;
         uint64_t limitOrdersMatched;
+        uint64_t stopsTriggered;
+        uint64_t ordersExpired;
+        uint64_t ordersKilled;       // IOC remainders and unfillable FOKs
+        uint64_t selfTradesPrevented;
+        uint64_t postOnlyRejected;
+        uint64_t auctionsUncrossed;
+        uint64_t ordersMassCancelled;
     };
 
     MatchingStats getStats() const { return stats_; }
 
 private:
     OrderBook orderBook_;
+    StopBook stopBook_;
+    ExpiryWheel expiryWheel_;
+    Timestamp sessionEnd_ = 0;
+    bool inAuction_ = false;
+    std::deque<std::shared_ptr<Order>> triggeredStops_;  // Reused cascade queue
+    std::optional<Price> lastTradePrice_;
     Symbol symbol_;
     OrderId nextOrderId_;
     MatchingStats stats_{};
-    TradeCallback tradeCallback_;
-    OrderUpdateCallback orderUpdateCallback_;
+    Listener listener_;
+    AllocationPolicy allocation_;
+    std::vector<size_t> batchEnds_;  // submitBatch: end of each order's trades
 
     /**
-     * Match a market order against the book.
-     * Market orders execute immediately at the best available prices.
+     * Everything submitOrder does except publishing and trade delivery,
+     * which the caller does once per order or once per batch.
      */
-    std::vector<Trade> matchMarketOrder(std::shared_ptr<Order> order) {
+    std::vector<Trade> processOrder(const std::shared_ptr<Order>& order) {
         std::vector<Trade> trades;
 
-        if (order->getSide() == Side::BUY) {
-            trades = matchMarketBuyOrder(order);
-        } else {
-            trades = matchMarketSellOrder(order);
+        if (order->getSymbol() != symbol_) {
+            LOG_ERROR("Order symbol mismatch: ", order->getSymbol(), 
+                           " vs ", symbol_);
+            return trades;
         }
 
-        stats_.marketOrdersMatched++;
+        // Stops wait in the trigger book unless the last trade already reached them
+        if (order->isStopOrder()) {
+            if (inAuction_ || !lastTradePrice_ || !order->isTriggeredBy(*lastTradePrice_)) {
+                if (stopBook_.addStop(order)) {
+                    scheduleExpiry(order);
+                }
+                return trades;
+            }
+            order->trigger();
+            stats_.stopsTriggered++;
+        }
+
+        if (inAuction_) {
+            restInAuction(order);
+            return trades;
+        }
+
+        trades = executeOrder(order);
+        processTriggeredStops(trades);
         return trades;
     }
 
+    // Per trade, or all at once for a batched listener
+    void deliverTrades(const Order* order, const Trade* trades, size_t count) {
+        if constexpr (Listener::BATCHED) {
+            if (count > 0) {
+                listener_.onFills(order, trades, count);
+            }
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                listener_.onTrade(trades[i]);
+            }
+        }
+    }
+
+    static void prefetchObject(const void* address) {
+#if defined(__GNUC__)
+        __builtin_prefetch(address);
+#else
+        (void)address;
+#endif
+    }
+
     /**
-     * Match a market buy order (takes from ask side).
+     * Route a working (non-stop) order to its matcher.
      */
-    std::vector<Trade> matchMarketBuyOrder(std::shared_ptr<Order> order) {
+    std::vector<Trade> executeOrder(const std::shared_ptr<Order>& order) {
         std::vector<Trade> trades;
-        Quantity remaining = order->getRemainingQuantity();
-
-        // Get ask depth (sellers)
-        auto askDepth = orderBook_.getAskDepth(100); // Get up to 100 levels
 
-        for (const auto& level : askDepth) {
-            if (remaining == 0) break;
+        if (order->getPostOnly() != PostOnlyMode::NONE && !applyPostOnly(order)) {
+            return trades;
+        }
 
-            Price levelPrice = level.price;
-            
-            // Match against orders at this price level
-            while (remaining > 0) {
-                auto bestAsk = orderBook_.getBestAsk();
-                if (!bestAsk || *bestAsk != levelPrice) break;
+        if (order->getTimeInForce() == TimeInForce::FOK && !canFillCompletely(*order)) {
+            killOrder(order);
+            return trades;
+        }
 
-                // Get the best ask order
-                auto sellOrder = getBestAskOrder();
-                if (!sellOrder) break;
+        if (order->getType() == OrderType::MARKET) {
+            trades = matchOrder<OrderType::MARKET>(order);
+        } else if (order->getType() == OrderType::LIMIT) {
+            trades = matchOrder<OrderType::LIMIT>(order);
+        }
 
-                // Calculate fill quantity
-                Quantity fillQty = std::min(remaining, 
-                                           sellOrder->getRemainingQuantity());
+        if (!trades.empty()) {
+            lastTradePrice_ = trades.back().getPrice();
+        }
+        return trades;
+    }
 
-                // Create trade
-                Trade trade(order->getId(), sellOrder->getId(), 
-                          symbol_, levelPrice, fillQty);
-                trades.push_back(trade);
+    /**
+     * Run the stop cascade after a match. Each triggered stop executes in
+     * turn and its trades may trigger more, which queue behind it, so the
+     * whole cascade resolves in one deterministic FIFO pass.
+     */
+    void processTriggeredStops(std::vector<Trade>& trades) {
+        if (trades.empty()) return;
 
-                // Update orders
-                order->fillQuantity(fillQty);
-                sellOrder->fillQuantity(fillQty);
-                remaining -= fillQty;
+        // Every print counts, not just the last one of a sweep
+        auto [low, high] = printRange(trades.data(), trades.size());
+        if (!stopBook_.hasTriggered(low, high)) return;
 
-                // Update order book
-                if (sellOrder->getRemainingQuantity() == 0) {
-                    orderBook_.cancelOrder(sellOrder->getId());
-                }
+        stopBook_.collectTriggered(low, high, triggeredStops_);
+        while (!triggeredStops_.empty()) {
+            std::shared_ptr<Order> stop = std::move(triggeredStops_.front());
+            triggeredStops_.pop_front();
 
-                // Update stats
-                stats_.totalTrades++;
-                stats_.totalVolume += fillQty;
-                stats_.totalValue += trade.getValue();
+            stop->trigger();
+            stats_.stopsTriggered++;
 
-                // Notify callbacks
-                if (orderUpdateCallback_) {
-                    orderUpdateCallback_(sellOrder);
-                }
-            }
-        }
+            std::vector<Trade> stopTrades = executeOrder(stop);
+            if (stopTrades.empty()) continue;
 
-        // If order still has remaining quantity, it couldn't be fully filled
-        if (remaining > 0) {
-            LOG_WARN("Market buy order ", order->getId(), 
-                          " only partially filled. Remaining: ", remaining);
+            trades.insert(trades.end(), stopTrades.begin(), stopTrades.end());
+            std::tie(low, high) = printRange(stopTrades.data(), stopTrades.size());
+            stopBook_.collectTriggered(low, high, triggeredStops_);
         }
+    }
 
-        if (orderUpdateCallback_) {
-            orderUpdateCallback_(order);
+    // Lowest and highest price among count > 0 trades
+    static std::pair<Price, Price> printRange(const Trade* trades, size_t count) {
+        Price low = trades[0].getPrice();
+        Price high = low;
+        for (size_t i = 1; i < count; ++i) {
+            low = std::min(low, trades[i].getPrice());
+            high = std::max(high, trades[i].getPrice());
         }
-
-        return trades;
+        return {low, high};
     }
 
     /**
-     * Match a market sell order (takes from bid side).
+     * Post-only orders must not take liquidity: if the order would cross,
+     * reject it or reprice it one tick inside the opposite best.
+     * Returns false if the order was rejected.
      */
-    std::vector<Trade> matchMarketSellOrder(std::shared_ptr<Order> order) {
-        std::vector<Trade> trades;
-        Quantity remaining = order->getRemainingQuantity();
+    bool applyPostOnly(const std::shared_ptr<Order>& order) {
+        bool isBuy = order->getSide() == Side::BUY;
+        auto opposite = isBuy ? orderBook_.getBestAsk() : orderBook_.getBestBid();
+
+        if (order->getType() == OrderType::LIMIT) {
+            bool crosses = opposite && (isBuy ? order->getPrice() >= *opposite
+                                              : order->getPrice() <= *opposite);
+            if (!crosses) return true;
+
+            if (order->getPostOnly() == PostOnlyMode::REPRICE) {
+                Price inside = isBuy ? *opposite - 1 : *opposite + 1;
+                if (inside > 0) {
+                    order->amend(inside, order->getRemainingQuantity());
+                    return true;
+                }
+            }
+        }
 
-        // Get bid depth (buyers)
-        auto bidDepth = orderBook_.getBidDepth(100);
+        // Market orders always take liquidity
+        order->setStatus(OrderStatus::REJECTED);
+        stats_.postOnlyRejected++;
+        listener_.onOrderUpdate(order);
+        return false;
+    }
 
-        for (const auto& level : bidDepth) {
-            if (remaining == 0) break;
+    // Same owner on both sides, with a policy set on the incoming order
+    static bool isSelfTrade(const Order& incoming, const Order& resting) {
+        return incoming.getSelfTradePrevention() != SelfTradePrevention::NONE &&
+               incoming.getAccountId() != 0 &&
+               incoming.getAccountId() == resting.getAccountId();
+    }
 
-            Price levelPrice = level.price;
+    /**
+     * Apply the incoming order's self-trade policy against the resting
+     * order in hand. Only runs when accounts match, so the book lookups
+     * it does are off the normal fill path. Returns false when the
+     * incoming order has nothing left to match.
+     */
+    bool preventSelfTrade(const std::shared_ptr<Order>& order,
+                          const std::shared_ptr<Order>& resting) {
+        stats_.selfTradesPrevented++;
+
+        switch (order->getSelfTradePrevention()) {
+            case SelfTradePrevention::CANCEL_NEWEST:
+                order->cancel();
+                break;
+
+            case SelfTradePrevention::CANCEL_OLDEST:
+                orderBook_.cancelOrder(resting->getId());
+                listener_.onOrderUpdate(resting);
+                break;
+
+            case SelfTradePrevention::DECREMENT_BOTH: {
+                Quantity qty = std::min(order->getRemainingQuantity(),
+                                        resting->getRemainingQuantity());
+                if (qty == resting->getRemainingQuantity()) {
+                    orderBook_.cancelOrder(resting->getId());
+                } else {
+                    orderBook_.amendOrder(resting->getId(), resting->getPrice(),
+                                          resting->getRemainingQuantity() - qty);
+                }
+                if (qty == order->getRemainingQuantity()) {
+                    order->cancel();
+                } else {
+                    order->reduceQuantity(order->getRemainingQuantity() - qty);
+                }
+                listener_.onOrderUpdate(resting);
+                break;
+            }
 
-            while (remaining > 0) {
-                auto bestBid = orderBook_.getBestBid();
-                if (!bestBid || *bestBid != levelPrice) break;
+            case SelfTradePrevention::NONE:
+                break;
+        }
 
-                auto buyOrder = getBestBidOrder();
-                if (!buyOrder) break;
+        // Only a resting order that changed is reported; the incoming
+        // order's update comes from the match loop
+        return order->getRemainingQuantity() > 0;
+    }
 
-                Quantity fillQty = std::min(remaining, 
-                                           buyOrder->getRemainingQuantity());
+    // Auction call phase: rest limit orders unmatched, reject anything that must execute now
+    void restInAuction(const std::shared_ptr<Order>& order) {
+        TimeInForce tif = order->getTimeInForce();
+        if (order->getType() != OrderType::LIMIT ||
+            tif == TimeInForce::IOC || tif == TimeInForce::FOK) {
+            order->setStatus(OrderStatus::REJECTED);
+        } else if (orderBook_.addOrder(order)) {
+            scheduleExpiry(order);
+        }
 
-                Trade trade(buyOrder->getId(), order->getId(), 
-                          symbol_, levelPrice, fillQty);
-                trades.push_back(trade);
+        listener_.onOrderUpdate(order);
+    }
 
-                order->fillQuantity(fillQty);
-                buyOrder->fillQuantity(fillQty);
-                remaining -= fillQty;
+    // Pre-check for FOK: enough opposite liquidity within the limit, book untouched
+    bool canFillCompletely(const Order& order) const {
+        std::optional<Price> limit;
+        if (order.getType() == OrderType::LIMIT) {
+            limit = order.getPrice();
+        }
+        Quantity needed = order.getRemainingQuantity();
+        if (order.getSelfTradePrevention() == SelfTradePrevention::NONE ||
+            order.getAccountId() == 0) {
+            return orderBook_.getFillableQuantity(order.getSide(), limit, needed) >= needed;
+        }
 
-                if (buyOrder->getRemainingQuantity() == 0) {
-                    orderBook_.cancelOrder(buyOrder->getId());
-                }
+        // Own orders are not liquidity: CANCEL_OLDEST removes them, and the
+        // other policies cancel or shrink the order on reaching one
+        bool ownBlocks = order.getSelfTradePrevention() != SelfTradePrevention::CANCEL_OLDEST;
+        return orderBook_.getFillableQuantity(order.getSide(), limit, needed,
+                                              order.getAccountId(), ownBlocks) >= needed;
+    }
 
-                stats_.totalTrades++;
-                stats_.totalVolume += fillQty;
-                stats_.totalValue += trade.getValue();
+    // Cancel what an IOC/FOK order could not fill on arrival
+    void killOrder(const std::shared_ptr<Order>& order) {
+        order->cancel();
+        stats_.ordersKilled++;
+        listener_.onOrderUpdate(order);
+    }
 
-                if (orderUpdateCallback_) {
-                    orderUpdateCallback_(buyOrder);
-                }
-            }
+    void scheduleExpiry(const std::shared_ptr<Order>& order) {
+        TimeInForce tif = order->getTimeInForce();
+        if (tif == TimeInForce::DAY && order->getExpireTime() == 0 && sessionEnd_ != 0) {
+            order->setTimeInForce(TimeInForce::DAY, sessionEnd_);
         }
-
-        if (remaining > 0) {
-            LOG_WARN("Market sell order ", order->getId(), 
-                          " only partially filled. Remaining: ", remaining);
+        if ((tif == TimeInForce::DAY || tif == TimeInForce::GTD) && order->getExpireTime() != 0) {
+            expiryWheel_.schedule(order->getId(), order->getExpireTime());
         }
+    }
 
-        if (orderUpdateCallback_) {
-            orderUpdateCallback_(order);
+    /**
+     * Wheel entries are not removed on cancel/fill, so check the order is
+     * still live (and is the same order) before expiring it.
+     */
+    bool expireOrder(const ExpiryWheel::Entry& entry) {
+        std::shared_ptr<Order> order = orderBook_.getOrder(entry.orderId);
+        if (order && order->getExpireTime() == entry.expireTime) {
+            orderBook_.cancelOrder(entry.orderId);
+        } else {
+            order = stopBook_.removeStop(entry.orderId);
+            if (!order) return false;
+            order->cancel();
         }
 
-        return trades;
+        order->setStatus(OrderStatus::EXPIRED);
+        stats_.ordersExpired++;
+        listener_.onOrderUpdate(order);
+        return true;
     }
 
     /**
-     * Match a limit order against the book.
-     * Limit orders only execute at their limit price or better.
+     * Match a working order of type Type against the book, then settle
+     * its remainder: market orders never rest, limit orders rest unless
+     * IOC/FOK. The side is resolved once here so each of the four loops
+     * is compiled with its book side and price test fixed.
      */
-    std::vector<Trade> matchLimitOrder(std::shared_ptr<Order> order) {
+    template<OrderType Type>
+    std::vector<Trade> matchOrder(const std::shared_ptr<Order>& order) {
         std::vector<Trade> trades;
-
         if (order->getSide() == Side::BUY) {
-            trades = matchLimitBuyOrder(order);
+            sweepBook<Side::BUY, Type>(order, trades);
         } else {
-            trades = matchLimitSellOrder(order);
+            sweepBook<Side::SELL, Type>(order, trades);
         }
 
-        // Add remaining quantity to book if not fully filled
-        if (order->getRemainingQuantity() > 0) {
-            orderBook_.addOrder(order);
+        if constexpr (!MatchType<Type>::RESTS) {
+            // If order still has remaining quantity, it couldn't be fully filled
+            if (order->getRemainingQuantity() > 0) {
+                LOG_WARN("Market ", order->getSide() == Side::BUY ? "buy" : "sell", " order ", order->getId(),
+                         " only partially filled. Remaining: ", order->getRemainingQuantity());
+            }
         }
 
-        stats_.limitOrdersMatched++;
+        listener_.onOrderUpdate(order);
+
+        if constexpr (MatchType<Type>::RESTS) {
+            // Rest the remainder unless it must execute immediately
+            if (order->getRemainingQuantity() > 0) {
+                TimeInForce tif = order->getTimeInForce();
+                if (tif == TimeInForce::IOC || tif == TimeInForce::FOK) {
+                    killOrder(order);
+                } else if (orderBook_.addOrder(order)) {
+                    scheduleExpiry(order);
+                }
+            }
+        }
+
+        if constexpr (Type == OrderType::MARKET) {
+            stats_.marketOrdersMatched++;
+        } else {
+            stats_.limitOrdersMatched++;
+        }
         return trades;
     }
 
     /**
-     * Match a limit buy order.
+     * The match loop: take from the opposite best level while the order
+     * has quantity and, if it has a limit, the level is within it. Every
+     * trade is at the resting price.
      */
-    std::vector<Trade> matchLimitBuyOrder(std::shared_ptr<Order> order) {
-        std::vector<Trade> trades;
+    template<Side S, OrderType Type>
+    void sweepBook(const std::shared_ptr<Order>& order, std::vector<Trade>& trades) {
+        using Taker = MatchSide<S>;
         Quantity remaining = order->getRemainingQuantity();
-        Price limitPrice = order->getPrice();
+        const Price limitPrice = order->getPrice();
 
         while (remaining > 0) {
-            auto bestAsk = orderBook_.getBestAsk();
-            
-            // No more asks or price doesn't match
-            if (!bestAsk || *bestAsk > limitPrice) break;
+            std::optional<Price> best = orderBook_.getBest<Taker::MAKER>();
+            if (!best) break;
+            if constexpr (MatchType<Type>::HAS_LIMIT) {
+                if (!Taker::accepts(limitPrice, *best)) break;
+            }
 
-            auto sellOrder = getBestAskOrder();
-            if (!sellOrder) break;
+            std::shared_ptr<Order> resting = orderBook_.getBestOrder<Taker::MAKER>();
+            if (!resting) break;
 
-            Quantity fillQty = std::min(remaining, 
-                                       sellOrder->getRemainingQuantity());
-            Price tradePrice = *bestAsk; // Trade at ask price (better for buyer)
+            if (isSelfTrade(*order, *resting)) {
+                if (!preventSelfTrade(order, resting)) break;
+                remaining = order->getRemainingQuantity();
+                continue;
+            }
+
+            if constexpr (!AllocationPolicy::IS_FIFO) {
+                remaining = allocateLevel<S>(order, *best, trades);
+                continue;
+            }
 
-            Trade trade(order->getId(), sellOrder->getId(), 
-                      symbol_, tradePrice, fillQty);
+            Quantity fillQty = std::min(remaining, resting->getVisibleQuantity());
+            Trade trade = Taker::makeTrade(*order, *resting, symbol_, *best, fillQty);
             trades.push_back(trade);
 
             order->fillQuantity(fillQty);
-            sellOrder->fillQuantity(fillQty);
+            orderBook_.fillOrder(resting, fillQty);
             remaining -= fillQty;
 
-            if (sellOrder->getRemainingQuantity() == 0) {
-                orderBook_.cancelOrder(sellOrder->getId());
-            }
-
             stats_.totalTrades++;
             stats_.totalVolume += fillQty;
-            stats_.totalValue += trade.getValue();
+            stats_.totalValue += trade.getNotional();
 
-            if (orderUpdateCallback_) {
-                orderUpdateCallback_(sellOrder);
-            }
+            listener_.onOrderUpdate(resting);
         }
-
-        if (orderUpdateCallback_) {
-            orderUpdateCallback_(order);
-        }
-
-        return trades;
     }
 
     /**
-     * Match a limit sell order.
+     * Allocate the incoming order across the whole best level at once
+     * (non-FIFO policies). Returns the order's remaining quantity.
      */
-    std::vector<Trade> matchLimitSellOrder(std::shared_ptr<Order> order) {
-        std::vector<Trade> trades;
-        Quantity remaining = order->getRemainingQuantity();
-        Price limitPrice = order->getPrice();
-
-        while (remaining > 0) {
-            auto bestBid = orderBook_.getBestBid();
-            
-            // No more bids or price doesn't match
-            if (!bestBid || *bestBid < limitPrice) break;
-
-            auto buyOrder = getBestBidOrder();
-            if (!buyOrder) break;
+    template<Side S>
+    Quantity allocateLevel(const std::shared_ptr<Order>& order, Price price,
+                           std::vector<Trade>& trades) {
+        using Taker = MatchSide<S>;
+        const PriceLevel* level = orderBook_.getBestLevel<Taker::MAKER>();
+
+        // Self-trade policy first applies to every same-account order at the level
+        if (level && order->getSelfTradePrevention() != SelfTradePrevention::NONE &&
+            order->getAccountId() != 0) {
+            std::vector<std::shared_ptr<Order>> own;
+            level->forEachOrder([&](const std::shared_ptr<Order>& resting) {
+                if (isSelfTrade(*order, *resting)) own.push_back(resting);
+            });
+            for (const auto& resting : own) {
+                if (!preventSelfTrade(order, resting)) return 0;
+            }
+            if (!own.empty()) {
+                level = orderBook_.getBestLevel<Taker::MAKER>();
+                if (!level || level->getPrice() != price) {
+                    return order->getRemainingQuantity();
+                }
+            }
+        }
 
-            Quantity fillQty = std::min(remaining, 
-                                       buyOrder->getRemainingQuantity());
-            Price tradePrice = *bestBid; // Trade at bid price (better for seller)
+        if (!level) return order->getRemainingQuantity();
 
-            Trade trade(buyOrder->getId(), order->getId(), 
-                      symbol_, tradePrice, fillQty);
+        for (const auto& allocation : allocation_.allocate(*level, order->getRemainingQuantity())) {
+            const std::shared_ptr<Order>& resting = allocation.order;
+            Trade trade = Taker::makeTrade(*order, *resting, symbol_, price, allocation.quantity);
             trades.push_back(trade);
 
-            order->fillQuantity(fillQty);
-            buyOrder->fillQuantity(fillQty);
-            remaining -= fillQty;
-
-            if (buyOrder->getRemainingQuantity() == 0) {
-                orderBook_.cancelOrder(buyOrder->getId());
-            }
+            order->fillQuantity(allocation.quantity);
+            orderBook_.fillOrder(resting, allocation.quantity);
 
             stats_.totalTrades++;
-            stats_.totalVolume += fillQty;
-            stats_.totalValue += trade.getValue();
-
-            if (orderUpdateCallback_) {
-                orderUpdateCallback_(buyOrder);
-            }
-        }
+            stats_.totalVolume += allocation.quantity;
+            stats_.totalValue += trade.getNotional();
 
-        if (orderUpdateCallback_) {
-            orderUpdateCallback_(order);
+            listener_.onOrderUpdate(resting);
         }
-
-        return trades;
+        return order->getRemainingQuantity();
     }
 
-    // Helper to get best bid order (private access to order book internals)
+    // Front order of the best bid / ask level
     std::shared_ptr<Order> getBestBidOrder() {
-        auto bidDepth = orderBook_.getBidDepth(1);
-        if (bidDepth.empty()) return nullptr;
-        
-        // This is a simplified version - in reality, we'd need direct access
-        // For now, we'll work with the order book's public interface
-        // In a production system, we'd make MatchingEngine a friend class
-        return nullptr; // Placeholder - will be implemented with better access
+        return orderBook_.getBestBidOrder();
     }
 
     std::shared_ptr<Order> getBestAskOrder() {
-        auto askDepth = orderBook_.getAskDepth(1);
-        if (askDepth.empty()) return nullptr;
-        return nullptr; // Placeholder
+        return orderBook_.getBestAskOrder();
     }
 };
 
+// Price-time priority engine used throughout the system
+using MatchingEngine = BasicMatchingEngine<FifoAllocation>;
+
 } // namespace trading
 
 #endif // MATCHING_ENGINE_HPP
\ No newline at end of file
@@ -3,11 +3,20 @@
 
 #include "core/order.hpp"
 #include "engine/price_level.hpp"
+#include "engine/account_orders.hpp"
+#include "engine/order_index.hpp"
+#include "engine/top_of_book.hpp"
+#include "utils/memory_pool.hpp"
+#include "utils/seqlock.hpp"
+#include <algorithm>
+#include <iterator>
+#include <chrono>
+#include <functional>
 #include <map>
-#include <unordered_map>
 #include <memory>
 #include <optional>
 #include <sstream>
+#include <vector>
 
 namespace trading {
 
@@ -15,12 +24,46 @@ namespace trading {
  * OrderBook maintains bid and ask sides of the market.
  * Bids are sorted descending (highest price first)
  * Asks are sorted ascending (lowest price first)
+ *
+ * Each book owns a PoolResource for its level map nodes (which hold the
+ * price levels) and account table, so a symbol's nodes are packed
+ * together and its memory goes away in one piece with the book. Pass an
+ * arena to carve those chunks from pre-faulted memory.
  */
 class OrderBook {
 public:
-    explicit OrderBook(const Symbol& symbol)
+    explicit OrderBook(const Symbol& symbol, utils::MemoryArena* arena = nullptr)
         : symbol_(symbol)
-    {}
+        , memory_(arena)
+        , bids_(std::greater<Price>(), LevelAllocator(&memory_))
+        , asks_(std::less<Price>(), LevelAllocator(&memory_))
+        , accountOrders_(&memory_)
+    {
+        publish();
+    }
+
+    /**
+     * Defers snapshot publication until the outermost batch ends, so a
+     * multi-fill match publishes once instead of once per fill.
+     */
+    class PublishBatch {
+    public:
+        explicit PublishBatch(OrderBook& book) : book_(book) {
+            book_.batchDepth_++;
+        }
+
+        ~PublishBatch() {
+            if (--book_.batchDepth_ == 0) {
+                book_.publish();
+            }
+        }
+
+        PublishBatch(const PublishBatch&) = delete;
+        PublishBatch& operator=(const PublishBatch&) = delete;
+
+    private:
+        OrderBook& book_;
+    };
 
     // Add an order to the book
     bool addOrder(std::shared_ptr<Order> order) {
@@ -31,7 +74,7 @@ public:
         OrderId orderId = order->getId();
         
         // Check for duplicate order ID
-        if (orderMap_.find(orderId) != orderMap_.end()) {
+        if (orderIndex_.contains(orderId)) {
             return false;
         }
 
@@ -43,57 +86,127 @@ public:
         }
 
         // Store in order map for fast lookup
-        orderMap_[orderId] = order;
+        accountOrders_.add(*order);
+        orderIndex_.insert(orderId, std::move(order));
+        publishIfIdle();
         return true;
     }
 
     // Cancel an order
     bool cancelOrder(OrderId orderId) {
-        auto it = orderMap_.find(orderId);
-        if (it == orderMap_.end()) {
+        std::shared_ptr<Order>* order = orderIndex_.find(orderId);
+        if (!order) {
             return false;
         }
 
-        auto order = it->second;
-        order->cancel();
+        cancelResting(std::move(*order));
+        publishIfIdle();
+        return true;
+    }
+
+    /**
+     * Cancel every resting order of an account, optionally on one side
+     * only. Walks the account's own order lists, so the cost is
+     * proportional to the number of orders cancelled rather than the
+     * size of the book. Orders without an account are never matched.
+     * Returns the cancelled orders.
+     */
+    std::vector<std::shared_ptr<Order>> massCancel(AccountId accountId,
+                                                   std::optional<Side> side = std::nullopt) {
+        std::vector<Order*> targets;
+        if (!side || *side == Side::BUY) {
+            accountOrders_.collect(accountId, Side::BUY, targets);
+        }
+        if (!side || *side == Side::SELL) {
+            accountOrders_.collect(accountId, Side::SELL, targets);
+        }
+
+        std::vector<std::shared_ptr<Order>> cancelled;
+        cancelled.reserve(targets.size());
+
+        PublishBatch batch(*this);
+        for (Order* order : targets) {
+            cancelled.push_back(*orderIndex_.find(order->getId()));
+            cancelResting(cancelled.back());
+        }
+        return cancelled;
+    }
+
+    // Number of resting orders an account has in this book
+    size_t getAccountOrderCount(AccountId accountId) const {
+        return accountOrders_.count(accountId);
+    }
+
+    /**
+     * Execute a fill against a resting order.
+     * Keeps level and side totals in step; a fully filled order leaves
+     * the book (status FILLED, not CANCELLED). Fills are capped at the
+     * displayed quantity; an exhausted iceberg slice is replenished from
+     * its reserve and re-queued at the back of its level.
+     */
+    void fillOrder(const std::shared_ptr<Order>& order, Quantity qty) {
+        qty = std::min(qty, order->getVisibleQuantity());
+        if (qty == 0) return;
 
-        // Remove from price level
         Price price = order->getPrice();
         if (order->getSide() == Side::BUY) {
-            removeFromBidSide(orderId, price);
+            fillOnSide(bids_, bidTotals_, order, price, qty);
         } else {
-            removeFromAskSide(orderId, price);
+            fillOnSide(asks_, askTotals_, order, price, qty);
         }
 
-        // Remove from order map
-        orderMap_.erase(it);
-        return true;
+        if (order->getRemainingQuantity() == 0) {
+            accountOrders_.remove(*order);
+            orderIndex_.erase(order->getId());
+        }
+        publishIfIdle();
     }
 
-    // Modify an order (cancel and replace)
-    bool modifyOrder(OrderId orderId, Price newPrice, Quantity newQuantity) {
-        auto it = orderMap_.find(orderId);
-        if (it == orderMap_.end()) {
+    /**
+     * Amend price and/or open quantity of a resting order.
+     * A size reduction at the same price is applied in place and keeps
+     * queue priority; a price change or size increase moves the same
+     * Order object to the back of its (new) level. Does not match, so
+     * callers must not amend across the opposite side.
+     */
+    bool amendOrder(OrderId orderId, Price newPrice, Quantity newQuantity) {
+        const std::shared_ptr<Order>* entry = orderIndex_.find(orderId);
+        if (!entry || newQuantity == 0) {
             return false;
         }
 
-        auto oldOrder = it->second;
-        
-        // Create new order with same ID but new price/quantity
-        auto newOrder = std::make_shared<Order>(
-            orderId,
-            oldOrder->getSymbol(),
-            oldOrder->getSide(),
-            oldOrder->getType(),
-            newPrice,
-            newQuantity
-        );
-
-        // Cancel old order
-        cancelOrder(orderId);
-        
-        // Add new order
-        return addOrder(newOrder);
+        const std::shared_ptr<Order>& order = *entry;
+        Price price = order->getPrice();
+        Quantity remaining = order->getRemainingQuantity();
+
+        if (newPrice == price && newQuantity <= remaining) {
+            if (order->getSide() == Side::BUY) {
+                reduceOnSide(bids_, bidTotals_, *order, price, remaining - newQuantity);
+            } else {
+                reduceOnSide(asks_, askTotals_, *order, price, remaining - newQuantity);
+            }
+            publishIfIdle();
+            return true;
+        }
+
+        // Readers must never see the order missing between remove and re-add
+        PublishBatch batch(*this);
+
+        if (order->getSide() == Side::BUY) {
+            removeFromSide(bids_, bidTotals_, *order, price);
+            order->amend(newPrice, newQuantity);
+            addToBidSide(order);
+        } else {
+            removeFromSide(asks_, askTotals_, *order, price);
+            order->amend(newPrice, newQuantity);
+            addToAskSide(order);
+        }
+        return true;
+    }
+
+    // Modify an order (see amendOrder)
+    bool modifyOrder(OrderId orderId, Price newPrice, Quantity newQuantity) {
+        return amendOrder(orderId, newPrice, newQuantity);
     }
 
     // Get best bid price
@@ -134,28 +247,198 @@ public:
         return std::nullopt;
     }
 
+    const Symbol& getSymbol() const { return symbol_; }
+
     // Get order by ID
     std::shared_ptr<Order> getOrder(OrderId orderId) const {
-        auto it = orderMap_.find(orderId);
-        return (it != orderMap_.end()) ? it->second : nullptr;
+        const std::shared_ptr<Order>* order = orderIndex_.find(orderId);
+        return order ? *order : nullptr;
     }
 
-    // Get total bid quantity
+    // Get total bid quantity (maintained incrementally, O(1))
     Quantity getTotalBidQuantity() const {
-        Quantity total = 0;
-        for (const auto& [price, level] : bids_) {
-            total += level.getTotalQuantity();
-        }
-        return total;
+        return bidTotals_.quantity;
     }
 
-    // Get total ask quantity
+    // Get total ask quantity (maintained incrementally, O(1))
     Quantity getTotalAskQuantity() const {
-        Quantity total = 0;
-        for (const auto& [price, level] : asks_) {
-            total += level.getTotalQuantity();
+        return askTotals_.quantity;
+    }
+
+    /**
+     * Quantity an incoming order could take on arrival from the opposite
+     * side, at limitPrice or better (any price if none). Uses level totals
+     * only and stops once `needed` is reached, so a fill-or-kill check
+     * visits just the levels it would trade against.
+     */
+    Quantity getFillableQuantity(Side takerSide, std::optional<Price> limitPrice,
+                                 Quantity needed) const {
+        auto total = [](const PriceLevel& level) -> std::optional<Quantity> {
+            return level.getTotalQuantity();
+        };
+        return sumFillable(takerSide, limitPrice, needed, total);
+    }
+
+    /**
+     * getFillableQuantity for a taker whose self-trade prevention applies
+     * to `accountId`'s resting orders. Those are never counted. If
+     * ownBlocks (the policy cancels or shrinks the taker), reaching a
+     * level that holds one ends the count, as the taker could not fill
+     * past it. This walks the orders of each level it visits.
+     */
+    Quantity getFillableQuantity(Side takerSide, std::optional<Price> limitPrice,
+                                 Quantity needed, AccountId accountId, bool ownBlocks) const {
+        auto others = [&](const PriceLevel& level) -> std::optional<Quantity> {
+            Quantity quantity = 0;
+            bool own = false;
+            level.forEachOrder([&](const std::shared_ptr<Order>& order) {
+                if (order->getAccountId() == accountId) {
+                    own = true;
+                } else {
+                    quantity += order->getRemainingQuantity();
+                }
+            });
+            if (own && ownBlocks) return std::nullopt;
+            return quantity;
+        };
+        return sumFillable(takerSide, limitPrice, needed, others);
+    }
+
+    // Equilibrium of a crossed book (call auction)
+    struct UncrossResult {
+        bool crossed;          // False if the book does not cross
+        Price price;           // Equilibrium price
+        Quantity volume;       // Executable volume at price
+        Quantity buySurplus;   // Demand left unfilled at price
+        Quantity sellSurplus;  // Supply left unfilled at price
+    };
+
+    /**
+     * Find the auction uncross price in one ascending pass over the level
+     * prices of the crossed range, using cumulative demand (bids at or
+     * above p) and supply (asks at or below p). Hidden iceberg quantity
+     * counts. Tie-breaks, in order:
+     *   1. maximum executable volume
+     *   2. minimum surplus
+     *   3. market pressure: highest price if every tie has buy surplus,
+     *      lowest if every tie has sell surplus
+     *   4. closest to referencePrice (else the lowest tied price)
+     */
+    UncrossResult computeUncross(std::optional<Price> referencePrice = std::nullopt) const {
+        UncrossResult result{false, 0, 0, 0, 0};
+        if (bids_.empty() || asks_.empty()) return result;
+
+        Price bestBid = bids_.begin()->first;
+        Price bestAsk = asks_.begin()->first;
+        if (bestBid < bestAsk) return result;
+
+        // Demand at the lowest candidate: every bid at or above bestAsk
+        Quantity demand = 0;
+        auto bidsEnd = bids_.upper_bound(bestAsk);  // First bid below bestAsk
+        for (auto it = bids_.begin(); it != bidsEnd; ++it) {
+            demand += it->second.getTotalQuantity();
+        }
+
+        // Bids ascending from bestAsk, asks ascending up to bestBid
+        auto bidIt = std::make_reverse_iterator(bidsEnd);
+        auto bidRend = bids_.rend();
+        auto askIt = asks_.begin();
+        auto asksEnd = asks_.upper_bound(bestBid);
+
+        Quantity supply = 0;
+        Quantity bestVolume = 0;
+        Quantity bestSurplus = 0;
+        Price lowestTie = 0;
+        Price highestTie = 0;
+        bool allBuySurplus = true;
+        bool allSellSurplus = true;
+        bool found = false;
+
+        while (bidIt != bidRend || askIt != asksEnd) {
+            Price price = (askIt == asksEnd) ? bidIt->first
+                        : (bidIt == bidRend) ? askIt->first
+                        : std::min(bidIt->first, askIt->first);
+
+            // Supply includes asks at this price; demand still includes bids here
+            if (askIt != asksEnd && askIt->first == price) {
+                supply += askIt->second.getTotalQuantity();
+                ++askIt;
+            }
+
+            Quantity volume = std::min(demand, supply);
+            Quantity surplus = demand > supply ? demand - supply : supply - demand;
+
+            if (!found || volume > bestVolume ||
+                (volume == bestVolume && surplus < bestSurplus)) {
+                found = true;
+                bestVolume = volume;
+                bestSurplus = surplus;
+                lowestTie = highestTie = price;
+                allBuySurplus = demand > supply;
+                allSellSurplus = supply > demand;
+            } else if (volume == bestVolume && surplus == bestSurplus) {
+                highestTie = price;
+                allBuySurplus = allBuySurplus && demand > supply;
+                allSellSurplus = allSellSurplus && supply > demand;
+            }
+
+            // Bids at this price drop out of demand for higher prices
+            if (bidIt != bidRend && bidIt->first == price) {
+                demand -= bidIt->second.getTotalQuantity();
+                ++bidIt;
+            }
+        }
+
+        if (bestVolume == 0) return result;
+
+        Price price = lowestTie;
+        if (allBuySurplus) {
+            price = highestTie;
+        } else if (!allSellSurplus && referencePrice) {
+            price = std::min(std::max(*referencePrice, lowestTie), highestTie);
+        }
+
+        Quantity demandAtPrice = 0;
+        Quantity supplyAtPrice = 0;
+        for (const auto& [bidPrice, level] : bids_) {
+            if (bidPrice < price) break;
+            demandAtPrice += level.getTotalQuantity();
+        }
+        for (const auto& [askPrice, level] : asks_) {
+            if (askPrice > price) break;
+            supplyAtPrice += level.getTotalQuantity();
+        }
+
+        result.crossed = true;
+        result.price = price;
+        result.volume = bestVolume;
+        result.buySurplus = demandAtPrice - bestVolume;
+        result.sellSurplus = supplyAtPrice - bestVolume;
+        return result;
+    }
+
+    // Best levels, or nullptr if the side is empty
+    const PriceLevel* getBestBidLevel() const {
+        return bids_.empty() ? nullptr : &bids_.begin()->second;
+    }
+
+    const PriceLevel* getBestAskLevel() const {
+        return asks_.empty() ? nullptr : &asks_.begin()->second;
+    }
+
+    /**
+     * Warm the cache for an order about to be processed: its slot in the
+     * id index and the front of the opposite best level it would meet.
+     */
+    void prefetchFor(const Order& incoming) const {
+        orderIndex_.prefetch(incoming.getId());
+#if defined(__GNUC__)
+        const PriceLevel* level = incoming.getSide() == Side::BUY ? getBestAskLevel()
+                                                                  : getBestBidLevel();
+        if (level && level->peekFrontOrder()) {
+            __builtin_prefetch(level->peekFrontOrder());
         }
-        return total;
+#endif
     }
 
     // Get the front order from best bid
@@ -172,6 +455,37 @@ public:
         return level.getFrontOrder();
     }
 
+    /**
+     * The same accessors with the book side fixed at compile time, for
+     * the matching loops: BUY is the bid side, SELL the ask side.
+     */
+    template<Side S>
+    std::optional<Price> getBest() const {
+        if constexpr (S == Side::BUY) {
+            return getBestBid();
+        } else {
+            return getBestAsk();
+        }
+    }
+
+    template<Side S>
+    const PriceLevel* getBestLevel() const {
+        if constexpr (S == Side::BUY) {
+            return getBestBidLevel();
+        } else {
+            return getBestAskLevel();
+        }
+    }
+
+    template<Side S>
+    std::shared_ptr<Order> getBestOrder() {
+        if constexpr (S == Side::BUY) {
+            return getBestBidOrder();
+        } else {
+            return getBestAskOrder();
+        }
+    }
+
     // Get market depth (top N levels on each side)
     struct DepthLevel {
         Price price;
@@ -179,13 +493,14 @@ public:
         size_t orderCount;
     };
 
+    // Depth reports displayed quantity only; iceberg reserves stay hidden
     std::vector<DepthLevel> getBidDepth(size_t levels = 5) const {
         std::vector<DepthLevel> depth;
         size_t count = 0;
         
         for (const auto& [price, level] : bids_) {
             if (count >= levels) break;
-            depth.push_back({price, level.getTotalQuantity(), level.getOrderCount()});
+            depth.push_back({price, level.getDisplayedQuantity(), level.getOrderCount()});
             count++;
         }
         return depth;
@@ -197,7 +512,7 @@ public:
         
         for (const auto& [price, level] : asks_) {
             if (count >= levels) break;
-            depth.push_back({price, level.getTotalQuantity(), level.getOrderCount()});
+            depth.push_back({price, level.getDisplayedQuantity(), level.getOrderCount()});
             count++;
         }
         return depth;
@@ -247,73 +562,243 @@ public:
         size_t askLevels;
         Quantity totalBidQty;
         Quantity totalAskQty;
+        size_t bidOrders;
+        size_t askOrders;
+        int64_t bidNotional;    // Sum of price * quantity, in price units
+        int64_t askNotional;
+        Quantity hiddenBidQty;  // Iceberg reserves included in totalBidQty
+        Quantity hiddenAskQty;
     };
 
+    // O(1) from the running totals. Owning (matching) thread only.
     BookStats getStats() const {
         return {
-            orderMap_.size(),
-            bids_.size(),
-            asks_.size(),
-            getTotalBidQuantity(),
-            getTotalAskQuantity()
+            bidTotals_.orderCount + askTotals_.orderCount,
+            bidTotals_.levelCount,
+            askTotals_.levelCount,
+            bidTotals_.quantity,
+            askTotals_.quantity,
+            bidTotals_.orderCount,
+            askTotals_.orderCount,
+            bidTotals_.notional,
+            askTotals_.notional,
+            bidTotals_.hiddenQuantity,
+            askTotals_.hiddenQuantity
         };
     }
 
+    // Consistent snapshot, safe to call from any thread without locking
+    BookStats getStatsSnapshot() const {
+        return publishedStats_.load();
+    }
+
+    // Best levels as of the last mutation, safe to call from any thread
+    TopOfBook getTopOfBook() const {
+        return publishedTop_.load();
+    }
+
+    // The book's node pools (owning thread only)
+    utils::PoolResource::Stats getMemoryStats() const {
+        return memory_.getStats();
+    }
+
 private:
+    // Running per-side aggregates, updated on every add/cancel/fill
+    struct SideTotals {
+        Quantity quantity = 0;
+        size_t orderCount = 0;
+        size_t levelCount = 0;
+        int64_t notional = 0;
+        Quantity hiddenQuantity = 0;  // Iceberg reserves, included in quantity
+    };
+
+    using LevelAllocator = utils::PoolAllocator<std::pair<const Price, PriceLevel>>;
+
+    template<typename Compare>
+    using LevelMap = std::map<Price, PriceLevel, Compare, LevelAllocator>;
+
     Symbol symbol_;
+
+    // Node memory for the containers below; declared first so it outlives them
+    utils::PoolResource memory_;
     
     // Bids: descending order (highest price first)
-    std::map<Price, PriceLevel, std::greater<Price>> bids_;
+    LevelMap<std::greater<Price>> bids_;
     
     // Asks: ascending order (lowest price first)
-    std::map<Price, PriceLevel, std::less<Price>> asks_;
+    LevelMap<std::less<Price>> asks_;
     
-    // Fast order lookup
-    std::unordered_map<OrderId, std::shared_ptr<Order>> orderMap_;
+    // Fast order lookup (flat, no per-order allocation)
+    OrderIndex orderIndex_;
 
-    void addToBidSide(std::shared_ptr<Order> order) {
+    // Resting orders per account and side, for mass cancel
+    AccountOrders accountOrders_;
+
+    SideTotals bidTotals_;
+    SideTotals askTotals_;
+
+    // Cross-thread views, republished after each mutation (or batch)
+    utils::SeqLock<BookStats> publishedStats_;
+    utils::SeqLock<TopOfBook> publishedTop_;
+    int batchDepth_ = 0;
+
+    void cancelResting(std::shared_ptr<Order> order) {
+        orderIndex_.erase(order->getId());
+        accountOrders_.remove(*order);
+
+        // Remove from price level (while remaining quantity is still known)
         Price price = order->getPrice();
-        
-        auto it = bids_.find(price);
-        if (it == bids_.end()) {
-            bids_.emplace(price, PriceLevel(price));
-            it = bids_.find(price);
+        if (order->getSide() == Side::BUY) {
+            removeFromSide(bids_, bidTotals_, *order, price);
+        } else {
+            removeFromSide(asks_, askTotals_, *order, price);
         }
-        
-        it->second.addOrder(order);
+
+        order->cancel();
+    }
+
+    void addToBidSide(std::shared_ptr<Order> order) {
+        addToSide(bids_, bidTotals_, std::move(order));
     }
 
     void addToAskSide(std::shared_ptr<Order> order) {
+        addToSide(asks_, askTotals_, std::move(order));
+    }
+
+    template<typename Levels>
+    void addToSide(Levels& levels, SideTotals& totals, std::shared_ptr<Order> order) {
         Price price = order->getPrice();
-        
-        auto it = asks_.find(price);
-        if (it == asks_.end()) {
-            asks_.emplace(price, PriceLevel(price));
-            it = asks_.find(price);
+        Quantity qty = order->getRemainingQuantity();
+
+        // An iceberg that traded on arrival rests with a full slice
+        order->resetDisplay();
+        totals.hiddenQuantity += order->getHiddenQuantity();
+
+        auto it = levels.find(price);
+        if (it == levels.end()) {
+            it = levels.emplace(price, PriceLevel(price)).first;
+            totals.levelCount++;
         }
-        
-        it->second.addOrder(order);
+
+        it->second.addOrder(std::move(order));
+
+        totals.quantity += qty;
+        totals.orderCount++;
+        totals.notional += price * static_cast<int64_t>(qty);
     }
 
-    void removeFromBidSide(OrderId orderId, Price price) {
-        auto it = bids_.find(price);
-        if (it != bids_.end()) {
-            it->second.removeOrder(orderId);
-            if (it->second.isEmpty()) {
-                bids_.erase(it);
-            }
+    template<typename Levels>
+    void removeFromSide(Levels& levels, SideTotals& totals, Order& order, Price price) {
+        auto it = levels.find(price);
+        if (it == levels.end()) return;
+
+        it->second.removeOrder(order);
+
+        Quantity qty = order.getRemainingQuantity();
+        totals.quantity -= qty;
+        totals.hiddenQuantity -= order.getHiddenQuantity();
+        totals.orderCount--;
+        totals.notional -= price * static_cast<int64_t>(qty);
+
+        if (it->second.isEmpty()) {
+            levels.erase(it);
+            totals.levelCount--;
         }
     }
 
-    void removeFromAskSide(OrderId orderId, Price price) {
-        auto it = asks_.find(price);
-        if (it != asks_.end()) {
-            it->second.removeOrder(orderId);
+    template<typename Levels>
+    void reduceOnSide(Levels& levels, SideTotals& totals, Order& order,
+                      Price price, Quantity qty) {
+        auto it = levels.find(price);
+        if (it == levels.end() || qty == 0) return;
+
+        Quantity visibleBefore = order.getVisibleQuantity();
+        Quantity hiddenBefore = order.getHiddenQuantity();
+        order.reduceQuantity(order.getRemainingQuantity() - qty);
+        it->second.reduceQuantity(visibleBefore - order.getVisibleQuantity(),
+                                  hiddenBefore - order.getHiddenQuantity());
+        totals.hiddenQuantity -= hiddenBefore - order.getHiddenQuantity();
+
+        totals.quantity -= qty;
+        totals.notional -= price * static_cast<int64_t>(qty);
+    }
+
+    template<typename Levels>
+    void fillOnSide(Levels& levels, SideTotals& totals,
+                    const std::shared_ptr<Order>& order, Price price, Quantity qty) {
+        auto it = levels.find(price);
+        if (it == levels.end()) return;
+
+        order->fillQuantity(qty);
+        totals.hiddenQuantity -= it->second.updateQuantity(*order, qty);
+
+        totals.quantity -= qty;
+        totals.notional -= price * static_cast<int64_t>(qty);
+
+        if (order->getRemainingQuantity() == 0) {
+            totals.orderCount--;
             if (it->second.isEmpty()) {
-                asks_.erase(it);
+                levels.erase(it);
+                totals.levelCount--;
             }
         }
     }
+
+    template<typename LevelQuantity>
+    Quantity sumFillable(Side takerSide, std::optional<Price> limitPrice, Quantity needed,
+                         LevelQuantity levelQuantity) const {
+        if (takerSide == Side::BUY) {
+            return sumLevels(asks_, needed, levelQuantity, [&](Price price) {
+                return !limitPrice || price <= *limitPrice;
+            });
+        }
+        return sumLevels(bids_, needed, levelQuantity, [&](Price price) {
+            return !limitPrice || price >= *limitPrice;
+        });
+    }
+
+    // levelQuantity returns nullopt when the taker cannot get past a level
+    template<typename Levels, typename LevelQuantity, typename Marketable>
+    static Quantity sumLevels(const Levels& levels, Quantity needed,
+                              LevelQuantity& levelQuantity, Marketable marketable) {
+        Quantity available = 0;
+        for (const auto& [price, level] : levels) {
+            if (available >= needed || !marketable(price)) break;
+            std::optional<Quantity> quantity = levelQuantity(level);
+            if (!quantity) break;
+            available += *quantity;
+        }
+        return available;
+    }
+
+    void publishIfIdle() {
+        if (batchDepth_ == 0) {
+            publish();
+        }
+    }
+
+    void publish() {
+        publishedStats_.store(getStats());
+
+        TopOfBook top{};
+        top.updateTime = static_cast<Timestamp>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::high_resolution_clock::now().time_since_epoch()
+            ).count());
+        top.bidLevels = copyTopLevels(bids_, top.bids);
+        top.askLevels = copyTopLevels(asks_, top.asks);
+        publishedTop_.store(top);
+    }
+
+    template<typename Levels>
+    static uint32_t copyTopLevels(const Levels& levels, TopOfBook::Level* out) {
+        uint32_t count = 0;
+        for (const auto& [price, level] : levels) {
+            if (count == TopOfBook::MAX_DEPTH) break;
+            out[count++] = {price, level.getDisplayedQuantity(), level.getOrderCount()};
+        }
+        return count;
+    }
 };
 
 } // namespace trading
@@ -0,0 +1,194 @@
+#ifndef ORDER_INDEX_HPP
+#define ORDER_INDEX_HPP
+
+#include "core/order.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace trading {
+
+/**
+ * OrderIndex - flat open-addressing map from order id to order.
+ *
+ * Keys live in their own array so a probe walks consecutive 8-byte
+ * slots; values sit in a parallel array touched only on a hit. Order
+ * ids are mostly sequential, so they land in adjacent home slots and
+ * lookups in arrival order stream through memory.
+ *
+ * Linear probing with Robin Hood placement (an entry further from its
+ * home slot takes the place of one closer to home) bounds probe length.
+ * It also lets misses and deletes stop early: deletion shifts the rest
+ * of the cluster back by one until an entry sits at its home slot, so
+ * there are no tombstones and lookups do not degrade with churn. No
+ * memory is allocated or freed per order, only when the table grows.
+ */
+class OrderIndex {
+public:
+    static constexpr OrderId EMPTY = std::numeric_limits<OrderId>::max();
+
+    explicit OrderIndex(size_t initialCapacity = 1024) {
+        size_t capacity = 16;
+        while (capacity < initialCapacity) capacity <<= 1;
+        allocate(capacity);
+    }
+
+    // Returns nullptr if the id is not present
+    std::shared_ptr<Order>* find(OrderId orderId) {
+        size_t slot = findSlot(orderId);
+        return slot == NOT_FOUND ? nullptr : &values_[slot];
+    }
+
+    const std::shared_ptr<Order>* find(OrderId orderId) const {
+        size_t slot = findSlot(orderId);
+        return slot == NOT_FOUND ? nullptr : &values_[slot];
+    }
+
+    bool contains(OrderId orderId) const {
+        return findSlot(orderId) != NOT_FOUND;
+    }
+
+    // Returns false on a duplicate id (or the reserved EMPTY id)
+    bool insert(OrderId orderId, std::shared_ptr<Order> order) {
+        if (orderId == EMPTY) return false;
+
+        // Grow at 70% load to keep probe sequences short
+        if ((size_ + 1) * 10 > keys_.size() * 7) {
+            rehash(keys_.size() * 2);
+        }
+
+        if (!place(orderId, std::move(order), true)) return false;
+        size_++;
+        return true;
+    }
+
+    bool erase(OrderId orderId) {
+        size_t hole = findSlot(orderId);
+        if (hole == NOT_FOUND) return false;
+
+        // Backward shift: pull the cluster back one slot until an entry
+        // is already at its home slot (or the cluster ends)
+        for (size_t next = (hole + 1) & mask_;
+             keys_[next] != EMPTY && distance(next) != 0;
+             next = (next + 1) & mask_) {
+            keys_[hole] = keys_[next];
+            values_[hole] = std::move(values_[next]);
+            hole = next;
+        }
+
+        keys_[hole] = EMPTY;
+        values_[hole].reset();
+        size_--;
+        return true;
+    }
+
+    // Hint the cache ahead of a lookup (e.g. while decoding the next message)
+    void prefetch(OrderId orderId) const {
+#if defined(__GNUC__)
+        size_t slot = homeSlot(orderId);
+        __builtin_prefetch(&keys_[slot]);
+        __builtin_prefetch(&values_[slot]);
+#else
+        (void)orderId;
+#endif
+    }
+
+    template<typename Visitor>
+    void forEach(Visitor&& visit) const {
+        for (size_t slot = 0; slot < keys_.size(); ++slot) {
+            if (keys_[slot] != EMPTY) visit(keys_[slot], values_[slot]);
+        }
+    }
+
+    void clear() {
+        std::fill(keys_.begin(), keys_.end(), EMPTY);
+        for (auto& value : values_) value.reset();
+        size_ = 0;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t capacity() const { return keys_.size(); }
+
+private:
+    static constexpr size_t NOT_FOUND = std::numeric_limits<size_t>::max();
+
+    std::vector<OrderId> keys_;
+    std::vector<std::shared_ptr<Order>> values_;
+    size_t mask_ = 0;
+    unsigned bits_ = 0;  // log2(capacity)
+    size_t size_ = 0;
+
+    size_t homeSlot(OrderId orderId) const {
+        // Keep consecutive ids in consecutive slots, folding the high bits
+        // in so ids a multiple of the capacity apart do not collide
+        return static_cast<size_t>(orderId ^ (orderId >> bits_)) & mask_;
+    }
+
+    // Probe length of the entry in an occupied slot
+    size_t distance(size_t slot) const {
+        return (slot - homeSlot(keys_[slot])) & mask_;
+    }
+
+    size_t findSlot(OrderId orderId) const {
+        if (orderId == EMPTY) return NOT_FOUND;
+        size_t slot = homeSlot(orderId);
+        for (size_t dist = 0;; ++dist, slot = (slot + 1) & mask_) {
+            if (keys_[slot] == orderId) return slot;
+            // Robin Hood: the id would have displaced anything closer to home
+            if (keys_[slot] == EMPTY || distance(slot) < dist) return NOT_FOUND;
+        }
+    }
+
+    // Robin Hood insert; the caller has made room
+    bool place(OrderId orderId, std::shared_ptr<Order> order, bool checkDuplicate) {
+        size_t slot = homeSlot(orderId);
+        for (size_t dist = 0;; ++dist, slot = (slot + 1) & mask_) {
+            if (keys_[slot] == EMPTY) {
+                keys_[slot] = orderId;
+                values_[slot] = std::move(order);
+                return true;
+            }
+
+            // A duplicate is always met before the first displacement
+            if (checkDuplicate && keys_[slot] == orderId) return false;
+
+            size_t residentDist = distance(slot);
+            if (residentDist < dist) {
+                std::swap(orderId, keys_[slot]);
+                std::swap(order, values_[slot]);
+                dist = residentDist;
+                checkDuplicate = false;
+            }
+        }
+    }
+
+    void allocate(size_t capacity) {
+        keys_.assign(capacity, EMPTY);
+        values_.clear();
+        values_.resize(capacity);
+        mask_ = capacity - 1;
+        bits_ = 0;
+        for (size_t c = capacity; c > 1; c >>= 1) bits_++;
+    }
+
+    void rehash(size_t capacity) {
+        std::vector<OrderId> oldKeys = std::move(keys_);
+        std::vector<std::shared_ptr<Order>> oldValues = std::move(values_);
+        allocate(capacity);
+
+        for (size_t i = 0; i < oldKeys.size(); ++i) {
+            if (oldKeys[i] != EMPTY) {
+                place(oldKeys[i], std::move(oldValues[i]), false);
+            }
+        }
+    }
+};
+
+} // namespace trading
+
+#endif // ORDER_INDEX_HPP
@@ -2,79 +2,146 @@
 #define PRICE_LEVEL_HPP
 
 #include "core/order.hpp"
-#include <deque>
 #include <memory>
-#include <algorithm>
 #include <stdexcept>
+#include <string>
+#include <utility>
 
 namespace trading {
 
 /**
  * PriceLevel manages all orders at a specific price point.
  * Orders are maintained in FIFO (First In, First Out) order.
+ * Quantity is tracked as displayed (visible slices) and hidden
+ * (iceberg reserves); only the displayed part is market data.
+ *
+ * The queue is an intrusive list through the orders themselves: the
+ * level owns its front order and each order owns the next, so adding,
+ * removing a known order and re-queueing an iceberg are all O(1)
+ * with no allocation.
  */
 class PriceLevel {
 public:
     explicit PriceLevel(Price price) 
         : price_(price)
-        , totalQuantity_(0)
+        , displayedQuantity_(0)
+        , hiddenQuantity_(0)
+        , tail_(nullptr)
+        , orderCount_(0)
     {}
 
+    PriceLevel(PriceLevel&& other) noexcept
+        : price_(other.price_)
+        , displayedQuantity_(other.displayedQuantity_)
+        , hiddenQuantity_(other.hiddenQuantity_)
+        , head_(std::move(other.head_))
+        , tail_(std::exchange(other.tail_, nullptr))
+        , orderCount_(std::exchange(other.orderCount_, 0))
+    {}
+
+    PriceLevel(const PriceLevel&) = delete;
+    PriceLevel& operator=(const PriceLevel&) = delete;
+    PriceLevel& operator=(PriceLevel&&) = delete;
+
+    // Unlink iteratively; releasing the chain recursively could overflow the stack
+    ~PriceLevel() {
+        while (head_) {
+            head_->links_.levelPrev = nullptr;
+            head_ = std::move(head_->links_.levelNext);
+        }
+    }
+
     // Add an order to this price level
     void addOrder(std::shared_ptr<Order> order) {
         if (order->getPrice() != price_) {
             throw std::runtime_error("Order price doesn't match price level");
         }
         
-        orders_.push_back(order);
-        totalQuantity_ += order->getRemainingQuantity();
+        displayedQuantity_ += order->getVisibleQuantity();
+        hiddenQuantity_ += order->getHiddenQuantity();
+        linkBack(std::move(order));
+    }
+
+    // Remove an order queued at this level, O(1)
+    void removeOrder(Order& order) {
+        displayedQuantity_ -= order.getVisibleQuantity();
+        hiddenQuantity_ -= order.getHiddenQuantity();
+        unlink(order);
     }
 
-    // Remove an order by ID
+    // Remove an order by ID (walks the queue)
     bool removeOrder(OrderId orderId) {
-        auto it = std::find_if(orders_.begin(), orders_.end(),
-            [orderId](const std::shared_ptr<Order>& order) {
-                return order->getId() == orderId;
-            });
-
-        if (it != orders_.end()) {
-            totalQuantity_ -= (*it)->getRemainingQuantity();
-            orders_.erase(it);
-            return true;
+        for (Order* order = head_.get(); order; order = order->links_.levelNext.get()) {
+            if (order->getId() == orderId) {
+                removeOrder(*order);
+                return true;
+            }
         }
         return false;
     }
 
-    // Update quantity after a fill
-    void updateQuantity(OrderId orderId, Quantity filledQty) {
-        auto it = std::find_if(orders_.begin(), orders_.end(),
-            [orderId](const std::shared_ptr<Order>& order) {
-                return order->getId() == orderId;
-            });
-
-        if (it != orders_.end()) {
-            totalQuantity_ -= filledQty;
-            
-            // Remove order if fully filled
-            if ((*it)->getRemainingQuantity() == 0) {
-                orders_.erase(it);
-            }
+    /**
+     * Update quantity after a fill of a queued order's displayed slice.
+     * An iceberg whose slice is exhausted is replenished from its reserve
+     * and moved to the back of the queue (same Order, no allocation).
+     * Returns the quantity moved from hidden to displayed.
+     */
+    Quantity updateQuantity(Order& order, Quantity filledQty) {
+        displayedQuantity_ -= filledQty;
+        
+        // Remove order if fully filled
+        if (order.getRemainingQuantity() == 0) {
+            unlink(order);
+            return 0;
         }
+
+        if (!order.isIceberg() || order.getVisibleQuantity() != 0) return 0;
+
+        Quantity refreshed = order.replenish();
+        displayedQuantity_ += refreshed;
+        hiddenQuantity_ -= refreshed;
+
+        linkBack(unlink(order));
+        return refreshed;
+    }
+
+    // Adjust the level totals after an order was reduced in place
+    void reduceQuantity(Quantity displayedQty, Quantity hiddenQty) {
+        displayedQuantity_ -= displayedQty;
+        hiddenQuantity_ -= hiddenQty;
     }
 
     // Get the first order in the queue (FIFO)
     std::shared_ptr<Order> getFrontOrder() const {
-        return orders_.empty() ? nullptr : orders_.front();
+        return head_;
     }
 
-    // Get all orders at this level
-    const std::deque<std::shared_ptr<Order>>& getOrders() const {
-        return orders_;
+    // Front order without taking a reference (prefetch, peeking)
+    const Order* peekFrontOrder() const {
+        return head_.get();
     }
 
-    // Get total quantity at this price level
+    // Visit every order at this level in queue order
+    template<typename Visitor>
+    void forEachOrder(Visitor&& visit) const {
+        for (const std::shared_ptr<Order>* order = &head_; *order; order = &(*order)->links_.levelNext) {
+            visit(*order);
+        }
+    }
+
+    // Get total executable quantity at this price level (displayed + hidden)
     Quantity getTotalQuantity() const {
-        return totalQuantity_;
+        return displayedQuantity_ + hiddenQuantity_;
+    }
+
+    // Quantity visible to the market
+    Quantity getDisplayedQuantity() const {
+        return displayedQuantity_;
+    }
+
+    // Iceberg reserve behind the displayed slices
+    Quantity getHiddenQuantity() const {
+        return hiddenQuantity_;
     }
 
     // Get the price of this level
@@ -84,25 +151,52 @@ public:
 
     // Check if this level is empty
     bool isEmpty() const {
-        return orders_.empty();
+        return !head_;
     }
 
     // Get number of orders at this level
     size_t getOrderCount() const {
-        return orders_.size();
+        return orderCount_;
     }
 
     // String representation for debugging
     std::string toString() const {
         return "PriceLevel[price=" + std::to_string(priceToDouble(price_)) +
-               ", orders=" + std::to_string(orders_.size()) +
-               ", totalQty=" + std::to_string(totalQuantity_) + "]";
+               ", orders=" + std::to_string(orderCount_) +
+               ", displayedQty=" + std::to_string(displayedQuantity_) +
+               ", hiddenQty=" + std::to_string(hiddenQuantity_) + "]";
     }
 
 private:
     Price price_;
-    Quantity totalQuantity_;
-    std::deque<std::shared_ptr<Order>> orders_;  // FIFO queue
+    Quantity displayedQuantity_;
+    Quantity hiddenQuantity_;
+    std::shared_ptr<Order> head_;  // FIFO queue, linked through Order::links_
+    Order* tail_;
+    size_t orderCount_;
+
+    void linkBack(std::shared_ptr<Order> order) {
+        Order* raw = order.get();
+        raw->links_.levelPrev = tail_;
+        (tail_ ? tail_->links_.levelNext : head_) = std::move(order);
+        tail_ = raw;
+        orderCount_++;
+    }
+
+    // Detach an order from the queue and hand back the level's reference
+    std::shared_ptr<Order> unlink(Order& order) {
+        std::shared_ptr<Order>& owner = order.links_.levelPrev ? order.links_.levelPrev->links_.levelNext : head_;
+        std::shared_ptr<Order> self = std::move(owner);
+        owner = std::move(order.links_.levelNext);
+        if (owner) {
+            owner->links_.levelPrev = order.links_.levelPrev;
+        } else {
+            tail_ = order.links_.levelPrev;
+        }
+        order.links_.levelPrev = nullptr;
+        orderCount_--;
+        return self;
+    }
 };
 
 } // namespace trading
@@ -0,0 +1,161 @@
+#ifndef STOP_BOOK_HPP
+#define STOP_BOOK_HPP
+
+#include "core/order.hpp"
+#include "engine/account_orders.hpp"
+#include <deque>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace trading {
+
+/**
+ * StopBook holds untriggered stop and stop-limit orders, indexed by
+ * stop price per side so a trade only visits the stops it triggers.
+ *
+ *   Buy stops:  ascending,  triggered by last >= stop (front of the map)
+ *   Sell stops: descending, triggered by last <= stop (front of the map)
+ *
+ * Finding the triggered range is O(log n), draining it O(k).
+ */
+class StopBook {
+public:
+    StopBook() = default;
+
+    bool addStop(std::shared_ptr<Order> order) {
+        OrderId orderId = order->getId();
+        if (index_.find(orderId) != index_.end()) {
+            return false;
+        }
+
+        Price stopPrice = order->getStopPrice();
+        index_[orderId] = {order->getSide(), stopPrice};
+        accountStops_.add(*order);
+
+        if (order->getSide() == Side::BUY) {
+            buyStops_[stopPrice].push_back(std::move(order));
+        } else {
+            sellStops_[stopPrice].push_back(std::move(order));
+        }
+        return true;
+    }
+
+    // Remove an untriggered stop; returns it so the caller can cancel it
+    std::shared_ptr<Order> removeStop(OrderId orderId) {
+        auto it = index_.find(orderId);
+        if (it == index_.end()) {
+            return nullptr;
+        }
+
+        Side side = it->second.side;
+        Price stopPrice = it->second.stopPrice;
+        index_.erase(it);
+
+        auto order = side == Side::BUY ? removeFrom(buyStops_, orderId, stopPrice)
+                                       : removeFrom(sellStops_, orderId, stopPrice);
+        if (order) {
+            accountStops_.remove(*order);
+        }
+        return order;
+    }
+
+    // Remove an account's untriggered stops (optionally one side); returns them
+    std::vector<std::shared_ptr<Order>> removeAccount(AccountId accountId,
+                                                      std::optional<Side> side = std::nullopt) {
+        std::vector<Order*> targets;
+        if (!side || *side == Side::BUY) {
+            accountStops_.collect(accountId, Side::BUY, targets);
+        }
+        if (!side || *side == Side::SELL) {
+            accountStops_.collect(accountId, Side::SELL, targets);
+        }
+
+        std::vector<std::shared_ptr<Order>> removed;
+        removed.reserve(targets.size());
+        for (Order* order : targets) {
+            removed.push_back(removeStop(order->getId()));
+        }
+        return removed;
+    }
+
+    /**
+     * Move every stop triggered by trades printed between low and high
+     * to the back of out: buy stops up to high, sell stops down to low,
+     * so a sweep that prints through a stop and ends past it still fires
+     * it. Order is deterministic: buy stops before sell stops, each side
+     * by stop price (the level the market reached first), then arrival.
+     */
+    void collectTriggered(Price low, Price high,
+                          std::deque<std::shared_ptr<Order>>& out) {
+        drainTriggered(buyStops_, high, out);
+        drainTriggered(sellStops_, low, out);
+    }
+
+    bool hasTriggered(Price low, Price high) const {
+        return (!buyStops_.empty() && buyStops_.begin()->first <= high) ||
+               (!sellStops_.empty() && sellStops_.begin()->first >= low);
+    }
+
+    bool contains(OrderId orderId) const {
+        return index_.find(orderId) != index_.end();
+    }
+
+    size_t size() const { return index_.size(); }
+    bool empty() const { return index_.empty(); }
+
+private:
+    using StopQueue = std::deque<std::shared_ptr<Order>>;
+
+    struct StopLocation {
+        Side side;
+        Price stopPrice;
+    };
+
+    std::map<Price, StopQueue, std::less<Price>> buyStops_;
+    std::map<Price, StopQueue, std::greater<Price>> sellStops_;
+    std::unordered_map<OrderId, StopLocation> index_;
+    AccountOrders accountStops_;
+
+    template<typename Stops>
+    std::shared_ptr<Order> removeFrom(Stops& stops, OrderId orderId, Price stopPrice) {
+        auto level = stops.find(stopPrice);
+        if (level == stops.end()) return nullptr;
+
+        StopQueue& queue = level->second;
+        auto it = std::find_if(queue.begin(), queue.end(),
+            [orderId](const std::shared_ptr<Order>& order) {
+                return order->getId() == orderId;
+            });
+        if (it == queue.end()) return nullptr;
+
+        std::shared_ptr<Order> order = std::move(*it);
+        queue.erase(it);
+        if (queue.empty()) {
+            stops.erase(level);
+        }
+        return order;
+    }
+
+    // Both maps are ordered so triggered stops form a prefix ending at upper_bound
+    template<typename Stops>
+    void drainTriggered(Stops& stops, Price tradePrice, StopQueue& out) {
+        auto end = stops.upper_bound(tradePrice);
+        for (auto it = stops.begin(); it != end; ++it) {
+            for (auto& order : it->second) {
+                index_.erase(order->getId());
+                accountStops_.remove(*order);
+                out.push_back(std::move(order));
+            }
+        }
+        stops.erase(stops.begin(), end);
+    }
+};
+
+} // namespace trading
+
+#endif // STOP_BOOK_HPP
@@ -0,0 +1,53 @@
+#ifndef TOP_OF_BOOK_HPP
+#define TOP_OF_BOOK_HPP
+
+#include "core/types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace trading {
+
+/**
+ * TopOfBook is a fixed-size copy of the best N levels on each side.
+ * The matching thread publishes it through a SeqLock after each book
+ * mutation; readers on other threads get a consistent BBO and depth
+ * without touching the live book.
+ */
+struct alignas(64) TopOfBook {
+    static constexpr size_t MAX_DEPTH = 10;
+
+    struct Level {
+        Price price;
+        Quantity quantity;
+        uint64_t orderCount;
+    };
+
+    Timestamp updateTime;   // Nanoseconds since epoch of the publishing mutation
+    uint32_t bidLevels;     // Valid entries in bids[]
+    uint32_t askLevels;     // Valid entries in asks[]
+    Level bids[MAX_DEPTH];  // Highest price first
+    Level asks[MAX_DEPTH];  // Lowest price first
+
+    std::optional<Price> getBestBid() const {
+        return bidLevels > 0 ? std::optional<Price>(bids[0].price) : std::nullopt;
+    }
+
+    std::optional<Price> getBestAsk() const {
+        return askLevels > 0 ? std::optional<Price>(asks[0].price) : std::nullopt;
+    }
+
+    std::optional<Price> getSpread() const {
+        if (bidLevels == 0 || askLevels == 0) return std::nullopt;
+        return asks[0].price - bids[0].price;
+    }
+
+    std::optional<double> getMidPrice() const {
+        if (bidLevels == 0 || askLevels == 0) return std::nullopt;
+        return priceToDouble(bids[0].price + asks[0].price) / 2.0;
+    }
+};
+
+} // namespace trading
+
+#endif // TOP_OF_BOOK_HPP
@@ -3,10 +3,13 @@
 
 #include "core/types.hpp"
 #include "core/order.hpp"
+#include "utils/latency_trace.hpp"
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <sstream>
 #include <memory>
+#include <utility>
 
 namespace trading {
 namespace network {
@@ -34,6 +37,11 @@ public:
     static constexpr int TAG_ORDER_QTY = 38;      // Quantity
     static constexpr int TAG_ORD_TYPE = 40;       // Order type
     static constexpr int TAG_PRICE = 44;          // Price
+    static constexpr int TAG_STOP_PX = 99;        // Stop trigger price
+    static constexpr int TAG_TIME_IN_FORCE = 59;  // 0=Day 1=GTC 3=IOC 4=FOK
+    static constexpr int TAG_DISPLAY_QTY = 1138;  // Iceberg slice size
+    static constexpr int TAG_ACCOUNT = 1;         // Account (numeric)
+    static constexpr int TAG_EXEC_INST = 18;      // '6' = post only
     static constexpr int TAG_EXEC_TYPE = 150;     // Execution type
     static constexpr int TAG_ORDER_ID = 37;       // Order ID
     static constexpr int TAG_EXEC_ID = 17;        // Execution ID
@@ -73,9 +81,69 @@ public:
             }
         }
         
+        TRACE_STAGE(PARSE);
         return msg;
     }
 
+    /**
+     * Find one field in a raw message without parsing the rest: no
+     * allocation, one pass up to the field. For cheap decisions (message
+     * type, account) before committing to a full parse. Returns false if
+     * the tag is absent.
+     */
+    static bool peekField(const std::string& rawMessage, int tag, std::string_view& value) {
+        std::string_view raw(rawMessage);
+        size_t start = 0;
+        while (start < raw.size()) {
+            size_t end = raw.find('\x01', start);
+            if (end == std::string_view::npos) end = raw.size();
+
+            int fieldTag = 0;
+            size_t pos = start;
+            while (pos < end && raw[pos] >= '0' && raw[pos] <= '9') {
+                fieldTag = fieldTag * 10 + (raw[pos] - '0');
+                ++pos;
+            }
+            if (pos < end && raw[pos] == '=' && fieldTag == tag) {
+                value = raw.substr(pos + 1, end - pos - 1);
+                return true;
+            }
+            start = end + 1;
+        }
+        return false;
+    }
+
+    /**
+     * Length of the first complete message in a stream of received bytes:
+     * up to and including the SOH that ends its CheckSum (10=) field. 0
+     * while the message is still incomplete. TCP may split one message
+     * across reads or deliver several in one, so readers frame with this.
+     */
+    static size_t frameLength(std::string_view stream) {
+        size_t checksum = stream.find("\x01" "10=");
+        if (checksum == std::string_view::npos) return 0;
+        size_t end = stream.find('\x01', checksum + 4);
+        return end == std::string_view::npos ? 0 : end + 1;
+    }
+
+    // Message type of a raw message, or '\0' if it has none
+    static char peekMsgType(const std::string& rawMessage) {
+        std::string_view value;
+        return peekField(rawMessage, TAG_MSG_TYPE, value) && value.size() == 1 ? value[0] : '\0';
+    }
+
+    // Account (tag 1) of a raw message, or 0 if it has none
+    static AccountId peekAccount(const std::string& rawMessage) {
+        std::string_view value;
+        if (!peekField(rawMessage, TAG_ACCOUNT, value)) return 0;
+        AccountId account = 0;
+        for (char c : value) {
+            if (c < '0' || c > '9') return 0;
+            account = account * 10 + static_cast<AccountId>(c - '0');
+        }
+        return account;
+    }
+
     /**
      * Serialize to FIX string.
      */
@@ -144,6 +212,17 @@ public:
      * Convert FIX message to Order object.
      */
     std::shared_ptr<Order> toOrder() const {
+        return toOrder([](auto&&... args) {
+            return std::make_shared<Order>(std::forward<decltype(args)>(args)...);
+        });
+    }
+
+    /**
+     * Convert with a custom factory taking Order constructor arguments,
+     * e.g. to build the order in a pool (EngineMemory::makeOrder).
+     */
+    template<typename MakeOrder>
+    std::shared_ptr<Order> toOrder(MakeOrder&& makeOrder) const {
         if (getMessageType() != MSG_NEW_ORDER) {
             return nullptr;
         }
@@ -160,18 +239,47 @@ public:
         OrderType orderType = OrderType::LIMIT;
         if (typeChar == '1') orderType = OrderType::MARKET;
         else if (typeChar == '2') orderType = OrderType::LIMIT;
+        else if (typeChar == '3') orderType = OrderType::STOP;
+        else if (typeChar == '4') orderType = OrderType::STOP_LIMIT;
         
         Quantity quantity = getFieldAsInt(TAG_ORDER_QTY);
         
-        if (orderType == OrderType::MARKET) {
-            return std::make_shared<Order>(orderId, symbol, side, quantity);
+        std::shared_ptr<Order> order;
+        if (orderType == OrderType::STOP || orderType == OrderType::STOP_LIMIT) {
+            Price stopPrice = doubleToPrice(getFieldAsDouble(TAG_STOP_PX));
+            Price price = orderType == OrderType::STOP_LIMIT
+                              ? doubleToPrice(getFieldAsDouble(TAG_PRICE)) : 0;
+            order = makeOrder(
+                orderId, symbol, side, orderType, price, stopPrice, quantity
+            );
+        } else if (orderType == OrderType::MARKET) {
+            order = makeOrder(orderId, symbol, side, quantity);
         } else {
             double priceDouble = getFieldAsDouble(TAG_PRICE);
             Price price = doubleToPrice(priceDouble);
-            return std::make_shared<Order>(
+            order = makeOrder(
                 orderId, symbol, side, orderType, price, quantity
             );
         }
+
+        // Time in force (GTD needs ExpireTime, which is not supported here)
+        std::string tif = getField(TAG_TIME_IN_FORCE);
+        if (tif == "0") order->setTimeInForce(TimeInForce::DAY);
+        else if (tif == "3") order->setTimeInForce(TimeInForce::IOC);
+        else if (tif == "4") order->setTimeInForce(TimeInForce::FOK);
+
+        if (hasField(TAG_DISPLAY_QTY)) {
+            order->setDisplayQuantity(getFieldAsInt(TAG_DISPLAY_QTY));
+        }
+
+        if (hasField(TAG_ACCOUNT)) {
+            order->setAccountId(static_cast<AccountId>(getFieldAsInt(TAG_ACCOUNT)));
+        }
+        if (getField(TAG_EXEC_INST).find('6') != std::string::npos) {
+            order->setPostOnly(PostOnlyMode::REJECT);
+        }
+
+        return order;
     }
 
     /**
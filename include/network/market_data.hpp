@@ -9,6 +9,7 @@
 #include <sstream>
 #include <iomanip>
 #include <memory>
+#include <algorithm>
 
 namespace trading {
 namespace network {
@@ -22,8 +23,12 @@ public:
 
     /**
      * Publish order book snapshot in JSON format.
+     * Built from the book's published top-of-book, so it is safe off the
+     * matching thread.
      */
     static std::string formatOrderBookSnapshot(const OrderBook& book) {
+        const TopOfBook top = book.getTopOfBook();
+
         std::ostringstream oss;
         oss << std::fixed << std::setprecision(2);
         
@@ -32,8 +37,8 @@ public:
         oss << "  \"timestamp\": " << getCurrentTimestamp() << ",\n";
         
         // Best bid/ask
-        auto bestBid = book.getBestBid();
-        auto bestAsk = book.getBestAsk();
+        auto bestBid = top.getBestBid();
+        auto bestAsk = top.getBestAsk();
         
         if (bestBid) {
             oss << "  \"best_bid\": " << priceToDouble(*bestBid) << ",\n";
@@ -42,8 +47,8 @@ public:
             oss << "  \"best_ask\": " << priceToDouble(*bestAsk) << ",\n";
         }
         
-        auto spread = book.getSpread();
-        auto mid = book.getMidPrice();
+        auto spread = top.getSpread();
+        auto mid = top.getMidPrice();
         
         if (spread) {
             oss << "  \"spread\": " << priceToDouble(*spread) << ",\n";
@@ -53,25 +58,23 @@ public:
         }
         
         // Bids
-        auto bids = book.getBidDepth(10);
         oss << "  \"bids\": [\n";
-        for (size_t i = 0; i < bids.size(); ++i) {
-            oss << "    {\"price\": " << priceToDouble(bids[i].price)
-                << ", \"quantity\": " << bids[i].quantity
-                << ", \"orders\": " << bids[i].orderCount << "}";
-            if (i < bids.size() - 1) oss << ",";
+        for (uint32_t i = 0; i < top.bidLevels; ++i) {
+            oss << "    {\"price\": " << priceToDouble(top.bids[i].price)
+                << ", \"quantity\": " << top.bids[i].quantity
+                << ", \"orders\": " << top.bids[i].orderCount << "}";
+            if (i + 1 < top.bidLevels) oss << ",";
             oss << "\n";
         }
         oss << "  ],\n";
         
         // Asks
-        auto asks = book.getAskDepth(10);
         oss << "  \"asks\": [\n";
-        for (size_t i = 0; i < asks.size(); ++i) {
-            oss << "    {\"price\": " << priceToDouble(asks[i].price)
-                << ", \"quantity\": " << asks[i].quantity
-                << ", \"orders\": " << asks[i].orderCount << "}";
-            if (i < asks.size() - 1) oss << ",";
+        for (uint32_t i = 0; i < top.askLevels; ++i) {
+            oss << "    {\"price\": " << priceToDouble(top.asks[i].price)
+                << ", \"quantity\": " << top.asks[i].quantity
+                << ", \"orders\": " << top.asks[i].orderCount << "}";
+            if (i + 1 < top.askLevels) oss << ",";
             oss << "\n";
         }
         oss << "  ]\n";
@@ -103,12 +106,13 @@ public:
 
     /**
      * Publish statistics in JSON format.
+     * Reads the book's seqlock snapshot, so it is safe off the matching thread.
      */
     static std::string formatStats(const OrderBook& book) {
         std::ostringstream oss;
         oss << std::fixed << std::setprecision(2);
         
-        auto stats = book.getStats();
+        auto stats = book.getStatsSnapshot();
         
         oss << "{\n";
         oss << "  \"type\": \"statistics\",\n";
@@ -116,8 +120,12 @@ public:
         oss << "  \"total_orders\": " << stats.totalOrders << ",\n";
         oss << "  \"bid_levels\": " << stats.bidLevels << ",\n";
         oss << "  \"ask_levels\": " << stats.askLevels << ",\n";
-        oss << "  \"total_bid_quantity\": " << stats.totalBidQty << ",\n";
-        oss << "  \"total_ask_quantity\": " << stats.totalAskQty << "\n";
+        oss << "  \"total_bid_quantity\": " << stats.totalBidQty - stats.hiddenBidQty << ",\n";
+        oss << "  \"total_ask_quantity\": " << stats.totalAskQty - stats.hiddenAskQty << ",\n";
+        oss << "  \"bid_orders\": " << stats.bidOrders << ",\n";
+        oss << "  \"ask_orders\": " << stats.askOrders << ",\n";
+        oss << "  \"bid_notional\": " << priceToDouble(stats.bidNotional) << ",\n";
+        oss << "  \"ask_notional\": " << priceToDouble(stats.askNotional) << "\n";
         oss << "}\n";
         
         return oss.str();
@@ -143,34 +151,34 @@ public:
      * Create simple order book display for text clients.
      */
     static std::string formatOrderBookText(const OrderBook& book) {
+        const TopOfBook top = book.getTopOfBook();
+        const uint32_t askCount = std::min<uint32_t>(top.askLevels, 5);
+        const uint32_t bidCount = std::min<uint32_t>(top.bidLevels, 5);
+
         std::ostringstream oss;
         
         oss << "\n===== ORDER BOOK =====\n";
         
-        auto asks = book.getAskDepth(5);
         oss << "\nASKS:\n";
-        for (auto it = asks.rbegin(); it != asks.rend(); ++it) {
+        for (uint32_t i = askCount; i-- > 0;) {
             oss << std::fixed << std::setprecision(2)
-                << "  $" << priceToDouble(it->price)
-                << " | " << it->quantity
-                << " (" << it->orderCount << " orders)\n";
+                << "  $" << priceToDouble(top.asks[i].price)
+                << " | " << top.asks[i].quantity
+                << " (" << top.asks[i].orderCount << " orders)\n";
         }
         
-        auto bestBid = book.getBestBid();
-        auto bestAsk = book.getBestAsk();
-        
-        if (bestBid && bestAsk) {
+        auto spread = top.getSpread();
+        if (spread) {
             oss << "\nSPREAD: $" << std::fixed << std::setprecision(2)
-                << priceToDouble(*bestAsk - *bestBid) << "\n";
+                << priceToDouble(*spread) << "\n";
         }
         
         oss << "\nBIDS:\n";
-        auto bids = book.getBidDepth(5);
-        for (const auto& level : bids) {
+        for (uint32_t i = 0; i < bidCount; ++i) {
             oss << std::fixed << std::setprecision(2)
-                << "  $" << priceToDouble(level.price)
-                << " | " << level.quantity
-                << " (" << level.orderCount << " orders)\n";
+                << "  $" << priceToDouble(top.bids[i].price)
+                << " | " << top.bids[i].quantity
+                << " (" << top.bids[i].orderCount << " orders)\n";
         }
         
         oss << "=====================\n";
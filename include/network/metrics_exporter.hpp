@@ -0,0 +1,83 @@
+#ifndef METRICS_EXPORTER_HPP
+#define METRICS_EXPORTER_HPP
+
+#include "network/tcp_server.hpp"
+#include "utils/metrics.hpp"
+#include <string>
+
+namespace trading {
+namespace network {
+
+/**
+ * MetricsExporter serves SystemMetrics in Prometheus text format.
+ * Runs on its own TCPServer, so a scrape only reads the per-thread
+ * counter blocks and never blocks a recording thread.
+ *
+ *   GET /metrics  -> 200 text/plain (exposition format 0.0.4)
+ *   anything else -> 404
+ */
+class MetricsExporter {
+public:
+    explicit MetricsExporter(uint16_t port,
+                             utils::SystemMetrics& metrics = utils::SystemMetrics::getInstance())
+        : tcpServer_(port)
+        , metrics_(metrics)
+    {}
+
+    bool start() {
+        tcpServer_.setMessageCallback([this](const std::string& request, socket_t client) {
+            handleRequest(request, client);
+        });
+        return tcpServer_.start();
+    }
+
+    void stop() {
+        tcpServer_.stop();
+    }
+
+private:
+    TCPServer tcpServer_;
+    utils::SystemMetrics& metrics_;
+
+    // GET /metrics exactly: the path ends at a space or a query string
+    static bool isMetricsRequest(const std::string& request) {
+        static constexpr char PREFIX[] = "GET /metrics";
+        constexpr size_t LENGTH = sizeof(PREFIX) - 1;
+        return request.compare(0, LENGTH, PREFIX) == 0 && request.size() > LENGTH &&
+               (request[LENGTH] == ' ' || request[LENGTH] == '?');
+    }
+
+    void handleRequest(const std::string& request, socket_t client) {
+        if (isMetricsRequest(request)) {
+            sendResponse(client, "200 OK",
+                         "text/plain; version=0.0.4; charset=utf-8",
+                         metrics_.toPrometheus());
+        } else {
+            sendResponse(client, "404 Not Found", "text/plain", "Not Found\n");
+        }
+
+        // One request per connection keeps the exporter stateless
+        tcpServer_.disconnectClient(client);
+    }
+
+    void sendResponse(socket_t client, const char* status,
+                      const char* contentType, const std::string& body) {
+        std::string response;
+        response.reserve(body.size() + 128);
+        response += "HTTP/1.1 ";
+        response += status;
+        response += "\r\nContent-Type: ";
+        response += contentType;
+        response += "\r\nContent-Length: ";
+        response += std::to_string(body.size());
+        response += "\r\nConnection: close\r\n\r\n";
+        response += body;
+
+        tcpServer_.sendMessage(client, response);
+    }
+};
+
+} // namespace network
+} // namespace trading
+
+#endif // METRICS_EXPORTER_HPP
@@ -1,12 +1,19 @@
 #ifndef TCP_SERVER_HPP
 #define TCP_SERVER_HPP
 
+#include "utils/latency_trace.hpp"
+#include "utils/thread_runtime.hpp"
+#include "utils/rate_limiter.hpp"
 #include <string>
+#include <string_view>
 #include <vector>
+#include <list>
 #include <functional>
 #include <memory>
 #include <thread>
 #include <atomic>
+#include <mutex>
+#include <algorithm>
 
 #ifdef _WIN32
     #include <winsock2.h>
@@ -32,11 +39,19 @@ namespace network {
 class TCPServer {
 public:
     using MessageCallback = std::function<void(const std::string&, socket_t)>;
+    using DisconnectCallback = std::function<void(socket_t)>;
+    // Length of the first complete message in `stream`, 0 if incomplete
+    using FrameFunction = size_t (*)(std::string_view stream);
 
     TCPServer(uint16_t port) 
         : port_(port)
         , running_(false)
         , serverSocket_(INVALID_SOCKET)
+        , sessionRate_(0.0)
+        , sessionBurst_(1)
+        , messagesThrottled_(0)
+        , frameLength_(nullptr)
+        , tracing_(false)
     {
 #ifdef _WIN32
         WSADATA wsaData;
@@ -100,17 +115,27 @@ public:
         running_ = false;
 
         if (serverSocket_ != INVALID_SOCKET) {
+            // Shutdown first so a thread blocked in accept() wakes up
+            shutdownSocket(serverSocket_);
             closeSocket(serverSocket_);
             serverSocket_ = INVALID_SOCKET;
         }
 
+        // Wake client threads blocked in recv()
+        {
+            std::lock_guard<std::mutex> lock(clientsMutex_);
+            for (socket_t client : clients_) {
+                shutdownSocket(client);
+            }
+        }
+
         if (acceptThread_.joinable()) {
             acceptThread_.join();
         }
 
-        for (auto& thread : clientThreads_) {
-            if (thread.joinable()) {
-                thread.join();
+        for (auto& client : clientThreads_) {
+            if (client.thread.joinable()) {
+                client.thread.join();
             }
         }
         clientThreads_.clear();
@@ -123,6 +148,62 @@ public:
         messageCallback_ = std::move(callback);
     }
 
+    /**
+     * Set callback for closed connections (peer close, error or
+     * disconnectClient). Runs on the client's thread before the socket
+     * is closed, e.g. to cancel the session's orders.
+     */
+    void setDisconnectCallback(DisconnectCallback callback) {
+        disconnectCallback_ = std::move(callback);
+    }
+
+    /**
+     * Placement for the accept thread and the per-client reader threads
+     * (e.g. ThreadSettings::fromConfig("network.accept")). Takes effect
+     * for threads started afterwards, so set it before start().
+     */
+    void setThreadSettings(const utils::ThreadSettings& acceptSettings,
+                           const utils::ThreadSettings& clientSettings) {
+        acceptSettings_ = acceptSettings;
+        clientSettings_ = clientSettings;
+    }
+
+    /**
+     * Cut each connection's byte stream into messages with `frameLength`
+     * (e.g. FIXMessage::frameLength): the callback then sees whole
+     * messages however TCP splits or coalesces them. Without one, every
+     * read is delivered as a message. Set before start().
+     */
+    void setFraming(FrameFunction frameLength) {
+        frameLength_ = frameLength;
+    }
+
+    /**
+     * Trace each inbound message from socket read to reply (see
+     * latency_trace.hpp). Off by default: only the order gateway's
+     * latency belongs in the stage histograms, not HTTP scrapes or
+     * WebSocket handshakes. Set before start().
+     */
+    void setTracing(bool enabled) {
+        tracing_ = enabled;
+    }
+
+    /**
+     * Cap each connection at `ratePerSecond` messages, `burst` back to
+     * back. Over the limit, a message is dropped whole on the client's
+     * thread before the message callback, so a flooding session costs one
+     * TSC read per message. 0 disables; set before start().
+     */
+    void setSessionRateLimit(double ratePerSecond, uint32_t burst) {
+        sessionRate_ = ratePerSecond;
+        sessionBurst_ = burst;
+    }
+
+    // Messages dropped by the session rate limit (any thread)
+    uint64_t getMessagesThrottled() const {
+        return messagesThrottled_.load(std::memory_order_relaxed);
+    }
+
     /**
      * Send message to a specific client.
      */
@@ -137,9 +218,22 @@ public:
         ssize_t result = send(clientSocket, message.c_str(), message.length(), 0);
 #endif
 
+        if (tracing_) {
+            TRACE_STAGE(SEND);
+        }
         return result != SOCKET_ERROR;
     }
 
+    /**
+     * Disconnect a client. The client's thread sees end-of-stream,
+     * removes it from the client list and closes the socket.
+     */
+    void disconnectClient(socket_t clientSocket) {
+        if (clientSocket != INVALID_SOCKET) {
+            shutdownSocket(clientSocket);
+        }
+    }
+
     /**
      * Broadcast message to all connected clients.
      */
@@ -159,16 +253,33 @@ public:
     }
 
 private:
+    // A reader thread and whether it has finished, so the accept loop
+    // can join it; a list keeps each flag in place for its thread
+    struct ClientThread {
+        std::thread thread;
+        std::atomic<bool> finished{false};
+    };
+
     uint16_t port_;
     std::atomic<bool> running_;
     socket_t serverSocket_;
     std::thread acceptThread_;
-    std::vector<std::thread> clientThreads_;
+    std::list<ClientThread> clientThreads_;  // Accept thread only, then stop()
     std::vector<socket_t> clients_;
     mutable std::mutex clientsMutex_;
     MessageCallback messageCallback_;
+    DisconnectCallback disconnectCallback_;
+    utils::ThreadSettings acceptSettings_;
+    utils::ThreadSettings clientSettings_;
+    double sessionRate_;
+    uint32_t sessionBurst_;
+    std::atomic<uint64_t> messagesThrottled_;
+    FrameFunction frameLength_;
+    bool tracing_;
 
     void acceptLoop() {
+        utils::ThreadRuntime::apply("tcp-accept", acceptSettings_);
+
         while (running_) {
             sockaddr_in clientAddr{};
 #ifdef _WIN32
@@ -187,33 +298,69 @@ private:
                     clients_.push_back(clientSocket);
                 }
 
-                clientThreads_.emplace_back(
-                    &TCPServer::handleClient, this, clientSocket
-                );
+                // Short-lived connections (e.g. metrics scrapes) would
+                // otherwise pile up one finished thread each until stop()
+                reapClientThreads();
+
+                ClientThread& client = clientThreads_.emplace_back();
+                client.thread = std::thread(&TCPServer::handleClient, this,
+                                            clientSocket, &client.finished);
             }
         }
     }
 
-    void handleClient(socket_t clientSocket) {
+    void reapClientThreads() {
+        for (auto it = clientThreads_.begin(); it != clientThreads_.end();) {
+            if (it->finished.load(std::memory_order_acquire)) {
+                it->thread.join();
+                it = clientThreads_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void handleClient(socket_t clientSocket, std::atomic<bool>* finished) {
         const size_t BUFFER_SIZE = 4096;
+        const size_t MAX_PENDING = 64 * 1024;  // Unframeable input beyond this is discarded
         char buffer[BUFFER_SIZE];
 
+        utils::ThreadRuntime::apply("tcp-client", clientSettings_);
+
+        // Only this thread reads the connection, so its bucket is private
+        utils::TokenBucket sessionRate(sessionRate_, sessionBurst_);
+
+        // Received bytes not yet framed: a read can end mid-message or
+        // hold several (see setFraming)
+        std::string pending;
+
         while (running_) {
 #ifdef _WIN32
-            int bytesReceived = recv(clientSocket, buffer, BUFFER_SIZE - 1, 0);
+            int bytesReceived = recv(clientSocket, buffer, BUFFER_SIZE, 0);
 #else
-            ssize_t bytesReceived = recv(clientSocket, buffer, BUFFER_SIZE - 1, 0);
+            ssize_t bytesReceived = recv(clientSocket, buffer, BUFFER_SIZE, 0);
 #endif
 
             if (bytesReceived <= 0) {
                 break; // Client disconnected or error
             }
 
-            buffer[bytesReceived] = '\0';
-            std::string message(buffer, bytesReceived);
+            if (!frameLength_) {
+                deliver(std::string_view(buffer, static_cast<size_t>(bytesReceived)),
+                        sessionRate, clientSocket);
+                continue;
+            }
 
-            if (messageCallback_) {
-                messageCallback_(message, clientSocket);
+            pending.append(buffer, static_cast<size_t>(bytesReceived));
+            std::string_view stream(pending);
+            size_t framed = 0;
+            while (size_t length = frameLength_(stream.substr(framed))) {
+                deliver(stream.substr(framed, length), sessionRate, clientSocket);
+                framed += length;
+            }
+            pending.erase(0, framed);
+            if (pending.size() > MAX_PENDING) {
+                pending.clear();
             }
         }
 
@@ -226,7 +373,36 @@ private:
             );
         }
 
+        if (disconnectCallback_) {
+            disconnectCallback_(clientSocket);
+        }
+
         closeSocket(clientSocket);
+        finished->store(true, std::memory_order_release);
+    }
+
+    // One token per message; over the limit it is dropped whole
+    void deliver(std::string_view message, utils::TokenBucket& sessionRate,
+                 socket_t clientSocket) {
+        if (!sessionRate.tryAcquire()) {
+            messagesThrottled_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // Trace this message through parse, risk, match and reply (if on)
+        utils::TraceScope trace(tracing_);
+
+        if (messageCallback_) {
+            messageCallback_(std::string(message), clientSocket);
+        }
+    }
+
+    void shutdownSocket(socket_t socket) {
+#ifdef _WIN32
+        shutdown(socket, SD_BOTH);
+#else
+        shutdown(socket, SHUT_RDWR);
+#endif
     }
 
     void closeSocket(socket_t socket) {
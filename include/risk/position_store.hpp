@@ -0,0 +1,267 @@
+#ifndef POSITION_STORE_HPP
+#define POSITION_STORE_HPP
+
+#include "core/types.hpp"
+#include "risk/risk_manager.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace trading {
+namespace risk {
+
+/**
+ * PositionStore - every account's positions in a fixed set of symbols,
+ * kept as columns: one array per field per symbol, indexed by account.
+ * Marking a symbol then walks a handful of contiguous int64 arrays with
+ * no branches, which the compiler turns into SIMD loops, instead of
+ * striding over Position structs.
+ *
+ * Each account also keeps running totals (realized, unrealized, gross
+ * exposure, peak equity), so a fill or a mark moves equity in O(1) per
+ * position. Two ways to revalue:
+ *
+ *   markSymbol(symbol, price)    one symbol, all accounts; per price move
+ *   setMark() + revalue(b, e)    all symbols for accounts [b, e), rebuilding
+ *                                their totals; disjoint ranges may run on
+ *                                different threads (see RiskShard::revalueAll)
+ *
+ * Accounts are added, never removed; reserve them at construction so the
+ * columns never move. Not thread-safe beyond the disjoint revalue ranges.
+ */
+class PositionStore {
+public:
+    struct AccountRisk {
+        AccountId accountId = 0;
+        Notional realizedPnL = 0;    // Today, across the store's symbols
+        Notional unrealizedPnL = 0;  // Sum over the account's positions
+        Notional grossExposure = 0;  // Sum of |quantity| * mark
+        Notional peakEquity = 0;
+
+        Notional getEquity() const { return realizedPnL + unrealizedPnL; }
+        Notional getDrawdown() const { return peakEquity - getEquity(); }
+    };
+
+    PositionStore(size_t symbols, size_t maxAccounts)
+        : columns_(symbols)
+        , marks_(symbols, 0)
+    {
+        for (auto& column : columns_) {
+            column.reserve(maxAccounts);
+        }
+        accountIds_.reserve(maxAccounts);
+        realized_.reserve(maxAccounts);
+        unrealized_.reserve(maxAccounts);
+        exposure_.reserve(maxAccounts);
+        peak_.reserve(maxAccounts);
+    }
+
+    // Add a flat account and return its index
+    uint32_t addAccount(AccountId accountId) {
+        for (auto& column : columns_) {
+            column.grow();
+        }
+        accountIds_.push_back(accountId);
+        realized_.push_back(0);
+        unrealized_.push_back(0);
+        exposure_.push_back(0);
+        peak_.push_back(0);
+        return static_cast<uint32_t>(accountIds_.size() - 1);
+    }
+
+    size_t getAccountCount() const { return accountIds_.size(); }
+    size_t getSymbolCount() const { return columns_.size(); }
+
+    /**
+     * Apply a fill to one position (see Position::applyFill) and revalue
+     * it at the symbol's mark, or at the fill price before the first mark.
+     */
+    void applyFill(uint32_t account, uint32_t symbol, Side side, Price price, Quantity qty) {
+        Column& column = columns_[symbol];
+        int64_t delta = static_cast<int64_t>(qty);
+        if (side == Side::BUY) {
+            column.totalBought[account] += qty;
+        } else {
+            column.totalSold[account] += qty;
+            delta = -delta;
+        }
+
+        Notional realized = Position::applyFill(column.quantity[account],
+                                                column.costBasis[account], delta, price);
+        column.realizedPnL[account] += realized;
+        realized_[account] += realized;
+
+        Price mark = marks_[symbol] > 0 ? marks_[symbol] : price;
+        markRange(column, mark, account, account + 1);
+    }
+
+    /**
+     * Revalue every account's position in `symbol` at `price`. Flat
+     * positions are included rather than skipped: they come out as zero,
+     * and the loop stays branch-free.
+     */
+    void markSymbol(uint32_t symbol, Price price) {
+        marks_[symbol] = price;
+        markRange(columns_[symbol], price, 0, accountIds_.size());
+    }
+
+    // Record a mark without revaluing; revalue() picks it up
+    void setMark(uint32_t symbol, Price price) { marks_[symbol] = price; }
+
+    Price getMark(uint32_t symbol) const { return marks_[symbol]; }
+
+    /**
+     * Revalue accounts [begin, end) in every symbol at the current marks
+     * and rebuild their unrealized and exposure totals. Symbols not marked
+     * yet keep the values of their last revaluation. Touches only those
+     * accounts' entries, so disjoint ranges can run concurrently.
+     */
+    void revalue(size_t begin, size_t end) {
+        Notional* __restrict unrealizedTotal = unrealized_.data();
+        Notional* __restrict exposureTotal = exposure_.data();
+        std::fill(unrealizedTotal + begin, unrealizedTotal + end, 0);
+        std::fill(exposureTotal + begin, exposureTotal + end, 0);
+
+        for (size_t symbol = 0; symbol < columns_.size(); ++symbol) {
+            Column& column = columns_[symbol];
+            Price mark = marks_[symbol];
+            const int64_t* __restrict quantity = column.quantity.data();
+            const Notional* __restrict costBasis = column.costBasis.data();
+            Notional* __restrict unrealized = column.unrealizedPnL.data();
+            Notional* __restrict exposure = column.exposure.data();
+
+            if (mark > 0) {
+                for (size_t i = begin; i < end; ++i) {
+                    unrealized[i] = mark * quantity[i] - costBasis[i];
+                    exposure[i] = mark * (quantity[i] < 0 ? -quantity[i] : quantity[i]);
+                }
+            }
+            for (size_t i = begin; i < end; ++i) {
+                unrealizedTotal[i] += unrealized[i];
+                exposureTotal[i] += exposure[i];
+            }
+        }
+        updatePeaks(begin, end);
+    }
+
+    Position getPosition(uint32_t account, uint32_t symbol) const {
+        const Column& column = columns_[symbol];
+        Position position;
+        position.quantity = column.quantity[account];
+        position.costBasis = column.costBasis[account];
+        position.realizedPnL = column.realizedPnL[account];
+        position.unrealizedPnL = column.unrealizedPnL[account];
+        position.totalBought = column.totalBought[account];
+        position.totalSold = column.totalSold[account];
+        return position;
+    }
+
+    int64_t getQuantity(uint32_t account, uint32_t symbol) const {
+        return columns_[symbol].quantity[account];
+    }
+
+    AccountRisk getAccount(uint32_t account) const {
+        AccountRisk risk;
+        risk.accountId = accountIds_[account];
+        risk.realizedPnL = realized_[account];
+        risk.unrealizedPnL = unrealized_[account];
+        risk.grossExposure = exposure_[account];
+        risk.peakEquity = peak_[account];
+        return risk;
+    }
+
+    Notional getDrawdown(uint32_t account) const {
+        return peak_[account] - (realized_[account] + unrealized_[account]);
+    }
+
+    Notional getRealizedPnL(uint32_t account) const { return realized_[account]; }
+
+    void resetDaily() {
+        for (size_t i = 0; i < accountIds_.size(); ++i) {
+            realized_[i] = 0;
+            peak_[i] = unrealized_[i];
+        }
+        for (auto& column : columns_) {
+            std::fill(column.realizedPnL.begin(), column.realizedPnL.end(), 0);
+        }
+    }
+
+private:
+    // One symbol's positions, indexed by account
+    struct Column {
+        std::vector<int64_t> quantity;       // Positive = long, negative = short
+        std::vector<Notional> costBasis;
+        std::vector<Notional> realizedPnL;
+        std::vector<Notional> unrealizedPnL;
+        std::vector<Notional> exposure;      // |quantity| * mark
+        std::vector<Quantity> totalBought;
+        std::vector<Quantity> totalSold;
+
+        void reserve(size_t accounts) {
+            quantity.reserve(accounts);
+            costBasis.reserve(accounts);
+            realizedPnL.reserve(accounts);
+            unrealizedPnL.reserve(accounts);
+            exposure.reserve(accounts);
+            totalBought.reserve(accounts);
+            totalSold.reserve(accounts);
+        }
+
+        void grow() {
+            quantity.push_back(0);
+            costBasis.push_back(0);
+            realizedPnL.push_back(0);
+            unrealizedPnL.push_back(0);
+            exposure.push_back(0);
+            totalBought.push_back(0);
+            totalSold.push_back(0);
+        }
+    };
+
+    std::vector<Column> columns_;
+    std::vector<Price> marks_;  // Last mark per symbol, 0 = none yet
+
+    // Per-account totals, indexed like the columns
+    std::vector<AccountId> accountIds_;
+    std::vector<Notional> realized_;
+    std::vector<Notional> unrealized_;
+    std::vector<Notional> exposure_;
+    std::vector<Notional> peak_;
+
+    // The mark-to-market kernel: revalue positions [begin, end) of one
+    // column and move their accounts' totals and peaks by the change
+    void markRange(Column& column, Price mark, size_t begin, size_t end) {
+        const int64_t* __restrict quantity = column.quantity.data();
+        const Notional* __restrict costBasis = column.costBasis.data();
+        Notional* __restrict unrealized = column.unrealizedPnL.data();
+        Notional* __restrict exposure = column.exposure.data();
+        const Notional* __restrict realizedTotal = realized_.data();
+        Notional* __restrict unrealizedTotal = unrealized_.data();
+        Notional* __restrict exposureTotal = exposure_.data();
+        Notional* __restrict peak = peak_.data();
+
+        for (size_t i = begin; i < end; ++i) {
+            Notional value = mark * quantity[i] - costBasis[i];
+            Notional gross = mark * (quantity[i] < 0 ? -quantity[i] : quantity[i]);
+            unrealizedTotal[i] += value - unrealized[i];
+            exposureTotal[i] += gross - exposure[i];
+            unrealized[i] = value;
+            exposure[i] = gross;
+
+            Notional equity = realizedTotal[i] + unrealizedTotal[i];
+            peak[i] = peak[i] > equity ? peak[i] : equity;
+        }
+    }
+
+    void updatePeaks(size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            peak_[i] = std::max(peak_[i], realized_[i] + unrealized_[i]);
+        }
+    }
+};
+
+} // namespace risk
+} // namespace trading
+
+#endif // POSITION_STORE_HPP
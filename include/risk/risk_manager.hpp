@@ -4,6 +4,9 @@
 #include "core/types.hpp"
 #include "core/order.hpp"
 #include "core/trade.hpp"
+#include "utils/latency_trace.hpp"
+#include "utils/rate_limiter.hpp"
+#include <algorithm>
 #include <unordered_map>
 #include <string>
 #include <cmath>
@@ -12,22 +15,23 @@ namespace trading {
 namespace risk {
 
 /**
- * Position represents a trader's position in a symbol.
+ * Position represents a trader's position in a symbol. All money is
+ * fixed point (see Notional), so positions replay to the same cent.
  */
 struct Position {
     Symbol symbol;
     int64_t quantity;           // Positive = long, negative = short
-    double averagePrice;
-    double realizedPnL;
-    double unrealizedPnL;
+    Notional costBasis;         // Signed cost of the open quantity
+    Notional realizedPnL;
+    Notional unrealizedPnL;
     Quantity totalBought;
     Quantity totalSold;
 
     Position() 
         : quantity(0)
-        , averagePrice(0.0)
-        , realizedPnL(0.0)
-        , unrealizedPnL(0.0)
+        , costBasis(0)
+        , realizedPnL(0)
+        , unrealizedPnL(0)
         , totalBought(0)
         , totalSold(0)
     {}
@@ -35,9 +39,9 @@ struct Position {
     Position(const Symbol& sym)
         : symbol(sym)
         , quantity(0)
-        , averagePrice(0.0)
-        , realizedPnL(0.0)
-        , unrealizedPnL(0.0)
+        , costBasis(0)
+        , realizedPnL(0)
+        , unrealizedPnL(0)
         , totalBought(0)
         , totalSold(0)
     {}
@@ -46,52 +50,110 @@ struct Position {
     bool isLong() const { return quantity > 0; }
     bool isShort() const { return quantity < 0; }
 
-    double getMarketValue(double currentPrice) const {
-        return std::abs(quantity) * currentPrice;
+    // Average entry price, truncated to the price tick
+    Price getAveragePrice() const {
+        return quantity == 0 ? 0 : costBasis / quantity;
     }
 
-    void updateUnrealizedPnL(double currentPrice) {
-        if (quantity == 0) {
-            unrealizedPnL = 0.0;
+    Notional getMarketValue(Price currentPrice) const {
+        return notionalOf(currentPrice, static_cast<Quantity>(std::abs(quantity)));
+    }
+
+    void updateUnrealizedPnL(Price currentPrice) {
+        unrealizedPnL = currentPrice * quantity - costBasis;
+    }
+
+    /**
+     * Apply a fill and return the P&L it realized. Closing part of a
+     * position releases the same share of its cost basis, so a round trip
+     * realizes exactly its proceeds minus its cost however it was split.
+     */
+    Notional applyFill(Side side, Price price, Quantity qty) {
+        int64_t delta = static_cast<int64_t>(qty);
+        if (side == Side::BUY) {
+            totalBought += qty;
         } else {
-            unrealizedPnL = quantity * (currentPrice - averagePrice);
+            totalSold += qty;
+            delta = -delta;
         }
+
+        Notional realized = applyFill(quantity, costBasis, delta, price);
+        realizedPnL += realized;
+        return realized;
+    }
+
+    // The same rule on bare fields, for positions kept as columns
+    static Notional applyFill(int64_t& quantity, Notional& costBasis, int64_t delta, Price price) {
+        Notional realized = 0;
+        if ((quantity > 0 && delta < 0) || (quantity < 0 && delta > 0)) {
+            int64_t open = std::abs(quantity);
+            int64_t closing = std::min(std::abs(delta), open);
+            Notional released = static_cast<Notional>(
+                static_cast<WideNotional>(costBasis) * closing / open);
+            int64_t closed = quantity > 0 ? -closing : closing;
+
+            realized = -(price * closed) - released;
+            costBasis -= released;
+            quantity += closed;
+            delta -= closed;
+        }
+
+        // Whatever is left opens or adds to the position
+        costBasis += price * delta;
+        quantity += delta;
+        return realized;
     }
 };
 
+// quantity * price > limit, without overflow for any quantity
+inline bool exceedsNotional(Quantity quantity, Price price, Notional limit) {
+    return static_cast<WideNotional>(quantity) * price > limit;
+}
+
 /**
  * RiskLimits defines trading constraints.
  */
 struct RiskLimits {
     Quantity maxOrderSize;          // Max single order quantity
-    double maxOrderValue;            // Max single order value ($)
+    Notional maxOrderValue;         // Max single order value
     int64_t maxPositionSize;        // Max position (long or short)
-    double maxPositionValue;         // Max position value ($)
-    double maxDailyLoss;             // Max loss per day ($)
-    double maxDrawdown;              // Max drawdown from peak ($)
-    int maxOrdersPerSecond;          // Rate limit
+    Notional maxPositionValue;      // Max position value
+    Notional maxDailyLoss;          // Max loss per day
+    Notional maxDrawdown;           // Max drawdown from peak
+    int maxOrdersPerSecond;          // Rate limit, 0 = none
+    int maxOrderBurst;               // Orders allowed back to back, 0 = one second's worth
 
     RiskLimits()
         : maxOrderSize(10000)
-        , maxOrderValue(1000000.0)
+        , maxOrderValue(doubleToNotional(1000000.0))
         , maxPositionSize(50000)
-        , maxPositionValue(5000000.0)
-        , maxDailyLoss(100000.0)
-        , maxDrawdown(200000.0)
-        , maxOrdersPerSecond(100)
+        , maxPositionValue(doubleToNotional(5000000.0))
+        , maxDailyLoss(doubleToNotional(100000.0))
+        , maxDrawdown(doubleToNotional(200000.0))
+        , maxOrdersPerSecond(0)  // Opt in: gateways set their own rate
+        , maxOrderBurst(0)
     {}
+
+    uint32_t getOrderBurst() const {
+        return static_cast<uint32_t>(maxOrderBurst > 0 ? maxOrderBurst
+                                                       : std::max(maxOrdersPerSecond, 1));
+    }
 };
 
 /**
- * RiskManager enforces trading limits and tracks positions.
+ * RiskManager enforces trading limits and tracks positions for a single
+ * book of trades. Not thread-safe; for per-account checks inside an
+ * engine shard see RiskShard (risk_shard.hpp).
  */
 class RiskManager {
 public:
     explicit RiskManager(const RiskLimits& limits = RiskLimits())
         : limits_(limits)
-        , dailyPnL_(0.0)
-        , peakEquity_(0.0)
-        , currentEquity_(0.0)
+        , dailyPnL_(0)
+        , unrealizedPnL_(0)
+        , peakEquity_(0)
+        , currentEquity_(0)
+        , orderRate_(limits.maxOrdersPerSecond, limits.getOrderBurst())
     {}
 
     /**
@@ -105,55 +167,17 @@ public:
         REJECTED_POSITION_VALUE,
         REJECTED_DAILY_LOSS,
         REJECTED_DRAWDOWN,
-        REJECTED_RATE_LIMIT
+        REJECTED_RATE_LIMIT,
+        REJECTED_ACCOUNT_LIMIT  // RiskShard: no room to track another account
     };
 
-    ValidationResult validateOrder(const Order& order, double currentPrice = 0.0) {
-        // Check order size
-        if (order.getQuantity() > limits_.maxOrderSize) {
-            return ValidationResult::REJECTED_ORDER_SIZE;
-        }
-
-        // Check order value
-        double orderPrice = (order.getType() == OrderType::MARKET) ? 
-                           currentPrice : priceToDouble(order.getPrice());
-        double orderValue = order.getQuantity() * orderPrice;
-        
-        if (orderValue > limits_.maxOrderValue) {
-            return ValidationResult::REJECTED_ORDER_VALUE;
-        }
-
-        // Check position limits
-        auto& position = positions_[order.getSymbol()];
-        int64_t newQuantity = position.quantity;
-        
-        if (order.getSide() == Side::BUY) {
-            newQuantity += order.getQuantity();
-        } else {
-            newQuantity -= order.getQuantity();
-        }
-
-        if (std::abs(newQuantity) > limits_.maxPositionSize) {
-            return ValidationResult::REJECTED_POSITION_LIMIT;
-        }
-
-        double newPositionValue = std::abs(newQuantity) * orderPrice;
-        if (newPositionValue > limits_.maxPositionValue) {
-            return ValidationResult::REJECTED_POSITION_VALUE;
-        }
-
-        // Check daily loss limit
-        if (dailyPnL_ < -limits_.maxDailyLoss) {
-            return ValidationResult::REJECTED_DAILY_LOSS;
-        }
-
-        // Check drawdown
-        double drawdown = peakEquity_ - currentEquity_;
-        if (drawdown > limits_.maxDrawdown) {
-            return ValidationResult::REJECTED_DRAWDOWN;
-        }
-
-        return ValidationResult::ACCEPTED;
+    ValidationResult validateOrder(const Order& order, Price currentPrice = 0) {
+        // Every order spends a token, accepted or not, so floods stay cheap
+        ValidationResult result = orderRate_.tryAcquire()
+                                      ? checkOrder(order, currentPrice)
+                                      : ValidationResult::REJECTED_RATE_LIMIT;
+        TRACE_STAGE(RISK_CHECK);
+        return result;
     }
 
     /**
@@ -167,66 +191,11 @@ public:
             position.symbol = symbol;
         }
 
-        double tradePrice = priceToDouble(trade.getPrice());
-        Quantity tradeQty = trade.getQuantity();
-
-        // Determine if this is a buy or sell for position tracking
-        bool isBuy = (aggressorSide == Side::BUY);
-
-        if (isBuy) {
-            position.totalBought += tradeQty;
-            
-            if (position.quantity >= 0) {
-                // Adding to long or opening long
-                position.averagePrice = 
-                    (position.quantity * position.averagePrice + tradeQty * tradePrice) /
-                    (position.quantity + tradeQty);
-                position.quantity += tradeQty;
-            } else {
-                // Covering short
-                int64_t closingQty = std::min(static_cast<int64_t>(tradeQty), 
-                                              std::abs(position.quantity));
-                double pnl = closingQty * (position.averagePrice - tradePrice);
-                position.realizedPnL += pnl;
-                dailyPnL_ += pnl;
-                
-                position.quantity += tradeQty;
-                
-                if (position.quantity > 0) {
-                    // Flipped to long
-                    position.averagePrice = tradePrice;
-                }
-            }
-        } else {
-            position.totalSold += tradeQty;
-            
-            if (position.quantity <= 0) {
-                // Adding to short or opening short
-                position.averagePrice = 
-                    (std::abs(position.quantity) * position.averagePrice + tradeQty * tradePrice) /
-                    (std::abs(position.quantity) + tradeQty);
-                position.quantity -= tradeQty;
-            } else {
-                // Closing long
-                int64_t closingQty = std::min(static_cast<int64_t>(tradeQty), position.quantity);
-                double pnl = closingQty * (tradePrice - position.averagePrice);
-                position.realizedPnL += pnl;
-                dailyPnL_ += pnl;
-                
-                position.quantity -= tradeQty;
-                
-                if (position.quantity < 0) {
-                    // Flipped to short
-                    position.averagePrice = tradePrice;
-                }
-            }
-        }
+        // The aggressor's side decides whether this book bought or sold
+        dailyPnL_ += position.applyFill(aggressorSide, trade.getPrice(), trade.getQuantity());
 
-        // Update equity
-        currentEquity_ = dailyPnL_;
-        for (auto& [sym, pos] : positions_) {
-            currentEquity_ += pos.unrealizedPnL;
-        }
+        // Update equity from the running unrealized total
+        currentEquity_ = dailyPnL_ + unrealizedPnL_;
         
         if (currentEquity_ > peakEquity_) {
             peakEquity_ = currentEquity_;
@@ -236,10 +205,12 @@ public:
     /**
      * Update unrealized P&L for all positions.
      */
-    void updateUnrealizedPnL(const Symbol& symbol, double currentPrice) {
+    void updateUnrealizedPnL(const Symbol& symbol, Price currentPrice) {
         auto it = positions_.find(symbol);
         if (it != positions_.end()) {
+            Notional before = it->second.unrealizedPnL;
             it->second.updateUnrealizedPnL(currentPrice);
+            unrealizedPnL_ += it->second.unrealizedPnL - before;
         }
     }
 
@@ -262,23 +233,19 @@ public:
     /**
      * Get total P&L.
      */
-    double getTotalPnL() const {
-        double total = dailyPnL_;
-        for (const auto& [symbol, position] : positions_) {
-            total += position.unrealizedPnL;
-        }
-        return total;
+    Notional getTotalPnL() const {
+        return dailyPnL_ + unrealizedPnL_;
     }
 
     /**
      * Get daily P&L.
      */
-    double getDailyPnL() const { return dailyPnL_; }
+    Notional getDailyPnL() const { return dailyPnL_; }
 
     /**
      * Get current drawdown.
      */
-    double getCurrentDrawdown() const {
+    Notional getCurrentDrawdown() const {
         return peakEquity_ - currentEquity_;
     }
 
@@ -286,9 +253,9 @@ public:
      * Reset daily statistics.
      */
     void resetDaily() {
-        dailyPnL_ = 0.0;
+        dailyPnL_ = 0;
         for (auto& [symbol, position] : positions_) {
-            position.realizedPnL = 0.0;
+            position.realizedPnL = 0;
         }
     }
 
@@ -300,7 +267,10 @@ public:
     /**
      * Set risk limits.
      */
-    void setLimits(const RiskLimits& limits) { limits_ = limits; }
+    void setLimits(const RiskLimits& limits) {
+        limits_ = limits;
+        orderRate_.configure(limits.maxOrdersPerSecond, limits.getOrderBurst());
+    }
 
     /**
      * String representation of validation result.
@@ -315,6 +285,7 @@ public:
             case ValidationResult::REJECTED_DAILY_LOSS: return "REJECTED: Daily loss limit exceeded";
             case ValidationResult::REJECTED_DRAWDOWN: return "REJECTED: Drawdown limit exceeded";
             case ValidationResult::REJECTED_RATE_LIMIT: return "REJECTED: Rate limit exceeded";
+            case ValidationResult::REJECTED_ACCOUNT_LIMIT: return "REJECTED: Account limit reached";
             default: return "UNKNOWN";
         }
     }
@@ -322,9 +293,57 @@ public:
 private:
     RiskLimits limits_;
     std::unordered_map<Symbol, Position> positions_;
-    double dailyPnL_;
-    double peakEquity_;
-    double currentEquity_;
+    Notional dailyPnL_;
+    Notional unrealizedPnL_;  // Sum of the positions' unrealized P&L
+    Notional peakEquity_;
+    Notional currentEquity_;
+    utils::TokenBucket orderRate_;  // maxOrdersPerSecond over all orders
+
+    // Limit checks proper; validateOrder wraps this to stamp the trace
+    ValidationResult checkOrder(const Order& order, Price currentPrice) const {
+        // Check order size
+        if (order.getQuantity() > limits_.maxOrderSize) {
+            return ValidationResult::REJECTED_ORDER_SIZE;
+        }
+
+        // Check order value
+        Price orderPrice = (order.getType() == OrderType::MARKET) ? 
+                           currentPrice : order.getPrice();
+        if (exceedsNotional(order.getQuantity(), orderPrice, limits_.maxOrderValue)) {
+            return ValidationResult::REJECTED_ORDER_VALUE;
+        }
+
+        // Check position limits; no entry yet means flat
+        auto it = positions_.find(order.getSymbol());
+        int64_t newQuantity = it != positions_.end() ? it->second.quantity : 0;
+        
+        if (order.getSide() == Side::BUY) {
+            newQuantity += order.getQuantity();
+        } else {
+            newQuantity -= order.getQuantity();
+        }
+
+        if (std::abs(newQuantity) > limits_.maxPositionSize) {
+            return ValidationResult::REJECTED_POSITION_LIMIT;
+        }
+
+        if (exceedsNotional(static_cast<Quantity>(std::abs(newQuantity)), orderPrice,
+                            limits_.maxPositionValue)) {
+            return ValidationResult::REJECTED_POSITION_VALUE;
+        }
+
+        // Check daily loss limit
+        if (dailyPnL_ < -limits_.maxDailyLoss) {
+            return ValidationResult::REJECTED_DAILY_LOSS;
+        }
+
+        // Check drawdown
+        if (peakEquity_ - currentEquity_ > limits_.maxDrawdown) {
+            return ValidationResult::REJECTED_DRAWDOWN;
+        }
+
+        return ValidationResult::ACCEPTED;
+    }
 };
 
 } // namespace risk
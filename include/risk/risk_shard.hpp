@@ -0,0 +1,254 @@
+#ifndef RISK_SHARD_HPP
+#define RISK_SHARD_HPP
+
+#include "core/types.hpp"
+#include "core/order.hpp"
+#include "core/trade.hpp"
+#include "risk/position_store.hpp"
+#include "risk/risk_manager.hpp"
+#include "utils/latency_trace.hpp"
+#include "utils/thread_pool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace trading {
+namespace risk {
+
+/**
+ * RiskShard - pre-trade checks and positions for every account trading
+ * the symbols of one engine shard.
+ *
+ * Symbols are fixed at construction and interned to small indices (a
+ * shard matches a handful, so lookup is a short scan with no hashing).
+ * Accounts are interned on first sight into a fixed-size open-addressed
+ * table. Positions live in a PositionStore, one column per field and
+ * symbol, and each account keeps running realized and unrealized totals,
+ * so a fill updates equity and drawdown in O(1), a check is a few loads
+ * and compares with no allocation, and marking a symbol is one SIMD pass
+ * over its accounts.
+ *
+ * A shard belongs to the thread that matches its symbols (see
+ * EngineRunner::enableRisk) and takes no locks. Loss and drawdown limits
+ * apply to an account's P&L within the shard. Order rates are limited at
+ * the gateway, before messages are parsed (see rate_limiter.hpp).
+ */
+class RiskShard {
+public:
+    using ValidationResult = RiskManager::ValidationResult;
+    using AccountRisk = PositionStore::AccountRisk;
+
+    static constexpr uint32_t NO_INDEX = UINT32_MAX;
+    static constexpr size_t DEFAULT_MAX_ACCOUNTS = 4096;
+    static constexpr size_t REVALUE_GRAIN = 1024;  // Accounts per parallel chunk
+
+    /**
+     * symbols: everything the owning shard matches.
+     * maxAccounts: accounts tracked, besides the slot for orders without
+     * one; orders from further accounts are rejected with
+     * REJECTED_ACCOUNT_LIMIT, as their exposure could not be recorded.
+     */
+    RiskShard(const std::vector<Symbol>& symbols, const RiskLimits& limits = RiskLimits(),
+              size_t maxAccounts = DEFAULT_MAX_ACCOUNTS)
+        : limits_(limits)
+        , symbols_(symbols)
+        , maxAccounts_(std::max<size_t>(maxAccounts, 1))
+        , store_(symbols.size(), maxAccounts_ + 1)
+    {
+        size_t slots = 1;
+        while (slots < maxAccounts_ * 2) slots <<= 1;
+        slotMask_ = slots - 1;
+        slotKeys_.assign(slots, 0);
+        slotIndices_.assign(slots, NO_INDEX);
+
+        // Index 0 is orders without an account
+        store_.addAccount(0);
+    }
+
+    ValidationResult validateOrder(const Order& order, Price currentPrice = 0) {
+        ValidationResult result = checkOrder(order, currentPrice);
+        TRACE_STAGE(RISK_CHECK);
+        return result;
+    }
+
+    /**
+     * Apply a fill to both counterparties. Trades in symbols the shard
+     * does not hold are ignored.
+     */
+    void onTrade(const Trade& trade) {
+        uint32_t symbol = symbolIndex(trade.getSymbol());
+        if (symbol == NO_INDEX) return;
+
+        Price price = trade.getPrice();
+        uint32_t buyer = internAccount(trade.getBuyAccountId());
+        uint32_t seller = internAccount(trade.getSellAccountId());
+        if (buyer != NO_INDEX) {
+            store_.applyFill(buyer, symbol, Side::BUY, price, trade.getQuantity());
+        }
+        if (seller != NO_INDEX) {
+            store_.applyFill(seller, symbol, Side::SELL, price, trade.getQuantity());
+        }
+    }
+
+    /**
+     * Revalue every account's position in `symbol` at `price`, e.g. the
+     * mid when the BBO moves. Proportional to the number of accounts;
+     * call once per batch, not per trade.
+     */
+    void markToMarket(const Symbol& symbol, Price price) {
+        uint32_t index = symbolIndex(symbol);
+        if (index == NO_INDEX) return;
+        store_.markSymbol(index, price);
+    }
+
+    // Record a mark for the next revalueAll() without revaluing now
+    void setMark(const Symbol& symbol, Price price) {
+        uint32_t index = symbolIndex(symbol);
+        if (index == NO_INDEX) return;
+        store_.setMark(index, price);
+    }
+
+    /**
+     * Revalue every position at the current marks and rebuild each
+     * account's totals, for end-of-interval risk after setMark() on the
+     * symbols that moved. With a pool, accounts are split across its
+     * threads; the call returns once all of them are done.
+     */
+    void revalueAll(utils::ThreadPool* pool = nullptr) {
+        size_t accounts = store_.getAccountCount();
+        if (!pool) {
+            store_.revalue(0, accounts);
+            return;
+        }
+        pool->parallelFor(accounts, REVALUE_GRAIN, [this](size_t begin, size_t end) {
+            store_.revalue(begin, end);
+        });
+    }
+
+    // Interned index of one of the shard's symbols, NO_INDEX otherwise
+    uint32_t symbolIndex(const Symbol& symbol) const {
+        for (uint32_t i = 0; i < symbols_.size(); ++i) {
+            if (symbols_[i] == symbol) return i;
+        }
+        return NO_INDEX;
+    }
+
+    // Lookup without interning; NO_INDEX if the account has not traded here
+    uint32_t findAccount(AccountId accountId) const {
+        if (accountId == 0) return 0;
+        for (size_t slot = hashSlot(accountId);; slot = (slot + 1) & slotMask_) {
+            if (slotKeys_[slot] == accountId) return slotIndices_[slot];
+            if (slotIndices_[slot] == NO_INDEX) return NO_INDEX;
+        }
+    }
+
+    // A copy assembled from the columns; flat if the account never traded it
+    Position getPosition(AccountId accountId, const Symbol& symbol) const {
+        uint32_t account = findAccount(accountId);
+        uint32_t index = symbolIndex(symbol);
+        if (account == NO_INDEX || index == NO_INDEX) return Position(symbol);
+        Position position = store_.getPosition(account, index);
+        position.symbol = symbol;
+        return position;
+    }
+
+    std::optional<AccountRisk> getAccount(AccountId accountId) const {
+        uint32_t account = findAccount(accountId);
+        if (account == NO_INDEX) return std::nullopt;
+        return store_.getAccount(account);
+    }
+
+    // Store rows: accounts interned so far plus the no-account slot
+    size_t getAccountCount() const { return store_.getAccountCount(); }
+    const std::vector<Symbol>& getSymbols() const { return symbols_; }
+    const PositionStore& getStore() const { return store_; }
+
+    void resetDaily() { store_.resetDaily(); }
+
+    const RiskLimits& getLimits() const { return limits_; }
+    void setLimits(const RiskLimits& limits) { limits_ = limits; }
+
+private:
+    RiskLimits limits_;
+    std::vector<Symbol> symbols_;
+    size_t maxAccounts_;
+    PositionStore store_;  // By interned account index
+
+    // Open-addressed AccountId -> index table; never shrinks
+    std::vector<AccountId> slotKeys_;
+    std::vector<uint32_t> slotIndices_;
+    size_t slotMask_;
+
+    size_t hashSlot(AccountId accountId) const {
+        return (static_cast<uint64_t>(accountId) * 0x9E3779B97F4A7C15ULL >> 32) & slotMask_;
+    }
+
+    // Every account slot taken; index 0 does not count against the limit
+    bool isFull() const { return store_.getAccountCount() > maxAccounts_; }
+
+    uint32_t internAccount(AccountId accountId) {
+        if (accountId == 0) return 0;
+        size_t slot = hashSlot(accountId);
+        for (; slotIndices_[slot] != NO_INDEX; slot = (slot + 1) & slotMask_) {
+            if (slotKeys_[slot] == accountId) return slotIndices_[slot];
+        }
+        if (isFull()) return NO_INDEX;
+
+        uint32_t index = store_.addAccount(accountId);
+        slotKeys_[slot] = accountId;
+        slotIndices_[slot] = index;
+        return index;
+    }
+
+    ValidationResult checkOrder(const Order& order, Price currentPrice) const {
+        if (order.getQuantity() > limits_.maxOrderSize) {
+            return ValidationResult::REJECTED_ORDER_SIZE;
+        }
+
+        Price orderPrice = (order.getType() == OrderType::MARKET) ?
+                           currentPrice : order.getPrice();
+        if (exceedsNotional(order.getQuantity(), orderPrice, limits_.maxOrderValue)) {
+            return ValidationResult::REJECTED_ORDER_VALUE;
+        }
+
+        uint32_t symbol = symbolIndex(order.getSymbol());
+        uint32_t account = findAccount(order.getAccountId());
+        if (account == NO_INDEX && isFull()) {
+            return ValidationResult::REJECTED_ACCOUNT_LIMIT;
+        }
+
+        // An account not seen yet is flat
+        int64_t newQuantity = 0;
+        if (account != NO_INDEX && symbol != NO_INDEX) {
+            newQuantity = store_.getQuantity(account, symbol);
+        }
+        newQuantity += order.getSide() == Side::BUY ? static_cast<int64_t>(order.getQuantity())
+                                                    : -static_cast<int64_t>(order.getQuantity());
+
+        if (std::abs(newQuantity) > limits_.maxPositionSize) {
+            return ValidationResult::REJECTED_POSITION_LIMIT;
+        }
+        if (exceedsNotional(static_cast<Quantity>(std::abs(newQuantity)), orderPrice,
+                            limits_.maxPositionValue)) {
+            return ValidationResult::REJECTED_POSITION_VALUE;
+        }
+
+        if (account != NO_INDEX) {
+            if (store_.getRealizedPnL(account) < -limits_.maxDailyLoss) {
+                return ValidationResult::REJECTED_DAILY_LOSS;
+            }
+            if (store_.getDrawdown(account) > limits_.maxDrawdown) {
+                return ValidationResult::REJECTED_DRAWDOWN;
+            }
+        }
+
+        return ValidationResult::ACCEPTED;
+    }
+};
+
+} // namespace risk
+} // namespace trading
+
+#endif // RISK_SHARD_HPP
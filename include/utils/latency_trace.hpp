@@ -0,0 +1,323 @@
+#ifndef LATENCY_TRACE_HPP
+#define LATENCY_TRACE_HPP
+
+#include "utils/timer.hpp"
+#include "utils/metrics.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+
+namespace trading {
+namespace utils {
+
+/**
+ * Pipeline stages of one inbound message, in order.
+ * Each stamp marks the moment the stage *completed*.
+ */
+enum class TraceStage : uint8_t {
+    SOCKET_READ = 0,  // Bytes returned by recv()
+    PARSE = 1,        // FIXMessage::parse done
+    RISK_CHECK = 2,   // RiskManager::validateOrder done
+    MATCH = 3,        // MatchingEngine::submitOrder done, or its first update via EngineRunner
+    SEND = 4,         // First TCPServer::sendMessage (the execution report)
+    COUNT = 5
+};
+
+/**
+ * TraceRecord - fixed-size TSC stamps for one message.
+ * Written verbatim to the binary dump, so keep it trivially copyable.
+ */
+struct TraceRecord {
+    static constexpr size_t NUM_STAGES = static_cast<size_t>(TraceStage::COUNT);
+
+    uint64_t traceId;
+    uint64_t tsc[NUM_STAGES];
+    uint32_t stageMask;   // Bit i set when tsc[i] is valid
+    uint32_t reserved;
+
+    bool has(TraceStage stage) const {
+        return (stageMask >> static_cast<uint32_t>(stage)) & 1u;
+    }
+};
+
+static_assert(sizeof(TraceRecord) == 56, "TraceRecord layout is part of the dump format");
+
+/**
+ * LatencyTracer aggregates per-stage latency of traced messages into
+ * SystemMetrics histograms and keeps a ring of sampled full traces that
+ * can be dumped to a binary file for offline analysis.
+ *
+ * Dump format (little endian):
+ *   char     magic[4]      "HPTT"
+ *   uint32_t version       1
+ *   uint32_t recordSize    sizeof(TraceRecord)
+ *   uint32_t stageCount
+ *   double   tscTicksPerNano
+ *   uint64_t recordCount
+ *   TraceRecord records[recordCount]
+ */
+class LatencyTracer {
+public:
+    static constexpr size_t DEFAULT_SAMPLE_CAPACITY = 65536;  // Power of 2
+
+    static LatencyTracer& getInstance() {
+        static LatencyTracer instance;
+        return instance;
+    }
+
+    void setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+    bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    // Keep one full trace out of every `rate` messages (0 disables sampling)
+    void setSampleRate(uint32_t rate) { sampleRate_.store(rate, std::memory_order_relaxed); }
+
+    /**
+     * Trace currently active on this thread, or nullptr.
+     * Library code stamps through this, so untraced paths pay one TLS load.
+     */
+    static TraceRecord*& current() {
+        static thread_local TraceRecord* record = nullptr;
+        return record;
+    }
+
+    // First stamp of a stage wins (e.g. the exec report, not later broadcasts)
+    static void stamp(TraceStage stage) {
+        TraceRecord* record = current();
+        if (record && !record->has(stage)) {
+            record->tsc[static_cast<size_t>(stage)] = rdtsc();
+            record->stageMask |= 1u << static_cast<uint32_t>(stage);
+        }
+    }
+
+    /**
+     * Move this thread's trace into `out` to be carried to the next stage
+     * (e.g. in a ring slot) and resumed there with TraceResume. Stamps on
+     * this thread stop, and its TraceScope no longer aggregates it.
+     * Leaves `out` empty (no stages) when nothing is being traced.
+     */
+    static bool detach(TraceRecord& out) {
+        TraceRecord*& record = current();
+        if (!record) {
+            out.stageMask = 0;
+            return false;
+        }
+        out = *record;
+        record = nullptr;
+        return true;
+    }
+
+    /**
+     * Aggregate a completed trace. Called on the thread that owns it.
+     */
+    void complete(const TraceRecord& record) {
+        SystemMetrics& metrics = SystemMetrics::getInstance();
+
+        size_t previous = TraceRecord::NUM_STAGES;
+        size_t first = TraceRecord::NUM_STAGES;
+        for (size_t i = 0; i < TraceRecord::NUM_STAGES; ++i) {
+            if (!record.has(static_cast<TraceStage>(i))) continue;
+            if (first == TraceRecord::NUM_STAGES) first = i;
+            if (previous != TraceRecord::NUM_STAGES) {
+                metrics.recordLatency(STAGE_HISTOGRAMS[i],
+                                      tscToNanos(record.tsc[i] - record.tsc[previous]));
+            }
+            previous = i;
+        }
+
+        if (previous != first) {
+            metrics.recordLatency(SystemMetrics::Histogram::END_TO_END,
+                                  tscToNanos(record.tsc[previous] - record.tsc[first]));
+        }
+
+        uint32_t rate = sampleRate_.load(std::memory_order_relaxed);
+        if (rate != 0 && record.traceId % rate == 0) {
+            storeSample(record);
+        }
+    }
+
+    uint64_t nextTraceId() {
+        return nextTraceId_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Write sampled traces (oldest first) to a binary file.
+     * Slots being overwritten while the dump runs are skipped.
+     */
+    bool dumpSamples(const std::string& filename) const {
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        uint64_t end = writeIndex_.load(std::memory_order_acquire);
+        uint64_t begin = end > capacity_ ? end - capacity_ : 0;
+
+        std::unique_ptr<TraceRecord[]> records(new TraceRecord[end - begin]);
+        uint64_t count = 0;
+        for (uint64_t i = begin; i < end; ++i) {
+            if (readSample(i, records[count])) ++count;
+        }
+
+        const char magic[4] = {'H', 'P', 'T', 'T'};
+        uint32_t version = 1;
+        uint32_t recordSize = sizeof(TraceRecord);
+        uint32_t stageCount = TraceRecord::NUM_STAGES;
+        double ticksPerNano = tscTicksPerNano();
+
+        file.write(magic, sizeof(magic));
+        file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+        file.write(reinterpret_cast<const char*>(&recordSize), sizeof(recordSize));
+        file.write(reinterpret_cast<const char*>(&stageCount), sizeof(stageCount));
+        file.write(reinterpret_cast<const char*>(&ticksPerNano), sizeof(ticksPerNano));
+        file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        file.write(reinterpret_cast<const char*>(records.get()),
+                   static_cast<std::streamsize>(count * sizeof(TraceRecord)));
+
+        return file.good();
+    }
+
+    uint64_t getSampledCount() const {
+        return writeIndex_.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr SystemMetrics::Histogram STAGE_HISTOGRAMS[TraceRecord::NUM_STAGES] = {
+        SystemMetrics::Histogram::END_TO_END,  // SOCKET_READ starts the trace, never a delta
+        SystemMetrics::Histogram::STAGE_PARSE,
+        SystemMetrics::Histogram::STAGE_RISK_CHECK,
+        SystemMetrics::Histogram::STAGE_MATCH,
+        SystemMetrics::Histogram::STAGE_SEND
+    };
+
+    // Sample slot guarded by a sequence number: odd while being written
+    struct SampleSlot {
+        std::atomic<uint64_t> sequence{0};
+        TraceRecord record{};
+    };
+
+    LatencyTracer()
+        : enabled_(true)
+        , sampleRate_(1024)
+        , nextTraceId_(1)
+        , writeIndex_(0)
+        , capacity_(DEFAULT_SAMPLE_CAPACITY)
+        , samples_(new SampleSlot[DEFAULT_SAMPLE_CAPACITY])
+    {
+        tscTicksPerNano();  // Calibrate up front, off the hot path
+    }
+
+    std::atomic<bool> enabled_;
+    std::atomic<uint32_t> sampleRate_;
+    alignas(64) std::atomic<uint64_t> nextTraceId_;
+    alignas(64) std::atomic<uint64_t> writeIndex_;
+    const uint64_t capacity_;
+    std::unique_ptr<SampleSlot[]> samples_;
+
+    void storeSample(const TraceRecord& record) {
+        uint64_t index = writeIndex_.fetch_add(1, std::memory_order_relaxed);
+        SampleSlot& slot = samples_[index & (capacity_ - 1)];
+
+        uint64_t seq = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&slot.record, &record, sizeof(TraceRecord));
+        slot.sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    bool readSample(uint64_t index, TraceRecord& out) const {
+        const SampleSlot& slot = samples_[index & (capacity_ - 1)];
+
+        uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before & 1) return false;
+        std::memcpy(&out, &slot.record, sizeof(TraceRecord));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.sequence.load(std::memory_order_relaxed) == before;
+    }
+};
+
+/**
+ * RAII trace scope: stamps SOCKET_READ, installs itself as the thread's
+ * current trace, and aggregates the record when it goes out of scope,
+ * unless it was detached to another thread meanwhile. With `enabled`
+ * false (or the tracer disabled) it does nothing.
+ */
+class TraceScope {
+public:
+    explicit TraceScope(bool enabled = true)
+        : active_(enabled && LatencyTracer::getInstance().isEnabled())
+        , previous_(LatencyTracer::current())
+    {
+        if (!active_) return;
+
+        record_.traceId = LatencyTracer::getInstance().nextTraceId();
+        record_.stageMask = 0;
+        record_.reserved = 0;
+        LatencyTracer::current() = &record_;
+        LatencyTracer::stamp(TraceStage::SOCKET_READ);
+    }
+
+    ~TraceScope() {
+        if (!active_) return;
+
+        bool detached = LatencyTracer::current() != &record_;
+        LatencyTracer::current() = previous_;
+        if (!detached) {
+            LatencyTracer::getInstance().complete(record_);
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    const TraceRecord& getRecord() const { return record_; }
+
+private:
+    bool active_;
+    TraceRecord* previous_;
+    TraceRecord record_;
+};
+
+/**
+ * RAII resume of a detached trace on a later stage's thread: stamps land
+ * in `record` while the scope lives. The last stage passes finish = true
+ * to aggregate the record when the scope ends. Empty records are ignored.
+ */
+class TraceResume {
+public:
+    explicit TraceResume(TraceRecord& record, bool finish = false)
+        : record_(record.stageMask != 0 ? &record : nullptr)
+        , finish_(finish)
+        , previous_(LatencyTracer::current())
+    {
+        if (record_) LatencyTracer::current() = record_;
+    }
+
+    ~TraceResume() {
+        if (!record_) return;
+
+        LatencyTracer::current() = previous_;
+        if (finish_) {
+            LatencyTracer::getInstance().complete(*record_);
+        }
+    }
+
+    TraceResume(const TraceResume&) = delete;
+    TraceResume& operator=(const TraceResume&) = delete;
+
+private:
+    TraceRecord* record_;
+    bool finish_;
+    TraceRecord* previous_;
+};
+
+// Convenience macro for pipeline stage stamps
+#define TRACE_STAGE(stage) \
+    trading::utils::LatencyTracer::stamp(trading::utils::TraceStage::stage)
+
+} // namespace utils
+} // namespace trading
+
+#endif // LATENCY_TRACE_HPP
@@ -0,0 +1,189 @@
+#ifndef MEMORY_ARENA_HPP
+#define MEMORY_ARENA_HPP
+
+#include "utils/config.hpp"
+#include "utils/logger.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace trading {
+namespace utils {
+
+/**
+ * Arena sizing and paging, normally read from the configuration:
+ *
+ *   memory.arena_mb=256     bytes reserved up front
+ *   memory.huge_pages=true  try MAP_HUGETLB, then the transparent hugepage hint
+ *   memory.lock=true        mlock the arena so it is never paged out
+ */
+struct ArenaSettings {
+    size_t bytes = 64 * 1024 * 1024;
+    bool hugePages = true;
+    bool lock = true;
+
+    static ArenaSettings fromConfig(const std::string& prefix,
+                                    const Config& config = Config::getInstance()) {
+        ArenaSettings settings;
+        int megabytes = config.getInt(prefix + ".arena_mb",
+                                      static_cast<int>(settings.bytes >> 20));
+        if (megabytes > 0) settings.bytes = static_cast<size_t>(megabytes) << 20;
+        settings.hugePages = config.getBool(prefix + ".huge_pages", settings.hugePages);
+        settings.lock = config.getBool(prefix + ".lock", settings.lock);
+        return settings;
+    }
+};
+
+/**
+ * MemoryArena - one region reserved and pre-faulted at startup.
+ *
+ * The region is mapped once (explicit hugepages if the host has them,
+ * otherwise normal pages with the transparent hugepage hint), populated,
+ * locked, and touched page by page, so every later allocation from it is
+ * a pointer bump on memory that is already resident and TLB-friendly.
+ * Pools carve their blocks from it (see MemoryPool); nothing is returned
+ * to the arena until it is destroyed.
+ *
+ * allocate() is lock-free and may be called from any thread. It returns
+ * nullptr once the region is used up; callers fall back to the heap.
+ */
+class MemoryArena {
+public:
+    static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    struct Stats {
+        size_t capacity;
+        size_t used;
+        bool hugePages;  // Backed by MAP_HUGETLB pages
+        bool locked;     // mlock succeeded
+    };
+
+    explicit MemoryArena(const ArenaSettings& settings = ArenaSettings())
+        : base_(nullptr)
+        , capacity_(0)
+        , used_(0)
+        , hugePages_(false)
+        , locked_(false)
+        , mapped_(false)
+    {
+        map(settings);
+    }
+
+    ~MemoryArena() {
+        if (!base_) return;
+#ifdef __linux__
+        if (mapped_) {
+            if (locked_) munlock(base_, capacity_);
+            munmap(base_, capacity_);
+            return;
+        }
+#endif
+        ::operator delete(base_, std::align_val_t(HUGE_PAGE_SIZE));
+    }
+
+    MemoryArena(const MemoryArena&) = delete;
+    MemoryArena& operator=(const MemoryArena&) = delete;
+
+    /**
+     * Carve `bytes` aligned to `alignment` (a power of two).
+     * Returns nullptr when the arena is exhausted.
+     */
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+        size_t offset = used_.load(std::memory_order_relaxed);
+        for (;;) {
+            size_t start = (offset + alignment - 1) & ~(alignment - 1);
+            if (start + bytes > capacity_) return nullptr;
+            if (used_.compare_exchange_weak(offset, start + bytes,
+                                            std::memory_order_relaxed)) {
+                return base_ + start;
+            }
+        }
+    }
+
+    bool owns(const void* ptr) const {
+        auto* p = static_cast<const unsigned char*>(ptr);
+        return p >= base_ && p < base_ + capacity_;
+    }
+
+    Stats getStats() const {
+        return {capacity_, used_.load(std::memory_order_relaxed), hugePages_, locked_};
+    }
+
+    size_t getCapacity() const { return capacity_; }
+    size_t getUsed() const { return used_.load(std::memory_order_relaxed); }
+
+private:
+    unsigned char* base_;
+    size_t capacity_;
+    std::atomic<size_t> used_;
+    bool hugePages_;
+    bool locked_;
+    bool mapped_;  // From mmap rather than the heap fallback
+
+    void map(const ArenaSettings& settings) {
+        // Whole hugepages, so the tail of the region is not a small page
+        capacity_ = (settings.bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+        if (capacity_ == 0) return;
+
+#ifdef __linux__
+        void* region = MAP_FAILED;
+        if (settings.hugePages) {
+            region = mmap(nullptr, capacity_, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+            hugePages_ = region != MAP_FAILED;
+        }
+        if (region == MAP_FAILED) {
+            // No hugepages reserved on the host: normal pages, asking the
+            // kernel to back them with transparent hugepages
+            region = mmap(nullptr, capacity_, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (region != MAP_FAILED && settings.hugePages) {
+                madvise(region, capacity_, MADV_HUGEPAGE);
+            }
+        }
+
+        if (region != MAP_FAILED) {
+            base_ = static_cast<unsigned char*>(region);
+            mapped_ = true;
+            if (settings.lock) {
+                // Locking also faults in every page
+                locked_ = mlock(base_, capacity_) == 0;
+                if (!locked_) {
+                    LOG_WARN("MemoryArena: mlock of ", capacity_ >> 20,
+                             " MB failed (RLIMIT_MEMLOCK?); pre-faulting only");
+                }
+            }
+        }
+#endif
+
+        if (!base_) {
+            base_ = static_cast<unsigned char*>(
+                ::operator new(capacity_, std::align_val_t(HUGE_PAGE_SIZE)));
+        }
+
+        prefault();
+    }
+
+    // Write every page so none is first touched during trading
+    void prefault() {
+        size_t pageSize = 4096;
+#ifdef __linux__
+        pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+        for (size_t offset = 0; offset < capacity_; offset += pageSize) {
+            reinterpret_cast<volatile unsigned char*>(base_)[offset] = 0;
+        }
+    }
+};
+
+} // namespace utils
+} // namespace trading
+
+#endif // MEMORY_ARENA_HPP
@@ -1,18 +1,60 @@
 #ifndef MEMORY_POOL_HPP
 #define MEMORY_POOL_HPP
 
+#include "utils/memory_arena.hpp"
+#include <array>
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <new>
 #include <atomic>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace trading {
 namespace utils {
 
+namespace detail {
+
+// Pool blocks come from the arena when one is given and has room
+template<typename Block>
+Block* createBlock(MemoryArena* arena) {
+    if (arena) {
+        if (void* memory = arena->allocate(sizeof(Block), alignof(Block))) {
+            Block* block = new (memory) Block();
+            block->fromArena = true;
+            return block;
+        }
+    }
+    return new Block();
+}
+
+template<typename Block>
+void destroyBlock(Block* block) {
+    if (block->fromArena) {
+        block->~Block();  // The arena releases the memory
+    } else {
+        delete block;
+    }
+}
+
+} // namespace detail
+
 /**
  * MemoryPool provides fast, thread-safe allocation for fixed-size objects.
  * Eliminates malloc/free overhead in critical paths.
+ *
+ * Any thread may allocate and free. The free list is a CAS stack whose
+ * head carries a change count next to the node pointer, so a pop that
+ * stalls while its node is taken and given back (ABA) fails its CAS
+ * rather than installing a stale next pointer.
+ *
+ * Given a MemoryArena, blocks are carved from its pre-faulted region;
+ * reserve() at startup then sizes the pool so trading never grows it.
+ * Blocks only come from the heap once the arena is exhausted, and
+ * getStats() reports how many did.
  */
 template<typename T, size_t BlockSize = 1024>
 class MemoryPool {
@@ -29,12 +71,19 @@ private:
     struct Block {
         Node nodes[BlockSize];
         Block* next;
+        bool fromArena;
         
-        Block() : next(nullptr) {}
+        Block() : next(nullptr), fromArena(false) {}
     };
 
 public:
-    MemoryPool() : head_(nullptr), blocks_(nullptr) {
+    explicit MemoryPool(MemoryArena* arena = nullptr)
+        : head_(0)
+        , blocks_(nullptr)
+        , arena_(arena)
+        , arenaBlocks_(0)
+        , heapBlocks_(0)
+    {
         allocateBlock();
     }
 
@@ -43,7 +92,7 @@ public:
         Block* current = blocks_;
         while (current) {
             Block* next = current->next;
-            delete current;
+            detail::destroyBlock(current);
             current = next;
         }
     }
@@ -57,13 +106,15 @@ public:
      * Returns nullptr if pool is exhausted (very rare with pre-allocation).
      */
     T* allocate() {
-        Node* node = head_.load(std::memory_order_acquire);
+        uint64_t head = head_.load(std::memory_order_acquire);
         
-        // Try to pop from free list (lock-free)
-        while (node != nullptr) {
+        // Try to pop from free list (lock-free). `next` may be stale if
+        // another thread took the node meanwhile; blocks stay mapped for
+        // the pool's lifetime, and the bumped count then fails the CAS.
+        while (Node* node = nodeOf(head)) {
             Node* next = node->next;
-            if (head_.compare_exchange_weak(node, next,
-                                           std::memory_order_release,
+            if (head_.compare_exchange_weak(head, retag(head, next),
+                                           std::memory_order_acq_rel,
                                            std::memory_order_acquire)) {
                 return &node->data;
             }
@@ -81,16 +132,26 @@ public:
         if (!ptr) return;
 
         Node* node = reinterpret_cast<Node*>(ptr);
-        Node* oldHead = head_.load(std::memory_order_acquire);
+        uint64_t head = head_.load(std::memory_order_acquire);
         
         // Push to free list (lock-free)
         do {
-            node->next = oldHead;
-        } while (!head_.compare_exchange_weak(oldHead, node,
+            node->next = nodeOf(head);
+        } while (!head_.compare_exchange_weak(head, retag(head, node),
                                              std::memory_order_release,
                                              std::memory_order_acquire));
     }
 
+    /**
+     * Grow the pool until it holds at least `count` objects. Call at
+     * startup so allocation during trading never needs a new block.
+     */
+    void reserve(size_t count) {
+        while (blockCount() * BlockSize < count) {
+            allocateBlock();
+        }
+    }
+
     /**
      * Construct object in-place.
      */
@@ -119,31 +180,54 @@ public:
     struct Stats {
         size_t blocksAllocated;
         size_t totalCapacity;
+        size_t arenaBlocks;  // Carved from the arena
+        size_t heapBlocks;   // Allocated with new (no arena, or arena full)
+        size_t bytesReserved;
     };
 
     Stats getStats() const {
-        size_t blockCount = 0;
-        Block* current = blocks_;
-        while (current) {
-            blockCount++;
-            current = current->next;
-        }
-        
-        return {blockCount, blockCount * BlockSize};
+        size_t arenaBlocks = arenaBlocks_.load(std::memory_order_relaxed);
+        size_t heapBlocks = heapBlocks_.load(std::memory_order_relaxed);
+        size_t blockCount = arenaBlocks + heapBlocks;
+        return {blockCount, blockCount * BlockSize, arenaBlocks, heapBlocks,
+                blockCount * sizeof(Block)};
     }
 
 private:
-    std::atomic<Node*> head_;  // Free list head
+    // Free list head: node address in the low 48 bits (all user-space
+    // addresses on x86-64 and AArch64), a count bumped by every push and
+    // pop in the high 16. One 64-bit CAS, so no 16-byte atomics needed.
+    static constexpr unsigned TAG_SHIFT = 48;
+    static constexpr uint64_t NODE_MASK = (uint64_t(1) << TAG_SHIFT) - 1;
+
+    static Node* nodeOf(uint64_t head) {
+        return reinterpret_cast<Node*>(static_cast<uintptr_t>(head & NODE_MASK));
+    }
+
+    static uint64_t retag(uint64_t head, Node* node) {
+        return (((head >> TAG_SHIFT) + 1) << TAG_SHIFT) |
+               static_cast<uint64_t>(reinterpret_cast<uintptr_t>(node));
+    }
+
+    std::atomic<uint64_t> head_;  // Free list head, tagged
     std::atomic<Block*> blocks_; // Block list head
+    MemoryArena* arena_;
+    std::atomic<size_t> arenaBlocks_;
+    std::atomic<size_t> heapBlocks_;
+
+    size_t blockCount() const {
+        return arenaBlocks_.load(std::memory_order_relaxed) +
+               heapBlocks_.load(std::memory_order_relaxed);
+    }
 
     void allocateBlock() {
-        Block* newBlock = new Block();
+        Block* newBlock = detail::createBlock<Block>(arena_);
+        (newBlock->fromArena ? arenaBlocks_ : heapBlocks_).fetch_add(1, std::memory_order_relaxed);
         
         // Initialize free list for this block
         for (size_t i = 0; i < BlockSize - 1; ++i) {
             newBlock->nodes[i].next = &newBlock->nodes[i + 1];
         }
-        newBlock->nodes[BlockSize - 1].next = head_.load(std::memory_order_acquire);
         
         // Add block to block list
         Block* oldBlocks = blocks_.load(std::memory_order_acquire);
@@ -153,75 +237,493 @@ private:
                                                std::memory_order_release,
                                                std::memory_order_acquire));
         
-        // Update free list head
-        head_.store(&newBlock->nodes[0], std::memory_order_release);
+        // Splice the block's nodes onto the free list; a CAS rather than a
+        // store, so nodes freed concurrently are not dropped
+        uint64_t head = head_.load(std::memory_order_acquire);
+        do {
+            newBlock->nodes[BlockSize - 1].next = nodeOf(head);
+        } while (!head_.compare_exchange_weak(head, retag(head, &newBlock->nodes[0]),
+                                             std::memory_order_release,
+                                             std::memory_order_acquire));
     }
 };
 
 /**
- * STL-compatible allocator wrapper for MemoryPool.
+ * LocalMemoryPool - single-owner pool for fixed-size objects.
+ *
+ * The owning thread (e.g. the matching thread) allocates and frees with
+ * plain pointer pushes and pops on a private free list: no atomics and
+ * no ABA on the hot path. Other threads that end up holding an object
+ * (a publisher or journal releasing an order) hand it back through
+ * deallocateRemote(), which pushes onto a lock-free stack. The owner
+ * takes that whole stack with one exchange when its own list runs dry,
+ * so remote frees are reclaimed in batches and are never popped one by
+ * one (which is why MemoryPool needs a tagged head and this does not).
+ */
+template<typename T, size_t BlockSize = 1024>
+class LocalMemoryPool {
+private:
+    union Node {
+        T data;
+        Node* next;
+
+        Node() {}
+        ~Node() {}
+    };
+
+    struct Block {
+        Node nodes[BlockSize];
+        Block* next;
+        bool fromArena;
+
+        Block() : next(nullptr), fromArena(false) {}
+    };
+
+public:
+    /**
+     * The constructing thread owns the pool until setOwner() is called
+     * from another thread. Blocks come from the arena while it has room.
+     */
+    explicit LocalMemoryPool(MemoryArena* arena = nullptr)
+        : freeList_(nullptr)
+        , blocks_(nullptr)
+        , arena_(arena)
+        , arenaBlocks_(0)
+        , heapBlocks_(0)
+        , remoteReclaimed_(0)
+        , owner_(std::this_thread::get_id())
+        , remoteHead_(nullptr)
+    {
+        allocateBlock();
+    }
+
+    ~LocalMemoryPool() {
+        Block* current = blocks_;
+        while (current) {
+            Block* next = current->next;
+            detail::destroyBlock(current);
+            current = next;
+        }
+    }
+
+    LocalMemoryPool(const LocalMemoryPool&) = delete;
+    LocalMemoryPool& operator=(const LocalMemoryPool&) = delete;
+
+    // Make the calling thread the owner (e.g. first thing on the matching thread)
+    void setOwner() {
+        owner_ = std::this_thread::get_id();
+    }
+
+    bool isOwner() const {
+        return std::this_thread::get_id() == owner_;
+    }
+
+    /**
+     * Allocate memory for one object. Owner thread only.
+     */
+    T* allocate() {
+        if (!freeList_ && reclaimRemote() == 0) {
+            allocateBlock();
+        }
+        Node* node = freeList_;
+        freeList_ = node->next;
+        return &node->data;
+    }
+
+    /**
+     * Return memory to the pool. Owner thread only.
+     */
+    void deallocate(T* ptr) {
+        if (!ptr) return;
+        Node* node = reinterpret_cast<Node*>(ptr);
+        node->next = freeList_;
+        freeList_ = node;
+    }
+
+    /**
+     * Return memory from any thread other than the owner.
+     */
+    void deallocateRemote(T* ptr) {
+        if (!ptr) return;
+        Node* node = reinterpret_cast<Node*>(ptr);
+        Node* oldHead = remoteHead_.load(std::memory_order_relaxed);
+        do {
+            node->next = oldHead;
+        } while (!remoteHead_.compare_exchange_weak(oldHead, node,
+                                                    std::memory_order_release,
+                                                    std::memory_order_relaxed));
+    }
+
+    // Either path, by thread; for deleters that run on an unknown thread
+    void release(T* ptr) {
+        if (isOwner()) {
+            deallocate(ptr);
+        } else {
+            deallocateRemote(ptr);
+        }
+    }
+
+    /**
+     * Move everything freed remotely onto the local free list. Owner
+     * thread only; called by allocate() when the local list is empty.
+     * Returns the number of objects reclaimed.
+     */
+    size_t reclaimRemote() {
+        Node* batch = remoteHead_.exchange(nullptr, std::memory_order_acquire);
+        if (!batch) return 0;
+
+        size_t count = 1;
+        Node* last = batch;
+        while (last->next) {
+            last = last->next;
+            count++;
+        }
+        last->next = freeList_;
+        freeList_ = batch;
+        remoteReclaimed_ += count;
+        return count;
+    }
+
+    // Grow until the pool holds at least `count` objects; owner thread only
+    void reserve(size_t count) {
+        while ((arenaBlocks_ + heapBlocks_) * BlockSize < count) {
+            allocateBlock();
+        }
+    }
+
+    template<typename... Args>
+    T* construct(Args&&... args) {
+        T* ptr = allocate();
+        new (ptr) T(std::forward<Args>(args)...);
+        return ptr;
+    }
+
+    // Owner thread only
+    void destroy(T* ptr) {
+        if (ptr) {
+            ptr->~T();
+            deallocate(ptr);
+        }
+    }
+
+    // Any thread other than the owner
+    void destroyRemote(T* ptr) {
+        if (ptr) {
+            ptr->~T();
+            deallocateRemote(ptr);
+        }
+    }
+
+    struct Stats {
+        size_t blocksAllocated;
+        size_t totalCapacity;
+        size_t arenaBlocks;      // Carved from the arena
+        size_t heapBlocks;       // Allocated with new (no arena, or arena full)
+        size_t bytesReserved;
+        size_t remoteReclaimed;  // Objects returned through the remote stack
+    };
+
+    // Owner thread only
+    Stats getStats() const {
+        size_t blockCount = arenaBlocks_ + heapBlocks_;
+        return {blockCount, blockCount * BlockSize, arenaBlocks_, heapBlocks_,
+                blockCount * sizeof(Block), remoteReclaimed_};
+    }
+
+private:
+    // Owner thread only
+    Node* freeList_;
+    Block* blocks_;
+    MemoryArena* arena_;
+    size_t arenaBlocks_;
+    size_t heapBlocks_;
+    size_t remoteReclaimed_;
+    std::thread::id owner_;
+
+    // Written by other threads; kept off the owner's cache line
+    alignas(64) std::atomic<Node*> remoteHead_;
+
+    void allocateBlock() {
+        Block* block = detail::createBlock<Block>(arena_);
+        (block->fromArena ? arenaBlocks_ : heapBlocks_)++;
+        for (size_t i = 0; i < BlockSize - 1; ++i) {
+            block->nodes[i].next = &block->nodes[i + 1];
+        }
+        block->nodes[BlockSize - 1].next = freeList_;
+        freeList_ = &block->nodes[0];
+
+        block->next = blocks_;
+        blocks_ = block;
+    }
+};
+
+/**
+ * SharedPool - shared_ptr<T> whose object and reference counts share one
+ * pooled slot (allocate_shared with a pool-backed allocator). Reserved
+ * from an arena, creating an object neither calls malloc nor touches a
+ * fresh page. Any thread may make objects, and slots go back to the pool
+ * from whichever thread drops the last reference (MemoryPool is safe for
+ * both), so the pool must outlive every pointer it hands out.
+ */
+template<typename T, size_t BlockSize = 1024>
+class SharedPool {
+private:
+    // Room for T plus the control block allocate_shared puts around it
+    struct alignas(alignof(T) > 16 ? alignof(T) : 16) Slot {
+        unsigned char bytes[sizeof(T) + 64];
+    };
+
+    using SlotPool = MemoryPool<Slot, BlockSize>;
+
+public:
+    using Stats = typename SlotPool::Stats;
+
+    template<typename U>
+    class Allocator {
+    public:
+        using value_type = U;
+
+        explicit Allocator(SlotPool* pool) noexcept : pool_(pool) {}
+
+        template<typename V>
+        Allocator(const Allocator<V>& other) noexcept : pool_(other.pool_) {}
+
+        U* allocate(size_t n) {
+            static_assert(sizeof(U) <= sizeof(Slot) && alignof(U) <= alignof(Slot),
+                          "SharedPool slot too small for the control block");
+            if (n != 1) throw std::bad_alloc();
+            return reinterpret_cast<U*>(pool_->allocate());
+        }
+
+        void deallocate(U* ptr, size_t) noexcept {
+            pool_->deallocate(reinterpret_cast<Slot*>(ptr));
+        }
+
+        template<typename V>
+        bool operator==(const Allocator<V>& other) const { return pool_ == other.pool_; }
+
+        template<typename V>
+        bool operator!=(const Allocator<V>& other) const { return pool_ != other.pool_; }
+
+    private:
+        template<typename> friend class Allocator;
+        SlotPool* pool_;
+    };
+
+    explicit SharedPool(MemoryArena* arena = nullptr) : pool_(arena) {}
+
+    template<typename... Args>
+    std::shared_ptr<T> make(Args&&... args) {
+        return std::allocate_shared<T>(Allocator<T>(&pool_), std::forward<Args>(args)...);
+    }
+
+    void reserve(size_t count) { pool_.reserve(count); }
+
+    Stats getStats() const { return pool_.getStats(); }
+
+private:
+    SlotPool pool_;
+};
+
+/**
+ * PoolResource - node memory for the containers of one owner (one order
+ * book or shard).
+ *
+ * Requests up to MAX_POOLED bytes - map nodes with their price levels,
+ * hash nodes, small bucket arrays - are served from per-size free lists
+ * (16-byte granules) carved out of CHUNK_SIZE chunks, so a book's nodes
+ * sit together in memory rather than interleaved with every other
+ * symbol's. Larger requests go to the heap. Destroying the resource
+ * releases every chunk at once; chunks carved from an arena stay with
+ * the arena.
+ *
+ * Not thread-safe: a resource and its containers belong to one thread.
+ */
+class PoolResource {
+public:
+    static constexpr size_t GRANULE = 16;
+    static constexpr size_t MAX_POOLED = 512;
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    struct Stats {
+        size_t chunks;
+        size_t arenaChunks;    // Carved from the arena
+        size_t bytesReserved;  // Chunk memory
+        size_t bytesInUse;     // Pooled bytes handed out and not yet returned
+        size_t heapBytes;      // Outstanding requests too large to pool
+    };
+
+    explicit PoolResource(MemoryArena* arena = nullptr)
+        : arena_(arena)
+        , chunks_(nullptr)
+        , cursor_(nullptr)
+        , chunkEnd_(nullptr)
+        , freeLists_{}
+        , stats_{}
+    {}
+
+    ~PoolResource() {
+        release();
+    }
+
+    PoolResource(const PoolResource&) = delete;
+    PoolResource& operator=(const PoolResource&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment) {
+        if (bytes == 0) bytes = 1;
+        if (bytes > MAX_POOLED || alignment > GRANULE) {
+            stats_.heapBytes += bytes;
+            return ::operator new(bytes, std::align_val_t(alignment));
+        }
+
+        size_t index = (bytes - 1) / GRANULE;
+        stats_.bytesInUse += (index + 1) * GRANULE;
+        FreeNode*& head = freeLists_[index];
+        if (head) {
+            FreeNode* node = head;
+            head = node->next;
+            return node;
+        }
+        return carve((index + 1) * GRANULE);
+    }
+
+    void deallocate(void* ptr, size_t bytes, size_t alignment) {
+        if (!ptr) return;
+        if (bytes == 0) bytes = 1;
+        if (bytes > MAX_POOLED || alignment > GRANULE) {
+            stats_.heapBytes -= bytes;
+            ::operator delete(ptr, std::align_val_t(alignment));
+            return;
+        }
+
+        size_t index = (bytes - 1) / GRANULE;
+        stats_.bytesInUse -= (index + 1) * GRANULE;
+        FreeNode* node = static_cast<FreeNode*>(ptr);
+        node->next = freeLists_[index];
+        freeLists_[index] = node;
+    }
+
+    /**
+     * Drop every chunk at once. Only once no container still holds
+     * memory from this resource (the destructor calls it).
+     */
+    void release() {
+        Chunk* chunk = chunks_;
+        while (chunk) {
+            Chunk* next = chunk->next;
+            if (!chunk->fromArena) {
+                ::operator delete(chunk, std::align_val_t(CHUNK_ALIGNMENT));
+            }
+            chunk = next;
+        }
+        chunks_ = nullptr;
+        cursor_ = chunkEnd_ = nullptr;
+        freeLists_.fill(nullptr);
+        stats_.chunks = stats_.arenaChunks = stats_.bytesReserved = stats_.bytesInUse = 0;
+    }
+
+    Stats getStats() const { return stats_; }
+
+private:
+    static constexpr size_t CHUNK_ALIGNMENT = 64;
+
+    struct FreeNode {
+        FreeNode* next;
+    };
+
+    struct Chunk {
+        Chunk* next;
+        bool fromArena;
+    };
+
+    static constexpr size_t CHUNK_HEADER = (sizeof(Chunk) + GRANULE - 1) & ~(GRANULE - 1);
+
+    MemoryArena* arena_;
+    Chunk* chunks_;
+    unsigned char* cursor_;    // Next uncarved byte of the current chunk
+    unsigned char* chunkEnd_;
+    std::array<FreeNode*, MAX_POOLED / GRANULE> freeLists_;
+    Stats stats_;
+
+    void* carve(size_t size) {
+        if (!cursor_ || cursor_ + size > chunkEnd_) {
+            newChunk();  // The old chunk's tail (< MAX_POOLED bytes) is left unused
+        }
+        void* ptr = cursor_;
+        cursor_ += size;
+        return ptr;
+    }
+
+    void newChunk() {
+        void* memory = arena_ ? arena_->allocate(CHUNK_SIZE, CHUNK_ALIGNMENT) : nullptr;
+        bool fromArena = memory != nullptr;
+        if (!memory) {
+            memory = ::operator new(CHUNK_SIZE, std::align_val_t(CHUNK_ALIGNMENT));
+        }
+
+        Chunk* chunk = new (memory) Chunk{chunks_, fromArena};
+        chunks_ = chunk;
+        cursor_ = static_cast<unsigned char*>(memory) + CHUNK_HEADER;
+        chunkEnd_ = static_cast<unsigned char*>(memory) + CHUNK_SIZE;
+
+        stats_.chunks++;
+        if (fromArena) stats_.arenaChunks++;
+        stats_.bytesReserved += CHUNK_SIZE;
+    }
+};
+
+/**
+ * STL-compatible allocator over a PoolResource. Stateful: each container
+ * allocates from the resource it was built with, so every book keeps its
+ * own pools. A null resource means the global heap.
  */
 template<typename T>
 class PoolAllocator {
 public:
     using value_type = T;
-    using pointer = T*;
-    using const_pointer = const T*;
-    using reference = T&;
-    using const_reference = const T&;
     using size_type = std::size_t;
     using difference_type = std::ptrdiff_t;
 
-    template<typename U>
-    struct rebind {
-        using other = PoolAllocator<U>;
-    };
+    // Containers sharing a resource swap and move-assign their memory freely
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
 
-    PoolAllocator() = default;
+    explicit PoolAllocator(PoolResource* resource = nullptr) noexcept
+        : resource_(resource) {}
     
     template<typename U>
-    PoolAllocator(const PoolAllocator<U>&) noexcept {}
+    PoolAllocator(const PoolAllocator<U>& other) noexcept
+        : resource_(other.resource()) {}
 
-    pointer allocate(size_type n) {
-        if (n != 1) {
-            return static_cast<pointer>(::operator new(n * sizeof(T)));
+    T* allocate(size_type n) {
+        if (!resource_) {
+            return static_cast<T*>(::operator new(n * sizeof(T)));
         }
-        return getPool().allocate();
+        return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T)));
     }
 
-    void deallocate(pointer p, size_type n) {
-        if (n != 1) {
+    void deallocate(T* p, size_type n) {
+        if (!resource_) {
             ::operator delete(p);
             return;
         }
-        getPool().deallocate(p);
-    }
-
-    template<typename U, typename... Args>
-    void construct(U* p, Args&&... args) {
-        new (p) U(std::forward<Args>(args)...);
+        resource_->deallocate(p, n * sizeof(T), alignof(T));
     }
 
-    template<typename U>
-    void destroy(U* p) {
-        p->~U();
-    }
+    PoolResource* resource() const noexcept { return resource_; }
 
 private:
-    static MemoryPool<T>& getPool() {
-        static MemoryPool<T> pool;
-        return pool;
-    }
+    PoolResource* resource_;
 };
 
 template<typename T, typename U>
-bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&) {
-    return true;
+bool operator==(const PoolAllocator<T>& a, const PoolAllocator<U>& b) {
+    return a.resource() == b.resource();
 }
 
 template<typename T, typename U>
-bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&) {
-    return false;
+bool operator!=(const PoolAllocator<T>& a, const PoolAllocator<U>& b) {
+    return a.resource() != b.resource();
 }
 
 } // namespace utils
@@ -1,72 +1,222 @@
 #ifndef METRICS_HPP
 #define METRICS_HPP
 
+#include "core/types.hpp"
 #include <atomic>
+#include <array>
 #include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <sstream>
 #include <iomanip>
+#include <vector>
 
 namespace trading {
 namespace utils {
 
+/**
+ * LatencyHistogram - fixed-bucket latency distribution.
+ * Bucket bounds follow the usual Prometheus latency ladder (in ns).
+ * Recording is single-writer; any thread may read.
+ */
+class LatencyHistogram {
+public:
+    static constexpr size_t NUM_BOUNDS = 13;
+    static constexpr size_t NUM_BUCKETS = NUM_BOUNDS + 1;  // Last bucket is +Inf
+
+    static constexpr std::array<uint64_t, NUM_BOUNDS> BOUNDS = {
+        100, 250, 500, 1000, 2500, 5000, 10000,
+        25000, 50000, 100000, 250000, 500000, 1000000
+    };
+
+    // Plain (non-atomic) copy of a histogram, used for reporting
+    struct Snapshot {
+        std::array<uint64_t, NUM_BUCKETS> buckets{};
+        uint64_t sum = 0;
+        uint64_t count = 0;
+
+        void add(const Snapshot& other) {
+            for (size_t i = 0; i < NUM_BUCKETS; ++i) buckets[i] += other.buckets[i];
+            sum += other.sum;
+            count += other.count;
+        }
+
+        void subtract(const Snapshot& other) {
+            for (size_t i = 0; i < NUM_BUCKETS; ++i) buckets[i] -= other.buckets[i];
+            sum -= other.sum;
+            count -= other.count;
+        }
+
+        // Approximate percentile (upper bound of the bucket containing it)
+        uint64_t percentile(double pct) const {
+            if (count == 0) return 0;
+            uint64_t target = static_cast<uint64_t>((pct / 100.0) * count);
+            if (target == 0) target = 1;
+            uint64_t seen = 0;
+            for (size_t i = 0; i < NUM_BOUNDS; ++i) {
+                seen += buckets[i];
+                if (seen >= target) return BOUNDS[i];
+            }
+            return BOUNDS[NUM_BOUNDS - 1];
+        }
+    };
+
+    static size_t bucketFor(uint64_t value) {
+        size_t index = 0;
+        while (index < NUM_BOUNDS && value > BOUNDS[index]) ++index;
+        return index;
+    }
+
+    // Single-writer record: plain load/store, no locked instructions
+    void record(uint64_t value) {
+        bump(buckets_[bucketFor(value)], 1);
+        bump(sum_, value);
+        bump(count_, 1);
+    }
+
+    Snapshot snapshot() const {
+        Snapshot snap;
+        for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+            snap.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+        }
+        snap.sum = sum_.load(std::memory_order_relaxed);
+        snap.count = count_.load(std::memory_order_relaxed);
+        return snap;
+    }
+
+private:
+    std::atomic<uint64_t> buckets_[NUM_BUCKETS] = {};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> count_{0};
+
+    static void bump(std::atomic<uint64_t>& cell, uint64_t delta) {
+        cell.store(cell.load(std::memory_order_relaxed) + delta,
+                   std::memory_order_relaxed);
+    }
+};
+
 /**
  * SystemMetrics tracks key performance indicators.
+ *
+ * Every recording thread owns a cache-line aligned block of counters and
+ * histograms, so the hot path does a plain load/store on thread-local data
+ * instead of a contended fetch_add. Readers (reports, Prometheus scrapes)
+ * sum the blocks; they never write to anything a recording thread touches.
  */
 class SystemMetrics {
 public:
+    enum class Counter : size_t {
+        ORDERS_SUBMITTED,
+        ORDERS_ACCEPTED,
+        ORDERS_REJECTED,
+        ORDERS_CANCELLED,
+        TRADES_EXECUTED,
+        VOLUME_TRADED,
+        VALUE_TRADED,         // Notional, same scale as Price
+        ERRORS,
+        WARNINGS,
+        CONNECTIONS_OPENED,
+        CONNECTIONS_CLOSED,
+        COUNT
+    };
+
+    enum class Histogram : size_t {
+        ORDER_LATENCY,
+        STAGE_PARSE,          // Pipeline stages, fed by LatencyTracer
+        STAGE_RISK_CHECK,
+        STAGE_MATCH,
+        STAGE_SEND,
+        END_TO_END,
+        COUNT
+    };
+
+    enum class Gauge : size_t {
+        QUEUE_DEPTH,
+        BID_LEVELS,
+        ASK_LEVELS,
+        COUNT
+    };
+
+    static constexpr size_t NUM_COUNTERS = static_cast<size_t>(Counter::COUNT);
+    static constexpr size_t NUM_HISTOGRAMS = static_cast<size_t>(Histogram::COUNT);
+    static constexpr size_t NUM_GAUGES = static_cast<size_t>(Gauge::COUNT);
+
     static SystemMetrics& getInstance() {
         static SystemMetrics instance;
         return instance;
     }
 
     // Order metrics
-    void recordOrderSubmitted() { ordersSubmitted_.fetch_add(1, std::memory_order_relaxed); }
-    void recordOrderAccepted() { ordersAccepted_.fetch_add(1, std::memory_order_relaxed); }
-    void recordOrderRejected() { ordersRejected_.fetch_add(1, std::memory_order_relaxed); }
-    void recordOrderCancelled() { ordersCancelled_.fetch_add(1, std::memory_order_relaxed); }
+    void recordOrderSubmitted() { increment(Counter::ORDERS_SUBMITTED); }
+    void recordOrderAccepted() { increment(Counter::ORDERS_ACCEPTED); }
+    void recordOrderRejected() { increment(Counter::ORDERS_REJECTED); }
+    void recordOrderCancelled() { increment(Counter::ORDERS_CANCELLED); }
 
     // Trade metrics
-    void recordTrade(uint64_t volume, double value) {
-        tradesExecuted_.fetch_add(1, std::memory_order_relaxed);
-        volumeTraded_.fetch_add(volume, std::memory_order_relaxed);
-        valueTraded_.fetch_add(static_cast<uint64_t>(value * 100), std::memory_order_relaxed);
+    void recordTrade(uint64_t volume, Notional value) {
+        ThreadCounters& local = localCounters();
+        local.bump(Counter::TRADES_EXECUTED, 1);
+        local.bump(Counter::VOLUME_TRADED, volume);
+        local.bump(Counter::VALUE_TRADED, static_cast<uint64_t>(value));
     }
 
     // Latency metrics
     void recordLatency(uint64_t latencyNs) {
-        totalLatency_.fetch_add(latencyNs, std::memory_order_relaxed);
-        latencyMeasurements_.fetch_add(1, std::memory_order_relaxed);
+        recordLatency(Histogram::ORDER_LATENCY, latencyNs);
+    }
+
+    void recordLatency(Histogram histogram, uint64_t latencyNs) {
+        localCounters().histograms[static_cast<size_t>(histogram)].record(latencyNs);
     }
 
     // Error metrics
-    void recordError() { errors_.fetch_add(1, std::memory_order_relaxed); }
-    void recordWarning() { warnings_.fetch_add(1, std::memory_order_relaxed); }
+    void recordError() { increment(Counter::ERRORS); }
+    void recordWarning() { increment(Counter::WARNINGS); }
 
     // Connection metrics
-    void recordConnectionEstablished() { 
-        connections_.fetch_add(1, std::memory_order_relaxed); 
+    void recordConnectionEstablished() { increment(Counter::CONNECTIONS_OPENED); }
+    void recordConnectionClosed() { increment(Counter::CONNECTIONS_CLOSED); }
+
+    // Gauges are last-value-wins, written by whichever thread owns the source
+    void setGauge(Gauge gauge, int64_t value) {
+        gauges_[static_cast<size_t>(gauge)].value.store(value, std::memory_order_relaxed);
     }
-    void recordConnectionClosed() { 
-        connections_.fetch_sub(1, std::memory_order_relaxed); 
+
+    int64_t getGauge(Gauge gauge) const {
+        return gauges_[static_cast<size_t>(gauge)].value.load(std::memory_order_relaxed);
     }
 
     // Getters
-    uint64_t getOrdersSubmitted() const { return ordersSubmitted_.load(); }
-    uint64_t getOrdersAccepted() const { return ordersAccepted_.load(); }
-    uint64_t getOrdersRejected() const { return ordersRejected_.load(); }
-    uint64_t getOrdersCancelled() const { return ordersCancelled_.load(); }
-    uint64_t getTradesExecuted() const { return tradesExecuted_.load(); }
-    uint64_t getVolumeTraded() const { return volumeTraded_.load(); }
-    double getValueTraded() const { return valueTraded_.load() / 100.0; }
-    uint64_t getErrors() const { return errors_.load(); }
-    uint64_t getWarnings() const { return warnings_.load(); }
-    int64_t getActiveConnections() const { return connections_.load(); }
+    uint64_t getOrdersSubmitted() const { return getCounter(Counter::ORDERS_SUBMITTED); }
+    uint64_t getOrdersAccepted() const { return getCounter(Counter::ORDERS_ACCEPTED); }
+    uint64_t getOrdersRejected() const { return getCounter(Counter::ORDERS_REJECTED); }
+    uint64_t getOrdersCancelled() const { return getCounter(Counter::ORDERS_CANCELLED); }
+    uint64_t getTradesExecuted() const { return getCounter(Counter::TRADES_EXECUTED); }
+    uint64_t getVolumeTraded() const { return getCounter(Counter::VOLUME_TRADED); }
+    double getValueTraded() const {
+        return notionalToDouble(static_cast<Notional>(getCounter(Counter::VALUE_TRADED)));
+    }
+    uint64_t getErrors() const { return getCounter(Counter::ERRORS); }
+    uint64_t getWarnings() const { return getCounter(Counter::WARNINGS); }
+
+    int64_t getActiveConnections() const {
+        Totals totals = collect();
+        return static_cast<int64_t>(totals.get(Counter::CONNECTIONS_OPENED)) -
+               static_cast<int64_t>(totals.get(Counter::CONNECTIONS_CLOSED));
+    }
+
+    uint64_t getCounter(Counter counter) const {
+        return collect().get(counter);
+    }
+
+    LatencyHistogram::Snapshot getHistogram(Histogram histogram) const {
+        return collect().histograms[static_cast<size_t>(histogram)];
+    }
 
     double getAverageLatency() const {
-        uint64_t measurements = latencyMeasurements_.load();
-        if (measurements == 0) return 0.0;
-        return static_cast<double>(totalLatency_.load()) / measurements;
+        return averageOf(getHistogram(Histogram::ORDER_LATENCY));
     }
 
     // Statistics
@@ -86,40 +236,40 @@ public:
     };
 
     Stats getStats() const {
-        auto now = std::chrono::steady_clock::now();
-        auto uptime = std::chrono::duration_cast<std::chrono::seconds>(
-            now - startTime_
-        ).count();
+        Totals totals = collect();
 
         return {
-            ordersSubmitted_.load(),
-            ordersAccepted_.load(),
-            ordersRejected_.load(),
-            ordersCancelled_.load(),
-            tradesExecuted_.load(),
-            volumeTraded_.load(),
-            getValueTraded(),
-            getAverageLatency(),
-            errors_.load(),
-            warnings_.load(),
-            connections_.load(),
-            static_cast<uint64_t>(uptime)
+            totals.get(Counter::ORDERS_SUBMITTED),
+            totals.get(Counter::ORDERS_ACCEPTED),
+            totals.get(Counter::ORDERS_REJECTED),
+            totals.get(Counter::ORDERS_CANCELLED),
+            totals.get(Counter::TRADES_EXECUTED),
+            totals.get(Counter::VOLUME_TRADED),
+            notionalToDouble(static_cast<Notional>(totals.get(Counter::VALUE_TRADED))),
+            averageOf(totals.histograms[static_cast<size_t>(Histogram::ORDER_LATENCY)]),
+            totals.get(Counter::ERRORS),
+            totals.get(Counter::WARNINGS),
+            static_cast<int64_t>(totals.get(Counter::CONNECTIONS_OPENED)) -
+                static_cast<int64_t>(totals.get(Counter::CONNECTIONS_CLOSED)),
+            getUptimeSeconds()
         };
     }
 
-    // Reset all metrics
+    /**
+     * Reset all metrics.
+     * Recording threads are never written to: the current totals become
+     * the new baseline and are subtracted from every subsequent read.
+     */
     void reset() {
-        ordersSubmitted_ = 0;
-        ordersAccepted_ = 0;
-        ordersRejected_ = 0;
-        ordersCancelled_ = 0;
-        tradesExecuted_ = 0;
-        volumeTraded_ = 0;
-        valueTraded_ = 0;
-        totalLatency_ = 0;
-        latencyMeasurements_ = 0;
-        errors_ = 0;
-        warnings_ = 0;
+        Totals current = collectRaw();
+        std::lock_guard<std::mutex> lock(registryMutex_);
+        Totals connections = baseline_;
+        baseline_ = current;
+        // Connections are a level, not a rate - keep open sockets counted
+        baseline_.counters[static_cast<size_t>(Counter::CONNECTIONS_OPENED)] =
+            connections.get(Counter::CONNECTIONS_OPENED);
+        baseline_.counters[static_cast<size_t>(Counter::CONNECTIONS_CLOSED)] =
+            connections.get(Counter::CONNECTIONS_CLOSED);
         startTime_ = std::chrono::steady_clock::now();
     }
 
@@ -127,7 +277,7 @@ public:
     std::string toString() const {
         auto stats = getStats();
         std::ostringstream oss;
-        
+
         oss << "\n========== SYSTEM METRICS ==========\n";
         oss << "Uptime:              " << formatUptime(stats.uptimeSeconds) << "\n";
         oss << "\nOrders:\n";
@@ -135,86 +285,259 @@ public:
         oss << "  Accepted:          " << stats.ordersAccepted << "\n";
         oss << "  Rejected:          " << stats.ordersRejected << "\n";
         oss << "  Cancelled:         " << stats.ordersCancelled << "\n";
-        
-        double acceptRate = (stats.ordersSubmitted > 0) ? 
+
+        double acceptRate = (stats.ordersSubmitted > 0) ?
             (100.0 * stats.ordersAccepted / stats.ordersSubmitted) : 0.0;
-        oss << "  Accept Rate:       " << std::fixed << std::setprecision(1) 
+        oss << "  Accept Rate:       " << std::fixed << std::setprecision(1)
             << acceptRate << "%\n";
-        
+
         oss << "\nTrades:\n";
         oss << "  Executed:          " << stats.tradesExecuted << "\n";
         oss << "  Volume:            " << stats.volumeTraded << " shares\n";
-        oss << "  Value:             $" << std::fixed << std::setprecision(2) 
+        oss << "  Value:             $" << std::fixed << std::setprecision(2)
             << stats.valueTraded << "\n";
-        
+
+        auto latency = getHistogram(Histogram::ORDER_LATENCY);
         oss << "\nPerformance:\n";
-        oss << "  Avg Latency:       " << std::fixed << std::setprecision(2) 
+        oss << "  Avg Latency:       " << std::fixed << std::setprecision(2)
             << (stats.averageLatency / 1000.0) << " µs\n";
-        
+        oss << "  P99 Latency:       <= " << std::fixed << std::setprecision(2)
+            << (latency.percentile(99) / 1000.0) << " µs\n";
+
         if (stats.uptimeSeconds > 0) {
             double ordersPerSec = static_cast<double>(stats.ordersSubmitted) / stats.uptimeSeconds;
             double tradesPerSec = static_cast<double>(stats.tradesExecuted) / stats.uptimeSeconds;
-            oss << "  Orders/sec:        " << std::fixed << std::setprecision(1) 
+            oss << "  Orders/sec:        " << std::fixed << std::setprecision(1)
                 << ordersPerSec << "\n";
-            oss << "  Trades/sec:        " << std::fixed << std::setprecision(1) 
+            oss << "  Trades/sec:        " << std::fixed << std::setprecision(1)
                 << tradesPerSec << "\n";
         }
-        
+
         oss << "\nConnections:\n";
         oss << "  Active:            " << stats.activeConnections << "\n";
-        
+
         oss << "\nErrors:\n";
         oss << "  Errors:            " << stats.errors << "\n";
         oss << "  Warnings:          " << stats.warnings << "\n";
-        
+
         oss << "====================================\n";
         return oss.str();
     }
 
+    /**
+     * Format in the Prometheus text exposition format (version 0.0.4).
+     */
+    std::string toPrometheus() const {
+        Totals totals = collect();
+        std::ostringstream oss;
+
+        for (size_t i = 0; i < NUM_COUNTERS; ++i) {
+            oss << "# HELP " << COUNTER_INFO[i].name << " " << COUNTER_INFO[i].help << "\n";
+            oss << "# TYPE " << COUNTER_INFO[i].name << " counter\n";
+            oss << COUNTER_INFO[i].name << " " << totals.counters[i] << "\n";
+        }
+
+        for (size_t i = 0; i < NUM_HISTOGRAMS; ++i) {
+            const char* name = HISTOGRAM_INFO[i].name;
+            const auto& hist = totals.histograms[i];
+
+            oss << "# HELP " << name << " " << HISTOGRAM_INFO[i].help << "\n";
+            oss << "# TYPE " << name << " histogram\n";
+
+            uint64_t cumulative = 0;
+            for (size_t b = 0; b < LatencyHistogram::NUM_BOUNDS; ++b) {
+                cumulative += hist.buckets[b];
+                oss << name << "_bucket{le=\"" << LatencyHistogram::BOUNDS[b] << "\"} "
+                    << cumulative << "\n";
+            }
+            oss << name << "_bucket{le=\"+Inf\"} " << hist.count << "\n";
+            oss << name << "_sum " << hist.sum << "\n";
+            oss << name << "_count " << hist.count << "\n";
+        }
+
+        for (size_t i = 0; i < NUM_GAUGES; ++i) {
+            oss << "# HELP " << GAUGE_INFO[i].name << " " << GAUGE_INFO[i].help << "\n";
+            oss << "# TYPE " << GAUGE_INFO[i].name << " gauge\n";
+            oss << GAUGE_INFO[i].name << " "
+                << gauges_[i].value.load(std::memory_order_relaxed) << "\n";
+        }
+
+        oss << "# HELP trading_active_connections Currently open client connections.\n";
+        oss << "# TYPE trading_active_connections gauge\n";
+        oss << "trading_active_connections "
+            << static_cast<int64_t>(totals.get(Counter::CONNECTIONS_OPENED)) -
+               static_cast<int64_t>(totals.get(Counter::CONNECTIONS_CLOSED)) << "\n";
+
+        oss << "# HELP trading_uptime_seconds Seconds since start or last reset.\n";
+        oss << "# TYPE trading_uptime_seconds gauge\n";
+        oss << "trading_uptime_seconds " << getUptimeSeconds() << "\n";
+
+        return oss.str();
+    }
+
 private:
-    SystemMetrics() 
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    struct MetricInfo {
+        const char* name;
+        const char* help;
+    };
+
+    static constexpr MetricInfo COUNTER_INFO[NUM_COUNTERS] = {
+        {"trading_orders_submitted_total", "Orders submitted."},
+        {"trading_orders_accepted_total", "Orders accepted by risk checks."},
+        {"trading_orders_rejected_total", "Orders rejected."},
+        {"trading_orders_cancelled_total", "Orders cancelled."},
+        {"trading_trades_executed_total", "Trades executed."},
+        {"trading_volume_traded_total", "Shares traded."},
+        {"trading_value_traded_cents_total", "Notional traded in cents."},
+        {"trading_errors_total", "Errors recorded."},
+        {"trading_warnings_total", "Warnings recorded."},
+        {"trading_connections_opened_total", "Client connections accepted."},
+        {"trading_connections_closed_total", "Client connections closed."}
+    };
+
+    static constexpr MetricInfo HISTOGRAM_INFO[NUM_HISTOGRAMS] = {
+        {"trading_order_latency_ns", "Order processing latency in nanoseconds."},
+        {"trading_stage_parse_ns", "FIX parse stage (since socket read), in nanoseconds."},
+        {"trading_stage_risk_check_ns", "Risk check stage (since previous stage), in nanoseconds."},
+        {"trading_stage_match_ns", "Matching stage (since previous stage), in nanoseconds."},
+        {"trading_stage_send_ns", "Execution report send (since previous stage), in nanoseconds."},
+        {"trading_end_to_end_ns", "Socket read to execution report sent, in nanoseconds."}
+    };
+
+    static constexpr MetricInfo GAUGE_INFO[NUM_GAUGES] = {
+        {"trading_queue_depth", "Commands waiting for the matching engine."},
+        {"trading_bid_levels", "Price levels on the bid side."},
+        {"trading_ask_levels", "Price levels on the ask side."}
+    };
+
+    // Per-thread counter block. Aligned so two threads never share a line.
+    struct alignas(CACHE_LINE_SIZE) ThreadCounters {
+        std::atomic<uint64_t> counters[NUM_COUNTERS] = {};
+        LatencyHistogram histograms[NUM_HISTOGRAMS];
+        std::atomic<bool> inUse{false};
+
+        void bump(Counter counter, uint64_t delta) {
+            auto& cell = counters[static_cast<size_t>(counter)];
+            cell.store(cell.load(std::memory_order_relaxed) + delta,
+                       std::memory_order_relaxed);
+        }
+    };
+
+    // Returns the calling thread's block to the registry when the thread exits
+    struct BlockLease {
+        ThreadCounters* block = nullptr;
+
+        ~BlockLease() {
+            if (block) block->inUse.store(false, std::memory_order_release);
+        }
+    };
+
+    struct alignas(CACHE_LINE_SIZE) PaddedGauge {
+        std::atomic<int64_t> value{0};
+    };
+
+    // Summed view over all thread blocks
+    struct Totals {
+        std::array<uint64_t, NUM_COUNTERS> counters{};
+        std::array<LatencyHistogram::Snapshot, NUM_HISTOGRAMS> histograms{};
+
+        uint64_t get(Counter counter) const {
+            return counters[static_cast<size_t>(counter)];
+        }
+    };
+
+    SystemMetrics()
         : startTime_(std::chrono::steady_clock::now())
-        , ordersSubmitted_(0)
-        , ordersAccepted_(0)
-        , ordersRejected_(0)
-        , ordersCancelled_(0)
-        , tradesExecuted_(0)
-        , volumeTraded_(0)
-        , valueTraded_(0)
-        , totalLatency_(0)
-        , latencyMeasurements_(0)
-        , errors_(0)
-        , warnings_(0)
-        , connections_(0)
     {}
 
     std::chrono::steady_clock::time_point startTime_;
-    
-    std::atomic<uint64_t> ordersSubmitted_;
-    std::atomic<uint64_t> ordersAccepted_;
-    std::atomic<uint64_t> ordersRejected_;
-    std::atomic<uint64_t> ordersCancelled_;
-    std::atomic<uint64_t> tradesExecuted_;
-    std::atomic<uint64_t> volumeTraded_;
-    std::atomic<uint64_t> valueTraded_;  // In cents
-    std::atomic<uint64_t> totalLatency_;
-    std::atomic<uint64_t> latencyMeasurements_;
-    std::atomic<uint64_t> errors_;
-    std::atomic<uint64_t> warnings_;
-    std::atomic<int64_t> connections_;
+
+    std::vector<std::unique_ptr<ThreadCounters>> blocks_;
+    mutable std::mutex registryMutex_;  // Guards blocks_, baseline_ and startTime_
+    Totals baseline_;
+
+    PaddedGauge gauges_[NUM_GAUGES];
+
+    void increment(Counter counter) {
+        localCounters().bump(counter, 1);
+    }
+
+    ThreadCounters& localCounters() {
+        static thread_local BlockLease lease;
+        if (!lease.block) {
+            lease.block = acquireBlock();
+        }
+        return *lease.block;
+    }
+
+    // Slow path, once per thread: reuse a block released by an exited thread
+    ThreadCounters* acquireBlock() {
+        std::lock_guard<std::mutex> lock(registryMutex_);
+        for (auto& block : blocks_) {
+            bool expected = false;
+            if (block->inUse.compare_exchange_strong(expected, true,
+                                                     std::memory_order_acquire)) {
+                return block.get();
+            }
+        }
+        blocks_.push_back(std::make_unique<ThreadCounters>());
+        blocks_.back()->inUse.store(true, std::memory_order_relaxed);
+        return blocks_.back().get();
+    }
+
+    Totals collectRaw() const {
+        Totals totals;
+        std::lock_guard<std::mutex> lock(registryMutex_);
+        for (const auto& block : blocks_) {
+            for (size_t i = 0; i < NUM_COUNTERS; ++i) {
+                totals.counters[i] += block->counters[i].load(std::memory_order_relaxed);
+            }
+            for (size_t i = 0; i < NUM_HISTOGRAMS; ++i) {
+                totals.histograms[i].add(block->histograms[i].snapshot());
+            }
+        }
+        return totals;
+    }
+
+    Totals collect() const {
+        Totals totals = collectRaw();
+        std::lock_guard<std::mutex> lock(registryMutex_);
+        for (size_t i = 0; i < NUM_COUNTERS; ++i) {
+            totals.counters[i] -= baseline_.counters[i];
+        }
+        for (size_t i = 0; i < NUM_HISTOGRAMS; ++i) {
+            totals.histograms[i].subtract(baseline_.histograms[i]);
+        }
+        return totals;
+    }
+
+    uint64_t getUptimeSeconds() const {
+        auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(registryMutex_);
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(
+            now - startTime_
+        ).count());
+    }
+
+    static double averageOf(const LatencyHistogram::Snapshot& hist) {
+        if (hist.count == 0) return 0.0;
+        return static_cast<double>(hist.sum) / hist.count;
+    }
 
     static std::string formatUptime(uint64_t seconds) {
         uint64_t days = seconds / 86400;
         uint64_t hours = (seconds % 86400) / 3600;
         uint64_t mins = (seconds % 3600) / 60;
         uint64_t secs = seconds % 60;
-        
+
         std::ostringstream oss;
         if (days > 0) oss << days << "d ";
         if (hours > 0) oss << hours << "h ";
         if (mins > 0) oss << mins << "m ";
         oss << secs << "s";
-        
+
         return oss.str();
     }
 };
@@ -222,4 +545,4 @@ private:
 } // namespace utils
 } // namespace trading
 
-#endif // METRICS_HPP
\ No newline at end of file
+#endif // METRICS_HPP
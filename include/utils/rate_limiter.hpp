@@ -0,0 +1,173 @@
+#ifndef RATE_LIMITER_HPP
+#define RATE_LIMITER_HPP
+
+#include "utils/timer.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace trading {
+namespace utils {
+
+/**
+ * TokenBucket - a rate limit cheap enough to run on every inbound message.
+ *
+ * Holds `burst` tokens refilled at `ratePerSecond`, kept as a single TSC
+ * timestamp: the time at which the bucket would be full again. Taking a
+ * token pushes that time one refill interval later, and a take is refused
+ * if it would land more than `burst` intervals ahead of now. This is the
+ * same as counting tokens, with no division, clock syscall or allocation
+ * per call. tryAcquire() is a CAS, so one bucket may be shared by threads.
+ *
+ * The constructor calibrates the TSC on first use (about 10 ms); build
+ * buckets at startup. A rate of zero or less never limits.
+ */
+class TokenBucket {
+public:
+    TokenBucket() : interval_(0), tolerance_(0), full_(0) {}
+
+    TokenBucket(double ratePerSecond, uint32_t burst) : TokenBucket() {
+        configure(ratePerSecond, burst);
+    }
+
+    TokenBucket(const TokenBucket& other)
+        : interval_(other.interval_)
+        , tolerance_(other.tolerance_)
+        , full_(other.full_.load(std::memory_order_relaxed))
+    {}
+
+    TokenBucket& operator=(const TokenBucket& other) {
+        interval_ = other.interval_;
+        tolerance_ = other.tolerance_;
+        full_.store(other.full_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return *this;
+    }
+
+    // Reset to a full bucket at the new rate
+    void configure(double ratePerSecond, uint32_t burst) {
+        interval_ = intervalFor(ratePerSecond);
+        tolerance_ = toleranceFor(interval_, burst);
+        full_.store(0, std::memory_order_relaxed);
+    }
+
+    bool tryAcquire(uint64_t now = rdtsc()) {
+        return acquire(full_, interval_, tolerance_, now);
+    }
+
+    bool isLimited() const { return interval_ != 0; }
+
+    // TSC ticks per token, 0 when unlimited
+    uint64_t getInterval() const { return interval_; }
+
+    /**
+     * The bucket step on a bare state word, for tables of buckets that
+     * share one rate (see KeyedRateLimiter).
+     */
+    static bool acquire(std::atomic<uint64_t>& full, uint64_t interval,
+                        uint64_t tolerance, uint64_t now) {
+        if (interval == 0) return true;
+
+        uint64_t current = full.load(std::memory_order_relaxed);
+        for (;;) {
+            uint64_t start = std::max(current, now);
+            if (start - now > tolerance) return false;
+            if (full.compare_exchange_weak(current, start + interval,
+                                           std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+    }
+
+    static uint64_t intervalFor(double ratePerSecond) {
+        if (ratePerSecond <= 0.0) return 0;
+        double ticks = tscTicksPerNano() * 1e9 / ratePerSecond;
+        return std::max<uint64_t>(1, static_cast<uint64_t>(ticks));
+    }
+
+    static uint64_t toleranceFor(uint64_t interval, uint32_t burst) {
+        return interval * (std::max<uint32_t>(burst, 1) - 1);
+    }
+
+private:
+    uint64_t interval_;
+    uint64_t tolerance_;
+    std::atomic<uint64_t> full_;  // TSC time the bucket is full again
+};
+
+/**
+ * KeyedRateLimiter - one TokenBucket per key (e.g. account), all at the
+ * same rate, in an open-addressed table sized at construction. Lookup
+ * and first-time insert are lock-free and never allocate; keys are never
+ * removed. Once the table is full, new keys are refused, so an attacker
+ * cycling through keys cannot get past the limit. Key 0 is not limited.
+ */
+class KeyedRateLimiter {
+public:
+    KeyedRateLimiter(double ratePerSecond, uint32_t burst, size_t maxKeys)
+        : interval_(TokenBucket::intervalFor(ratePerSecond))
+        , tolerance_(TokenBucket::toleranceFor(interval_, burst))
+        , maxKeys_(std::max<size_t>(maxKeys, 1))
+        , keys_(0)
+    {
+        size_t slots = 1;
+        while (slots < maxKeys_ * 2) slots <<= 1;
+        mask_ = slots - 1;
+        slots_ = std::make_unique<Slot[]>(slots);
+    }
+
+    KeyedRateLimiter(const KeyedRateLimiter&) = delete;
+    KeyedRateLimiter& operator=(const KeyedRateLimiter&) = delete;
+
+    bool tryAcquire(uint32_t key, uint64_t now = rdtsc()) {
+        if (key == 0 || interval_ == 0) return true;
+
+        Slot* slot = findOrInsert(key);
+        if (!slot) return false;
+        return TokenBucket::acquire(slot->full, interval_, tolerance_, now);
+    }
+
+    size_t getKeyCount() const { return keys_.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> key{0};
+        std::atomic<uint64_t> full{0};
+    };
+
+    uint64_t interval_;
+    uint64_t tolerance_;
+    size_t maxKeys_;
+    size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<size_t> keys_;
+
+    Slot* findOrInsert(uint32_t key) {
+        size_t index = (static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL >> 32) & mask_;
+        for (size_t probes = 0; probes <= mask_; ++probes, index = (index + 1) & mask_) {
+            Slot& slot = slots_[index];
+            uint32_t current = slot.key.load(std::memory_order_acquire);
+            if (current == key) return &slot;
+            if (current != 0) continue;
+
+            // Empty: reserve capacity, then claim the slot (or lose it to
+            // a racing insert, possibly of the same key)
+            if (keys_.fetch_add(1, std::memory_order_relaxed) >= maxKeys_) {
+                keys_.fetch_sub(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            if (slot.key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+                return &slot;
+            }
+            keys_.fetch_sub(1, std::memory_order_relaxed);
+            if (current == key) return &slot;
+        }
+        return nullptr;
+    }
+};
+
+} // namespace utils
+} // namespace trading
+
+#endif // RATE_LIMITER_HPP
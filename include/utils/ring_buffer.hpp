@@ -0,0 +1,245 @@
+#ifndef RING_BUFFER_HPP
+#define RING_BUFFER_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace trading {
+namespace utils {
+
+/**
+ * Preallocated rings for the engine pipeline. Slots are constructed once
+ * and reused: producers fill a slot in place and consumers read it in
+ * place, so an event is never copied or allocated on its way through.
+ */
+
+/**
+ * MPSCRing - bounded multi-producer, single-consumer ring.
+ *
+ * Each slot carries a sequence number (Vyukov's bounded queue): a
+ * producer claims a position with a CAS on the tail, fills the slot and
+ * publishes it by advancing the slot's sequence. Producers never wait on
+ * each other beyond the CAS; the consumer drains published slots in
+ * claim order and hands each one back by advancing its sequence a lap.
+ */
+template<typename T, size_t Size>
+class MPSCRing {
+public:
+    static_assert((Size & (Size - 1)) == 0, "Size must be power of 2");
+
+    MPSCRing() : tail_(0), head_(0) {
+        for (size_t i = 0; i < Size; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Claim a slot and fill it with fill(T&). Returns false if full.
+     * Safe to call from any number of threads.
+     */
+    template<typename Fill>
+    bool tryPublish(Fill&& fill) {
+        size_t position = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots_[position & (Size - 1)];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(position, position + 1,
+                                                std::memory_order_relaxed)) {
+                    fill(slot.value);
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // The consumer has not freed this slot yet
+            } else {
+                position = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Publish, yielding while the ring is full
+    template<typename Fill>
+    void publish(Fill&& fill) {
+        while (!tryPublish(fill)) {
+            std::this_thread::yield();
+        }
+    }
+
+    /**
+     * Process up to maxItems published slots in order with visit(T&),
+     * then release them. Single consumer only. Returns the number taken.
+     */
+    template<typename Visit>
+    size_t consume(Visit&& visit, size_t maxItems = Size) {
+        size_t taken = 0;
+        while (taken < maxItems) {
+            Slot& slot = slots_[head_ & (Size - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != head_ + 1) break;
+
+            visit(slot.value);
+            slot.sequence.store(head_ + Size, std::memory_order_release);
+            head_++;
+            taken++;
+        }
+        headPublished_.store(head_, std::memory_order_relaxed);
+        return taken;
+    }
+
+    // Approximate number of claimed, unconsumed slots
+    size_t size() const {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t head = headPublished_.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+    static constexpr size_t capacity() { return Size; }
+
+private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    struct alignas(CACHE_LINE_SIZE) Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_;
+    alignas(CACHE_LINE_SIZE) size_t head_;  // Consumer only
+    std::atomic<size_t> headPublished_{0};  // For size() from other threads
+    std::array<Slot, Size> slots_;
+};
+
+/**
+ * BroadcastRing - single producer, multiple independent consumers.
+ *
+ * Disruptor-style: the producer advances one cursor; every consumer
+ * keeps its own sequence and sees every event, reading it in place.
+ * Consumers run in parallel and batch naturally (a consumer that falls
+ * behind processes everything published since in one poll). The
+ * producer only overwrites a slot once the slowest consumer is past it.
+ */
+template<typename T, size_t Size, size_t MaxConsumers = 8>
+class BroadcastRing {
+public:
+    static_assert((Size & (Size - 1)) == 0, "Size must be power of 2");
+
+    class Consumer {
+    public:
+        Consumer() : ring_(nullptr), index_(0) {}
+
+        /**
+         * Visit every event published since the last poll (up to
+         * maxItems) with visit(const T&), then release them.
+         * Returns the number of events visited.
+         */
+        template<typename Visit>
+        size_t poll(Visit&& visit, size_t maxItems = Size) {
+            auto& sequence = ring_->consumers_[index_].sequence;
+            uint64_t next = sequence.load(std::memory_order_relaxed);
+            uint64_t available = ring_->cursor_.load(std::memory_order_acquire);
+            if (available - next > maxItems) {
+                available = next + maxItems;
+            }
+
+            for (uint64_t seq = next; seq < available; ++seq) {
+                visit(static_cast<const T&>(ring_->slots_[seq & (Size - 1)]));
+            }
+
+            sequence.store(available, std::memory_order_release);
+            return static_cast<size_t>(available - next);
+        }
+
+        // Events published but not yet polled by this consumer
+        size_t backlog() const {
+            return static_cast<size_t>(ring_->cursor_.load(std::memory_order_acquire) -
+                ring_->consumers_[index_].sequence.load(std::memory_order_relaxed));
+        }
+
+        bool valid() const { return ring_ != nullptr; }
+
+    private:
+        friend class BroadcastRing;
+
+        Consumer(BroadcastRing* ring, size_t index) : ring_(ring), index_(index) {}
+
+        BroadcastRing* ring_;
+        size_t index_;
+    };
+
+    BroadcastRing() : cursor_(0), consumerCount_(0), cachedGate_(0) {}
+
+    /**
+     * Register a consumer. Must happen before the producer starts; the
+     * consumer sees events published from now on.
+     */
+    Consumer addConsumer() {
+        if (consumerCount_ == MaxConsumers) {
+            throw std::runtime_error("BroadcastRing: too many consumers");
+        }
+        size_t index = consumerCount_++;
+        consumers_[index].sequence.store(cursor_.load(std::memory_order_relaxed),
+                                         std::memory_order_relaxed);
+        return Consumer(this, index);
+    }
+
+    /**
+     * Fill the next slot with fill(T&) and publish it, yielding while the
+     * slowest consumer is a full ring behind. Single producer only.
+     */
+    template<typename Fill>
+    void publish(Fill&& fill) {
+        uint64_t next = cursor_.load(std::memory_order_relaxed);
+        while (next - cachedGate_ >= Size) {
+            cachedGate_ = minimumSequence(next);
+            if (next - cachedGate_ >= Size) {
+                std::this_thread::yield();
+            }
+        }
+
+        fill(slots_[next & (Size - 1)]);
+        cursor_.store(next + 1, std::memory_order_release);
+    }
+
+    // Number of events published so far
+    uint64_t getCursor() const {
+        return cursor_.load(std::memory_order_acquire);
+    }
+
+    size_t getConsumerCount() const { return consumerCount_; }
+    static constexpr size_t capacity() { return Size; }
+
+private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    struct alignas(CACHE_LINE_SIZE) ConsumerSequence {
+        std::atomic<uint64_t> sequence{0};
+    };
+
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> cursor_;
+    size_t consumerCount_;
+    uint64_t cachedGate_;  // Producer's last seen minimum consumer sequence
+    std::array<ConsumerSequence, MaxConsumers> consumers_;
+    std::array<T, Size> slots_;
+
+    uint64_t minimumSequence(uint64_t fallback) const {
+        uint64_t minimum = fallback;
+        for (size_t i = 0; i < consumerCount_; ++i) {
+            uint64_t sequence = consumers_[i].sequence.load(std::memory_order_acquire);
+            if (sequence < minimum) minimum = sequence;
+        }
+        return minimum;
+    }
+};
+
+} // namespace utils
+} // namespace trading
+
+#endif // RING_BUFFER_HPP
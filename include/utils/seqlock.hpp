@@ -0,0 +1,100 @@
+#ifndef SEQLOCK_HPP
+#define SEQLOCK_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace trading {
+namespace utils {
+
+/**
+ * SeqLock - single writer, many lock-free readers.
+ * The writer never waits; readers retry if they raced a write.
+ * The payload is stored as relaxed atomic words, so concurrent
+ * reads are well-defined (no torn-object UB), only possibly stale.
+ */
+template<typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SeqLock payload must be trivially copyable");
+
+public:
+    SeqLock() : sequence_(0) {
+        T initial{};
+        store(initial);
+    }
+
+    /**
+     * Publish a new value (single writer only).
+     */
+    void store(const T& value) {
+        uint64_t words[NUM_WORDS] = {};
+        std::memcpy(words, &value, sizeof(T));
+
+        uint64_t seq = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < NUM_WORDS; ++i) {
+            data_[i].store(words[i], std::memory_order_relaxed);
+        }
+
+        sequence_.store(seq + 2, std::memory_order_release);
+    }
+
+    /**
+     * Single read attempt. Returns false if a write was in progress.
+     */
+    bool tryLoad(T& out) const {
+        uint64_t before = sequence_.load(std::memory_order_acquire);
+        if (before & 1) return false;
+
+        uint64_t words[NUM_WORDS];
+        for (size_t i = 0; i < NUM_WORDS; ++i) {
+            words[i] = data_[i].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence_.load(std::memory_order_relaxed) != before) return false;
+
+        std::memcpy(&out, words, sizeof(T));
+        return true;
+    }
+
+    /**
+     * Read a consistent value, spinning while the writer is mid-update.
+     */
+    T load() const {
+        T value;
+        while (!tryLoad(value)) {
+            cpuRelax();
+        }
+        return value;
+    }
+
+    // Number of completed writes
+    uint64_t getVersion() const {
+        return sequence_.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    static constexpr size_t NUM_WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> sequence_;
+    std::atomic<uint64_t> data_[NUM_WORDS];
+
+    static void cpuRelax() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_ia32_pause();
+#endif
+    }
+};
+
+} // namespace utils
+} // namespace trading
+
+#endif // SEQLOCK_HPP
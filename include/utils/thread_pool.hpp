@@ -0,0 +1,176 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include "utils/thread_runtime.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace trading {
+namespace utils {
+
+/**
+ * ThreadPool - a fixed set of worker threads for splitting one bounded
+ * job across cores (end-of-interval risk sweeps, reports); not for the
+ * order path, which stays on its own pinned threads.
+ *
+ * parallelFor() cuts [0, count) into chunks that the workers and the
+ * calling thread claim with a fetch_add, and returns once every chunk is
+ * done. One job runs at a time; workers sleep on a condition variable
+ * between jobs.
+ *
+ * With settings.cpu >= 0, worker i is pinned to core cpu + i.
+ */
+class ThreadPool {
+public:
+    static constexpr size_t CHUNKS_PER_THREAD = 4;  // Evens out uneven chunks
+
+    explicit ThreadPool(size_t workers, const ThreadSettings& settings = ThreadSettings(),
+                        const std::string& name = "pool")
+        : job_(nullptr)
+        , context_(nullptr)
+        , count_(0)
+        , chunkSize_(0)
+        , chunks_(0)
+        , nextChunk_(0)
+        , chunksDone_(0)
+        , active_(0)
+        , generation_(0)
+        , open_(false)
+        , stopping_(false)
+    {
+        threads_.reserve(workers);
+        for (size_t i = 0; i < workers; ++i) {
+            ThreadSettings worker = settings;
+            if (worker.cpu >= 0) worker.cpu += static_cast<int>(i);
+            threads_.push_back(ThreadRuntime::spawn(name + "-" + std::to_string(i), worker,
+                                                    [this] { workerLoop(); }));
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Threads a job is spread over, the caller included
+    size_t getThreadCount() const { return threads_.size() + 1; }
+
+    /**
+     * Run fn(begin, end) over disjoint ranges covering [0, count), at
+     * least `grain` items each, and wait for all of them. fn must not
+     * call back into the pool.
+     */
+    template<typename Fn>
+    void parallelFor(size_t count, size_t grain, Fn&& fn) {
+        if (count == 0) return;
+        size_t chunks = std::min(getThreadCount() * CHUNKS_PER_THREAD,
+                                 (count + std::max<size_t>(grain, 1) - 1) /
+                                     std::max<size_t>(grain, 1));
+        if (chunks <= 1 || threads_.empty()) {
+            fn(size_t(0), count);
+            return;
+        }
+
+        using Callable = typename std::remove_reference<Fn>::type;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = [](void* context, size_t begin, size_t end) {
+                (*static_cast<Callable*>(context))(begin, end);
+            };
+            context_ = const_cast<void*>(static_cast<const void*>(&fn));
+            count_ = count;
+            chunkSize_ = (count + chunks - 1) / chunks;
+            chunks_ = (count + chunkSize_ - 1) / chunkSize_;
+            nextChunk_.store(0, std::memory_order_relaxed);
+            chunksDone_.store(0, std::memory_order_relaxed);
+            generation_++;
+            open_ = true;
+        }
+        wake_.notify_all();
+
+        // Spin, then yield: the workers may share cores with the caller
+        runChunks();
+        IdleStrategy idle(WaitStrategy::SPIN_THEN_YIELD);
+        while (chunksDone_.load(std::memory_order_acquire) < chunks_) {
+            idle.idle();
+        }
+
+        // Late wakers must not join, and joined workers must be out of
+        // runChunks() before the job state is reused
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            open_ = false;
+        }
+        while (active_.load(std::memory_order_acquire) != 0) {
+            idle.idle();
+        }
+    }
+
+private:
+    using Job = void (*)(void*, size_t, size_t);
+
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+
+    // Current job; written under the mutex before workers are woken
+    Job job_;
+    void* context_;
+    size_t count_;
+    size_t chunkSize_;
+    size_t chunks_;
+    std::atomic<size_t> nextChunk_;
+    std::atomic<size_t> chunksDone_;
+    std::atomic<size_t> active_;   // Workers inside runChunks()
+    uint64_t generation_;
+    bool open_;                    // Workers may still join the job
+    bool stopping_;
+
+    void runChunks() {
+        for (;;) {
+            size_t chunk = nextChunk_.fetch_add(1, std::memory_order_relaxed);
+            if (chunk >= chunks_) return;
+            size_t begin = chunk * chunkSize_;
+            job_(context_, begin, std::min(begin + chunkSize_, count_));
+            chunksDone_.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    void workerLoop() {
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+                if (stopping_) return;
+                seen = generation_;
+                if (!open_) continue;
+                active_.fetch_add(1, std::memory_order_relaxed);
+            }
+            runChunks();
+            active_.fetch_sub(1, std::memory_order_release);
+        }
+    }
+};
+
+} // namespace utils
+} // namespace trading
+
+#endif // THREAD_POOL_HPP
@@ -0,0 +1,379 @@
+#ifndef THREAD_RUNTIME_HPP
+#define THREAD_RUNTIME_HPP
+
+#include "utils/config.hpp"
+#include "utils/logger.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+namespace trading {
+namespace utils {
+
+/**
+ * How a queue consumer waits when a poll finds nothing.
+ */
+enum class WaitStrategy : uint8_t {
+    BUSY_SPIN,        // Never give up the core; lowest latency, burns a CPU
+    SPIN_THEN_YIELD,  // Spin briefly, then yield to other runnable threads
+    PARK              // Spin, yield, then sleep on a futex until notified
+};
+
+inline const char* waitStrategyToString(WaitStrategy strategy) {
+    switch (strategy) {
+        case WaitStrategy::BUSY_SPIN: return "spin";
+        case WaitStrategy::SPIN_THEN_YIELD: return "yield";
+        case WaitStrategy::PARK: return "park";
+    }
+    return "unknown";
+}
+
+inline WaitStrategy waitStrategyFromString(const std::string& value,
+                                           WaitStrategy defaultValue = WaitStrategy::SPIN_THEN_YIELD) {
+    if (value == "spin") return WaitStrategy::BUSY_SPIN;
+    if (value == "yield") return WaitStrategy::SPIN_THEN_YIELD;
+    if (value == "park") return WaitStrategy::PARK;
+    return defaultValue;
+}
+
+/**
+ * Placement and scheduling for one thread, normally read from the
+ * configuration under a per-thread prefix:
+ *
+ *   engine.cpu=3           core to pin to (-1 or absent: not pinned)
+ *   engine.priority=80     SCHED_FIFO priority 1-99 (0 or absent: normal)
+ *   engine.numa_local=true place the thread's rings/pools on its node
+ *   engine.wait=park       spin | yield | park
+ */
+struct ThreadSettings {
+    int cpu = -1;
+    int realtimePriority = 0;
+    bool numaLocal = true;
+    WaitStrategy wait = WaitStrategy::SPIN_THEN_YIELD;
+
+    // Keys that are absent keep the defaults above
+    static ThreadSettings fromConfig(const std::string& prefix,
+                                     const Config& config = Config::getInstance()) {
+        ThreadSettings settings;
+        settings.cpu = config.getInt(prefix + ".cpu", settings.cpu);
+        settings.realtimePriority = config.getInt(prefix + ".priority", settings.realtimePriority);
+        settings.numaLocal = config.getBool(prefix + ".numa_local", settings.numaLocal);
+        settings.wait = waitStrategyFromString(config.getString(prefix + ".wait"), settings.wait);
+        return settings;
+    }
+};
+
+/**
+ * ThreadRuntime applies ThreadSettings to the calling thread: name,
+ * CPU affinity, SCHED_FIFO, and NUMA placement of the memory the thread
+ * works on. Everything is best effort - a setting the host refuses
+ * (no permission, missing core) is logged and the thread runs anyway.
+ * On platforms other than Linux the calls are no-ops.
+ */
+class ThreadRuntime {
+public:
+    /**
+     * Apply settings to the calling thread. Returns false if any
+     * requested setting could not be applied.
+     */
+    static bool apply(const std::string& name, const ThreadSettings& settings) {
+        setName(name);
+
+        bool ok = true;
+        if (settings.cpu >= 0) {
+            if (pinCurrentThread(settings.cpu)) {
+                if (!isIsolated(settings.cpu)) {
+                    LOG_WARN("Thread ", name, " pinned to CPU ", settings.cpu,
+                             " which is not isolated (isolcpus); expect jitter");
+                }
+            } else {
+                LOG_WARN("Could not pin thread ", name, " to CPU ", settings.cpu);
+                ok = false;
+            }
+        }
+
+        if (settings.realtimePriority > 0 && !setRealtimePriority(settings.realtimePriority)) {
+            LOG_WARN("Could not set SCHED_FIFO priority ", settings.realtimePriority,
+                     " for thread ", name);
+            ok = false;
+        }
+        return ok;
+    }
+
+    // Start a thread that applies the settings and then runs fn()
+    template<typename Fn>
+    static std::thread spawn(std::string name, ThreadSettings settings, Fn&& fn) {
+        return std::thread([name = std::move(name), settings, fn = std::forward<Fn>(fn)]() mutable {
+            apply(name, settings);
+            fn();
+        });
+    }
+
+    static bool pinCurrentThread(int cpu) {
+#ifdef __linux__
+        if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+#else
+        (void)cpu;
+        return false;
+#endif
+    }
+
+    static bool setRealtimePriority(int priority) {
+#ifdef __linux__
+        sched_param param{};
+        param.sched_priority = priority;
+        return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+#else
+        (void)priority;
+        return false;
+#endif
+    }
+
+    // Kernel thread names are limited to 15 characters
+    static void setName(const std::string& name) {
+#ifdef __linux__
+        pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+#else
+        (void)name;
+#endif
+    }
+
+    static int currentCpu() {
+#ifdef __linux__
+        return sched_getcpu();
+#else
+        return -1;
+#endif
+    }
+
+    static int currentNumaNode() {
+#ifdef __linux__
+        unsigned cpu = 0;
+        unsigned node = 0;
+        if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) return -1;
+        return static_cast<int>(node);
+#else
+        return -1;
+#endif
+    }
+
+    /**
+     * Prefer the calling thread's NUMA node for [addr, addr + bytes) and
+     * migrate pages already touched elsewhere (e.g. a ring constructed by
+     * the main thread before the consumer was pinned). Only whole pages
+     * inside the range are affected. Uses mbind directly, so there is no
+     * libnuma dependency.
+     */
+    static bool placeOnLocalNode(void* addr, size_t bytes) {
+#ifdef __linux__
+        int node = currentNumaNode();
+        if (node < 0 || node >= 64) return false;
+
+        uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        uintptr_t begin = (reinterpret_cast<uintptr_t>(addr) + pageSize - 1) & ~(pageSize - 1);
+        uintptr_t end = (reinterpret_cast<uintptr_t>(addr) + bytes) & ~(pageSize - 1);
+        if (end <= begin) return true;  // Smaller than a page; nothing to move
+
+        unsigned long nodeMask = 1UL << node;
+        long result = syscall(SYS_mbind, begin, end - begin, MPOL_PREFERRED,
+                              &nodeMask, sizeof(nodeMask) * 8, MPOL_MF_MOVE);
+        return result == 0;
+#else
+        (void)addr;
+        (void)bytes;
+        return false;
+#endif
+    }
+
+    // Whether the kernel keeps the scheduler off this CPU (isolcpus=)
+    static bool isIsolated(int cpu) {
+        std::ifstream file("/sys/devices/system/cpu/isolated");
+        std::string list;
+        if (!file || !std::getline(file, list)) return false;
+        return cpuListContains(list, cpu);
+    }
+
+    // Parse a kernel CPU list such as "2-5,8"
+    static bool cpuListContains(const std::string& list, int cpu) {
+        std::stringstream stream(list);
+        std::string range;
+        while (std::getline(stream, range, ',')) {
+            if (range.empty()) continue;
+            try {
+                size_t dash = range.find('-');
+                int first = std::stoi(range.substr(0, dash));
+                int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+                if (cpu >= first && cpu <= last) return true;
+            } catch (...) {
+                return false;
+            }
+        }
+        return false;
+    }
+
+private:
+#ifdef __linux__
+    // From <numaif.h>, which comes with libnuma rather than the kernel headers
+    static constexpr int MPOL_PREFERRED = 1;
+    static constexpr unsigned MPOL_MF_MOVE = 1U << 1;
+#endif
+};
+
+/**
+ * WakeSignal lets a parked consumer sleep in the kernel until a producer
+ * has something for it. notify() costs a fence and a load while nobody
+ * is parked, so producers can call it unconditionally after publishing.
+ */
+class WakeSignal {
+public:
+    WakeSignal() : epoch_(0), waiters_(0) {}
+
+    WakeSignal(const WakeSignal&) = delete;
+    WakeSignal& operator=(const WakeSignal&) = delete;
+
+    // Producer: call after publishing
+    void notify() {
+        // Pairs with the fence in park(): either the consumer sees the
+        // published data, or we see it waiting
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) == 0) return;
+
+        epoch_.fetch_add(1, std::memory_order_release);
+#ifdef __linux__
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAKE_PRIVATE,
+                INT32_MAX, nullptr, nullptr, 0);
+#endif
+    }
+
+    /**
+     * Consumer: sleep until notify() or the timeout, unless ready()
+     * already holds once this thread is registered as a waiter.
+     */
+    template<typename Ready>
+    void park(Ready&& ready, std::chrono::microseconds timeout) {
+        waiters_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint32_t epoch = epoch_.load(std::memory_order_acquire);
+
+        if (!ready()) {
+#ifdef __linux__
+            timespec wait{};
+            wait.tv_sec = static_cast<time_t>(timeout.count() / 1000000);
+            wait.tv_nsec = static_cast<long>((timeout.count() % 1000000) * 1000);
+            // Returns at once if a notify() bumped the epoch since the load
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAIT_PRIVATE,
+                    epoch, &wait, nullptr, 0);
+#else
+            (void)epoch;
+            std::this_thread::sleep_for(timeout);
+#endif
+        }
+
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    uint32_t getEpoch() const { return epoch_.load(std::memory_order_relaxed); }
+
+private:
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+                  "futex needs a plain 32-bit word");
+
+    std::atomic<uint32_t> epoch_;    // The futex word
+    std::atomic<uint32_t> waiters_;
+};
+
+/**
+ * IdleStrategy - the back-off of one consumer loop:
+ *
+ *   if (queue.poll(handle) > 0) idle.reset();
+ *   else idle.idle([&] { return !queue.empty(); });
+ *
+ * ready() is only consulted before parking, to close the race with a
+ * producer that published just before we registered as a waiter. PARK
+ * without a signal (or with a producer that never notifies) degrades to
+ * sleeping for the park timeout.
+ */
+class IdleStrategy {
+public:
+    static constexpr int SPIN_LIMIT = 1000;   // Idle polls spent spinning
+    static constexpr int YIELD_LIMIT = 100;   // Then yields, before parking
+    static constexpr std::chrono::microseconds PARK_TIMEOUT{1000};
+
+    explicit IdleStrategy(WaitStrategy strategy = WaitStrategy::SPIN_THEN_YIELD,
+                          WakeSignal* signal = nullptr)
+        : strategy_(strategy), signal_(signal), idle_(0) {}
+
+    template<typename Ready>
+    void idle(Ready&& ready) {
+        switch (strategy_) {
+            case WaitStrategy::BUSY_SPIN:
+                cpuRelax();
+                return;
+            case WaitStrategy::SPIN_THEN_YIELD:
+                if (idle_ < SPIN_LIMIT) {
+                    idle_++;
+                    cpuRelax();
+                } else {
+                    std::this_thread::yield();
+                }
+                return;
+            case WaitStrategy::PARK:
+                if (idle_ < SPIN_LIMIT) {
+                    idle_++;
+                    cpuRelax();
+                } else if (idle_ < SPIN_LIMIT + YIELD_LIMIT) {
+                    idle_++;
+                    std::this_thread::yield();
+                } else if (signal_) {
+                    signal_->park(ready, PARK_TIMEOUT);
+                } else {
+                    std::this_thread::sleep_for(PARK_TIMEOUT);
+                }
+                return;
+        }
+    }
+
+    void idle() {
+        idle([] { return false; });
+    }
+
+    // Call whenever a poll found work
+    void reset() { idle_ = 0; }
+
+    WaitStrategy getStrategy() const { return strategy_; }
+
+    static void cpuRelax() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_ia32_pause();
+#endif
+    }
+
+private:
+    WaitStrategy strategy_;
+    WakeSignal* signal_;
+    int idle_;
+};
+
+} // namespace utils
+} // namespace trading
+
+#endif // THREAD_RUNTIME_HPP
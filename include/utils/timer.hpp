@@ -2,7 +2,9 @@
 #define TIMER_HPP
 
 #include <chrono>
+#include <cstdint>
 #include <string>
+#include <thread>
 #include <iostream>
 
 namespace trading {
@@ -77,6 +79,26 @@ inline uint64_t rdtsc() {
 }
 #endif
 
+// TSC ticks per nanosecond, calibrated once against steady_clock.
+// The first call blocks for ~10 ms; call it at startup, not on the hot path.
+inline double tscTicksPerNano() {
+    static const double ticksPerNano = [] {
+        auto wallStart = std::chrono::steady_clock::now();
+        uint64_t tscStart = rdtsc();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        uint64_t tscEnd = rdtsc();
+        auto wallNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - wallStart
+        ).count();
+        return wallNanos > 0 ? static_cast<double>(tscEnd - tscStart) / wallNanos : 1.0;
+    }();
+    return ticksPerNano;
+}
+
+inline uint64_t tscToNanos(uint64_t ticks) {
+    return static_cast<uint64_t>(ticks / tscTicksPerNano());
+}
+
 // Latency measurement using CPU cycles
 class LatencyMeasurer {
 public:
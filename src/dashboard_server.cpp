@@ -1,15 +1,21 @@
 #include "engine/matching_engine.hpp"
+#include "engine/engine_runner.hpp"
+#include "engine/engine_memory.hpp"
 #include "network/websocket_server.hpp"
 #include "network/market_data.hpp"
+#include "network/metrics_exporter.hpp"
 #include "risk/risk_manager.hpp"
 #include "utils/metrics.hpp"
 #include "utils/config.hpp"
 #include "utils/logger.hpp"
+#include "utils/thread_runtime.hpp"
 #include <iostream>
 #include <thread>
 #include <chrono>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
+#include <mutex>
 
 using namespace trading;
 using namespace trading::network;
@@ -29,34 +35,34 @@ std::string createMetricsJSON(const SystemMetrics::Stats& stats) {
     return oss.str();
 }
 
-std::string createOrderBookJSON(const OrderBook& book) {
+std::string createOrderBookJSON(const TopOfBook& top) {
     std::ostringstream oss;
     oss << std::fixed << std::setprecision(2);
     
     oss << "{\"type\":\"orderbook\",";
     
     // Bids
-    auto bids = book.getBidDepth(5);
+    const uint32_t bidCount = std::min<uint32_t>(top.bidLevels, 5);
     oss << "\"bids\":[";
-    for (size_t i = 0; i < bids.size(); ++i) {
+    for (uint32_t i = 0; i < bidCount; ++i) {
         if (i > 0) oss << ",";
-        oss << "{\"price\":" << priceToDouble(bids[i].price)
-            << ",\"quantity\":" << bids[i].quantity << "}";
+        oss << "{\"price\":" << priceToDouble(top.bids[i].price)
+            << ",\"quantity\":" << top.bids[i].quantity << "}";
     }
     oss << "],";
     
     // Asks
-    auto asks = book.getAskDepth(5);
+    const uint32_t askCount = std::min<uint32_t>(top.askLevels, 5);
     oss << "\"asks\":[";
-    for (size_t i = 0; i < asks.size(); ++i) {
+    for (uint32_t i = 0; i < askCount; ++i) {
         if (i > 0) oss << ",";
-        oss << "{\"price\":" << priceToDouble(asks[i].price)
-            << ",\"quantity\":" << asks[i].quantity << "}";
+        oss << "{\"price\":" << priceToDouble(top.asks[i].price)
+            << ",\"quantity\":" << top.asks[i].quantity << "}";
     }
     oss << "],";
     
     // Spread
-    auto spread = book.getSpread();
+    auto spread = top.getSpread();
     oss << "\"spread\":" << (spread ? priceToDouble(*spread) : 0.0);
     
     oss << "}";
@@ -75,13 +81,19 @@ std::string createTradeJSON(const Trade& trade) {
     return oss.str();
 }
 
-std::string createRiskJSON(const RiskManager& riskMgr, const Position& pos) {
+// Risk figures copied out by the thread that owns the RiskManager
+struct RiskSnapshot {
+    int64_t position = 0;
+    Notional dailyPnL = 0;
+};
+
+std::string createRiskJSON(const RiskSnapshot& risk) {
     std::ostringstream oss;
     oss << std::fixed << std::setprecision(2);
     oss << "{"
         << "\"type\":\"risk\","
-        << "\"position\":" << pos.quantity << ","
-        << "\"dailyPnL\":" << riskMgr.getDailyPnL() << ","
+        << "\"position\":" << risk.position << ","
+        << "\"dailyPnL\":" << notionalToDouble(risk.dailyPnL) << ","
         << "\"ordersRejected\":" << SystemMetrics::getInstance().getOrdersRejected() << ","
         << "\"connections\":0"
         << "}";
@@ -100,10 +112,14 @@ int main() {
     config.loadFromFile("trading_config.txt");
     
     int wsPort = config.getInt("dashboard.port", 8080);
+    int metricsPort = config.getInt("metrics.port", 9100);
     
     // Create components
     WebSocketServer wsServer(wsPort);
-    MatchingEngine engine("AAPL");
+    MetricsExporter metricsExporter(metricsPort);
+    EngineMemory memory(config);
+    memory.logStats();
+    EngineRunner engine("AAPL", ThreadSettings::fromConfig("engine"), &memory.getArena());
     
     RiskLimits limits;
     limits.maxOrderSize = config.getInt("risk.max_order_size", 10000);
@@ -113,15 +129,29 @@ int main() {
     SystemMetrics& metrics = SystemMetrics::getInstance();
     metrics.reset();
     
-    // Set up trade callback
-    engine.setTradeCallback([&](const Trade& trade) {
-        LOG_INFO("TRADE: ", trade.toString());
-        metrics.recordTrade(trade.getQuantity(), trade.getValue());
-        riskMgr.updatePosition(trade, Side::BUY);
-        
-        // Broadcast to dashboard
-        wsServer.broadcast(createTradeJSON(trade));
-    });
+    // Trades reach risk and the dashboard through the engine's event ring.
+    // Only the simulation thread touches riskMgr: it drains the ring, checks
+    // its orders, and publishes a snapshot for the update thread.
+    auto riskFeed = engine.addConsumer();
+    std::mutex riskSnapshotMutex;
+    RiskSnapshot riskSnapshot;
+    auto handleEvent = [&](const EngineEvent& event) {
+        if (event.type == EngineEventType::TRADE) {
+            const Trade& trade = *event.trade;
+            LOG_INFO("TRADE: ", trade.toString());
+            metrics.recordTrade(trade.getQuantity(), trade.getNotional());
+            riskMgr.updatePosition(trade, Side::BUY);
+            
+            // Broadcast to dashboard
+            wsServer.broadcast(createTradeJSON(trade));
+        } else if (event.type == EngineEventType::BOOK_UPDATE) {
+            auto bookStats = engine.getOrderBook().getStatsSnapshot();
+            metrics.setGauge(SystemMetrics::Gauge::BID_LEVELS, bookStats.bidLevels);
+            metrics.setGauge(SystemMetrics::Gauge::ASK_LEVELS, bookStats.askLevels);
+        }
+    };
+    
+    engine.start();
     
     // Start WebSocket server
     if (!wsServer.start()) {
@@ -133,9 +163,17 @@ int main() {
     LOG_INFO("✓ Open dashboard.html in your browser");
     LOG_INFO("✓ Or navigate to http://localhost:", wsPort, "\n");
     
+    // Prometheus scrape endpoint
+    if (metricsExporter.start()) {
+        LOG_INFO("✓ Metrics exporter on http://localhost:", metricsPort, "/metrics");
+    } else {
+        LOG_WARN("Failed to start metrics exporter on port ", metricsPort);
+    }
+    
     // Background thread for periodic updates
     std::atomic<bool> running{true};
-    std::thread updateThread([&]() {
+    std::thread updateThread = ThreadRuntime::spawn(
+        "dash-update", ThreadSettings::fromConfig("dashboard.update"), [&]() {
         while (running) {
             std::this_thread::sleep_for(std::chrono::seconds(1));
             
@@ -143,21 +181,33 @@ int main() {
             auto stats = metrics.getStats();
             wsServer.broadcast(createMetricsJSON(stats));
             
-            // Broadcast order book
-            wsServer.broadcast(createOrderBookJSON(engine.getOrderBook()));
+            // Broadcast order book from the seqlock snapshot; the
+            // engine runner's thread owns the live book
+            wsServer.broadcast(createOrderBookJSON(engine.getOrderBook().getTopOfBook()));
             
             // Broadcast risk info
-            const Position& pos = riskMgr.getPosition("AAPL");
-            wsServer.broadcast(createRiskJSON(riskMgr, pos));
+            RiskSnapshot risk;
+            {
+                std::lock_guard<std::mutex> lock(riskSnapshotMutex);
+                risk = riskSnapshot;
+            }
+            wsServer.broadcast(createRiskJSON(risk));
         }
     });
     
     // Simulation thread - generates random orders
-    std::thread simulationThread([&]() {
+    std::thread simulationThread = ThreadRuntime::spawn(
+        "simulation", ThreadSettings::fromConfig("dashboard.simulation"), [&]() {
         OrderId nextOrderId = 1;
         
         while (running) {
             std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            riskFeed.poll(handleEvent);
+            {
+                std::lock_guard<std::mutex> lock(riskSnapshotMutex);
+                riskSnapshot.position = riskMgr.getPosition("AAPL").quantity;
+                riskSnapshot.dailyPnL = riskMgr.getDailyPnL();
+            }
             
             // Generate random order
             Side side = (rand() % 2 == 0) ? Side::BUY : Side::SELL;
@@ -167,7 +217,7 @@ int main() {
                               basePrice - priceOffset : basePrice + priceOffset;
             Quantity qty = (rand() % 300) + 100;
             
-            auto order = std::make_shared<Order>(
+            auto order = memory.makeOrder(
                 nextOrderId++, "AAPL", side, OrderType::LIMIT,
                 orderPrice, qty
             );
@@ -175,10 +225,10 @@ int main() {
             metrics.recordOrderSubmitted();
             
             // Risk check
-            auto result = riskMgr.validateOrder(*order, priceToDouble(orderPrice));
+            auto result = riskMgr.validateOrder(*order, orderPrice);
             if (result == RiskManager::ValidationResult::ACCEPTED) {
                 metrics.recordOrderAccepted();
-                engine.submitOrder(order);
+                engine.submitOrder(std::move(order));
             } else {
                 metrics.recordOrderRejected();
                 LOG_WARN("Order ", order->getId(), " rejected: ",
@@ -210,6 +260,7 @@ int main() {
     running = false;
     updateThread.join();
     simulationThread.join();
+    engine.stop();
     
     return 0;
 }
\ No newline at end of file
@@ -1,14 +1,26 @@
 #include "engine/matching_engine.hpp"
+#include "engine/engine_runner.hpp"
+#include "engine/engine_memory.hpp"
 #include "network/tcp_server.hpp"
 #include "network/fix_message.hpp"
 #include "network/market_data.hpp"
+#include "network/metrics_exporter.hpp"
+#include "risk/risk_manager.hpp"
+#include "utils/config.hpp"
+#include "utils/latency_trace.hpp"
 #include "utils/logger.hpp"
+#include "utils/thread_runtime.hpp"
 #include <iostream>
 #include <thread>
+#include <atomic>
 #include <chrono>
+#include <mutex>
+#include <set>
+#include <unordered_map>
 
 using namespace trading;
 using namespace trading::network;
+using namespace trading::risk;
 using namespace trading::utils;
 
 int main() {
@@ -18,46 +30,210 @@ int main() {
     LOG_INFO("Starting Trading Server on port 8080");
     LOG_INFO("========================================");
     
+    // Thread placement: engine.cpu, gateway.wait, network.client.cpu, ...
+    Config& config = Config::getInstance();
+    config.loadFromFile("trading_config.txt");
+    
+    // Orders live in a pre-faulted arena reserved now (memory.* keys);
+    // declared before the engine so it outlives every resting order
+    EngineMemory memory(config);
+    memory.logStats();
+    
     TCPServer server(8080);
-    MatchingEngine engine("AAPL");
+    server.setThreadSettings(ThreadSettings::fromConfig("network.accept"),
+                             ThreadSettings::fromConfig("network.client"));
+    EngineRunner engine("AAPL", ThreadSettings::fromConfig("engine"), &memory.getArena());
+    
+    // Per-account pre-trade checks run on the matching thread, which owns
+    // the accounts' positions; failures come back as rejected orders
+    RiskLimits riskLimits;
+    riskLimits.maxOrdersPerSecond = config.getInt("risk.max_orders_per_second", 100);
+    riskLimits.maxOrderBurst = config.getInt("risk.max_order_burst", riskLimits.maxOrderBurst);
+    engine.enableRisk(riskLimits);
+    
+    // Floods are dropped before parsing, on TSC token buckets: per
+    // connection in the server, per trading account in the callback.
+    // Reads are framed into whole FIX messages first, so each message
+    // spends one token and a throttled one is dropped whole.
+    server.setFraming(&FIXMessage::frameLength);
+    server.setSessionRateLimit(config.getDouble("gateway.session_rate", 1000.0),
+                               static_cast<uint32_t>(config.getInt("gateway.session_burst", 100)));
+    KeyedRateLimiter accountRates(riskLimits.maxOrdersPerSecond, riskLimits.getOrderBurst(),
+                                  RiskShard::DEFAULT_MAX_ACCOUNTS);
+    
+    // Client threads only enqueue; replies and market data are separate
+    // stages reading the engine's event ring on their own threads
+    auto gatewayFeed = engine.addConsumer();
+    auto marketDataFeed = engine.addConsumer();
+    
+    // Every socket read is traced. A new order's trace rides the command
+    // ring (risk, match on the matching thread) and the event ring back to
+    // the gateway, which stamps the exec report and aggregates it; other
+    // messages end on the client thread after parsing.
+    LatencyTracer& tracer = LatencyTracer::getInstance();
+    tracer.setSampleRate(64);
+    server.setTracing(true);
+    
+    // Prometheus scrape endpoint: the stage histograms above plus counters
+    int metricsPort = config.getInt("metrics.port", 9100);
+    MetricsExporter metricsExporter(metricsPort);
+    
+    // Accounts each connection has traded for, cancelled on disconnect.
+    // Orders without an Account tag trade under a per-connection account.
+    //
+    // Commands carry the connection's tag so the gateway can route the
+    // reply (0 = none). Tags are never reused, unlike fds: a report for a
+    // closed connection finds no route instead of reaching whoever got
+    // its fd next. Replies are sent under the mutex, and the disconnect
+    // callback takes it before the socket is closed.
+    std::mutex sessionsMutex;
+    struct Session {
+        uint64_t tag = 0;
+        AccountId defaultAccount = 0;
+        std::set<AccountId> accounts;
+    };
+    std::unordered_map<socket_t, Session> sessions;
+    std::unordered_map<uint64_t, socket_t> routes;
+    uint64_t nextSessionTag = 1;
+    AccountId nextSessionAccount = 1000000;
+    auto defaultAccount = [&](Session& session) {  // Under sessionsMutex
+        if (session.defaultAccount == 0) {
+            session.defaultAccount = nextSessionAccount++;
+        }
+        return session.defaultAccount;
+    };
     
     // Handle incoming messages
     server.setMessageCallback([&](const std::string& message, socket_t client) {
+        if (FIXMessage::peekMsgType(message) == FIXMessage::MSG_NEW_ORDER) {
+            // Limit the account the order will trade under: without tag 1
+            // that is the connection's own (key 0 would be unlimited)
+            AccountId account = FIXMessage::peekAccount(message);
+            if (account == 0) {
+                std::lock_guard<std::mutex> lock(sessionsMutex);
+                account = defaultAccount(sessions[client]);
+            }
+            if (!accountRates.tryAcquire(account)) {
+                return;
+            }
+        }
+        
         LOG_INFO("Received: ", message);
         
         try {
             FIXMessage fixMsg = FIXMessage::parse(message);
-            auto order = fixMsg.toOrder();
+            auto order = fixMsg.toOrder([&](auto&&... args) {
+                return memory.makeOrder(std::forward<decltype(args)>(args)...);
+            });
             
             if (order) {
-                LOG_INFO("Processing: ", order->toString());
-                auto trades = engine.submitOrder(order);
-                
-                // Send execution report
-                FIXMessage execReport = FIXMessage::createExecutionReport(
-                    *order, "EXEC_" + std::to_string(order->getId())
-                );
-                server.sendMessage(client, execReport.serialize());
+                uint64_t tag;
+                {
+                    std::lock_guard<std::mutex> lock(sessionsMutex);
+                    Session& session = sessions[client];
+                    if (session.tag == 0) {
+                        session.tag = nextSessionTag++;
+                        routes[session.tag] = client;
+                    }
+                    tag = session.tag;
+                    if (order->getAccountId() == 0) {
+                        order->setAccountId(defaultAccount(session));
+                    }
+                    session.accounts.insert(order->getAccountId());
+                }
                 
-                // Broadcast order book update
-                std::string bookUpdate = MarketDataPublisher::formatOrderBookJSON(
-                    engine.getOrderBook()
-                );
-                server.broadcast(bookUpdate + "\n");
+                LOG_INFO("Processing: ", order->toString());
+                engine.submitOrder(std::move(order), tag);
             }
         } catch (...) {
             LOG_ERROR("Error processing message");
         }
     });
     
-    // Handle trades
-    engine.setTradeCallback([&](const Trade& trade) {
-        LOG_INFO("TRADE: ", trade.toString());
-        std::string tradeMsg = MarketDataPublisher::formatTrade(trade);
-        server.broadcast(tradeMsg + "\n");
+    // Cancel on disconnect: pull everything the session left resting
+    server.setDisconnectCallback([&](socket_t client) {
+        std::set<AccountId> accounts;
+        {
+            std::lock_guard<std::mutex> lock(sessionsMutex);
+            auto it = sessions.find(client);
+            if (it == sessions.end()) return;
+            accounts = std::move(it->second.accounts);
+            routes.erase(it->second.tag);
+            sessions.erase(it);
+        }
+        
+        for (AccountId account : accounts) {
+            LOG_INFO("Disconnect: cancelling orders for account ", account);
+            engine.massCancel(account);
+        }
     });
     
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> tradeCount{0};
+    std::atomic<uint64_t> tradeVolume{0};
+    
+    ThreadSettings gatewaySettings = ThreadSettings::fromConfig("gateway");
+    ThreadSettings marketDataSettings = ThreadSettings::fromConfig("market_data");
+    
+    // Gateway stage: execution reports back to the submitting connection
+    auto gatewayStage = [&]() {
+        auto handle = [&](const EngineEvent& event) {
+            if (event.type != EngineEventType::ORDER_UPDATE || event.clientTag == 0) return;
+            TraceRecord record = event.trace;
+            TraceResume trace(record, true);
+            FIXMessage execReport = FIXMessage::createExecutionReport(
+                *event.order, "EXEC_" + std::to_string(event.orderId)
+            );
+            std::lock_guard<std::mutex> lock(sessionsMutex);
+            auto route = routes.find(event.clientTag);
+            if (route != routes.end()) {
+                server.sendMessage(route->second, execReport.serialize());
+            }
+        };
+        IdleStrategy idle(gatewaySettings.wait, &engine.getEventSignal());
+        auto ready = [&] { return gatewayFeed.backlog() > 0 || !running; };
+        while (running) {
+            if (gatewayFeed.poll(handle) > 0) idle.reset();
+            else idle.idle(ready);
+        }
+    };
+    
+    // Market data stage: trades and book changes to every connection
+    auto marketDataStage = [&]() {
+        auto handle = [&](const EngineEvent& event) {
+            if (event.type == EngineEventType::TRADE) {
+                const Trade& trade = *event.trade;
+                LOG_INFO("TRADE: ", trade.toString());
+                tradeCount.fetch_add(1, std::memory_order_relaxed);
+                tradeVolume.fetch_add(trade.getQuantity(), std::memory_order_relaxed);
+                server.broadcast(MarketDataPublisher::formatTrade(trade) + "\n");
+            } else if (event.type == EngineEventType::BOOK_UPDATE) {
+                std::string bookUpdate = MarketDataPublisher::formatOrderBookSnapshot(
+                    engine.getOrderBook()
+                );
+                server.broadcast(bookUpdate + "\n");
+            }
+        };
+        IdleStrategy idle(marketDataSettings.wait, &engine.getEventSignal());
+        auto ready = [&] { return marketDataFeed.backlog() > 0 || !running; };
+        while (running) {
+            if (marketDataFeed.poll(handle) > 0) idle.reset();
+            else idle.idle(ready);
+        }
+    };
+    
     if (server.start()) {
+        engine.start();
+        std::thread gatewayThread = ThreadRuntime::spawn("gateway", gatewaySettings, gatewayStage);
+        std::thread marketDataThread = ThreadRuntime::spawn("market-data", marketDataSettings,
+                                                            marketDataStage);
+        
+        if (metricsExporter.start()) {
+            LOG_INFO("✓ Metrics exporter on http://localhost:", metricsPort, "/metrics");
+        } else {
+            LOG_WARN("Failed to start metrics exporter on port ", metricsPort);
+        }
+        
         LOG_INFO("✓ Server started successfully!");
         LOG_INFO("Connect using: telnet localhost 8080");
         LOG_INFO("Press Ctrl+C to stop...\n");
@@ -69,12 +245,24 @@ int main() {
             // Print stats every 10 seconds
             static int counter = 0;
             if (++counter % 10 == 0) {
-                auto stats = engine.getStats();
                 LOG_INFO("Stats - Clients: ", server.getClientCount(),
-                        ", Trades: ", stats.totalTrades,
-                        ", Volume: ", stats.totalVolume);
+                        ", Orders: ", engine.getCommandsProcessed(),
+                        ", Trades: ", tradeCount.load(),
+                        ", Volume: ", tradeVolume.load());
+            }
+            
+            // Sampled per-stage traces for offline analysis
+            if (counter % 60 == 0) {
+                tracer.dumpSamples("latency_traces.bin");
             }
         }
+        
+        metricsExporter.stop();
+        server.stop();
+        engine.stop();
+        running = false;
+        gatewayThread.join();
+        marketDataThread.join();
     } else {
         LOG_ERROR("Failed to start server!");
     }
@@ -5,10 +5,20 @@
 #include "network/fix_message.hpp"
 #include "network/tcp_server.hpp"
 #include "network/market_data.hpp"
+#include "network/metrics_exporter.hpp"
+#include "risk/risk_manager.hpp"
+#include "utils/latency_trace.hpp"
+#include "utils/metrics.hpp"
+#include "utils/rate_limiter.hpp"
 #include "utils/logger.hpp"
 #include <iostream>
+#include <fstream>
 #include <thread>
 #include <chrono>
+#include <atomic>
+#ifndef _WIN32
+    #include <arpa/inet.h>
+#endif
 
 using namespace trading;
 using namespace trading::network;
@@ -271,6 +281,268 @@ void testIntegratedSystem() {
     }
 }
 
+void testLatencyTracing() {
+    LOG_INFO("\n=== Test 6: End-to-End Latency Tracing ===");
+    
+    TCPServer server(9092);
+    server.setTracing(true);
+    MatchingEngine engine("AAPL");
+    risk::RiskManager riskMgr;
+    
+    SystemMetrics& metrics = SystemMetrics::getInstance();
+    metrics.reset();
+    LatencyTracer& tracer = LatencyTracer::getInstance();
+    tracer.setSampleRate(1);
+    
+    std::atomic<int> processed{0};
+    server.setMessageCallback([&](const std::string& message, socket_t client) {
+        FIXMessage fixMsg = FIXMessage::parse(message);
+        auto order = fixMsg.toOrder();
+        if (order && riskMgr.validateOrder(*order, order->getPrice()) ==
+                     risk::RiskManager::ValidationResult::ACCEPTED) {
+            engine.submitOrder(order);
+            FIXMessage execReport = FIXMessage::createExecutionReport(
+                *order, "EXEC_" + std::to_string(order->getId())
+            );
+            server.sendMessage(client, execReport.serialize());
+        }
+        processed++;
+    });
+    
+    if (!server.start()) {
+        LOG_ERROR("✗ Failed to start TCP server on port 9092");
+        return;
+    }
+    
+    // Loopback client sending one order per round trip
+    socket_t client = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(9092);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    
+    const int NUM_MESSAGES = 20;
+    if (connect(client, (sockaddr*)&addr, sizeof(addr)) == 0) {
+        char reply[4096];
+        for (int i = 0; i < NUM_MESSAGES; ++i) {
+            std::string msg = FIXMessage::createNewOrder(
+                i + 1, "AAPL", (i % 2 == 0) ? Side::BUY : Side::SELL,
+                OrderType::LIMIT, 100, doubleToPrice(150.00)
+            ).serialize();
+            send(client, msg.c_str(), msg.length(), 0);
+            recv(client, reply, sizeof(reply), 0);
+        }
+    }
+#ifdef _WIN32
+    closesocket(client);
+#else
+    close(client);
+#endif
+    server.stop();
+    
+    auto endToEnd = metrics.getHistogram(SystemMetrics::Histogram::END_TO_END);
+    auto parse = metrics.getHistogram(SystemMetrics::Histogram::STAGE_PARSE);
+    auto match = metrics.getHistogram(SystemMetrics::Histogram::STAGE_MATCH);
+    
+    LOG_INFO("Messages processed: ", processed.load());
+    LOG_INFO("  Parse  P50 <= ", parse.percentile(50), " ns");
+    LOG_INFO("  Match  P50 <= ", match.percentile(50), " ns");
+    LOG_INFO("  E2E    P99 <= ", endToEnd.percentile(99), " ns");
+    
+    if (endToEnd.count == static_cast<uint64_t>(NUM_MESSAGES)) {
+        LOG_INFO("✓ Every message traced end to end");
+    } else {
+        LOG_ERROR("✗ Expected ", NUM_MESSAGES, " traces, got ", endToEnd.count);
+    }
+    
+    // Dump and read back the header
+    tracer.dumpSamples("latency_traces.bin");
+    std::ifstream dump("latency_traces.bin", std::ios::binary);
+    char magic[4] = {};
+    uint32_t header[3] = {};
+    double ticksPerNano = 0.0;
+    uint64_t count = 0;
+    dump.read(magic, sizeof(magic));
+    dump.read(reinterpret_cast<char*>(header), sizeof(header));
+    dump.read(reinterpret_cast<char*>(&ticksPerNano), sizeof(ticksPerNano));
+    dump.read(reinterpret_cast<char*>(&count), sizeof(count));
+    
+    if (std::string(magic, 4) == "HPTT" && header[1] == sizeof(TraceRecord) &&
+        count >= static_cast<uint64_t>(NUM_MESSAGES)) {
+        LOG_INFO("✓ Trace dump contains ", count, " records (",
+                 ticksPerNano, " TSC ticks/ns)");
+    } else {
+        LOG_ERROR("✗ Trace dump malformed");
+    }
+    
+    tracer.setSampleRate(1024);
+}
+
+void testRateLimits() {
+    LOG_INFO("\n=== Test 7: Gateway Rate Limits ===");
+    
+    // 1. Bucket arithmetic on explicit TSC times: a burst of 10, then one per interval
+    TokenBucket bucket(1000.0, 10);
+    uint64_t now = rdtsc();
+    int burst = 0;
+    while (bucket.tryAcquire(now)) burst++;
+    bool refills = !bucket.tryAcquire(now + bucket.getInterval() / 2) &&
+                   bucket.tryAcquire(now + bucket.getInterval()) &&
+                   !bucket.tryAcquire(now + bucket.getInterval());
+    LOG_INFO("Bucket: burst of ", burst, ", ", bucket.getInterval(), " TSC ticks per token");
+    
+    // 2. Per-account buckets; a full table refuses new accounts
+    KeyedRateLimiter accounts(1000.0, 5, 2);
+    int firstAccount = 0;
+    while (accounts.tryAcquire(1, now)) firstAccount++;
+    bool keyed = firstAccount == 5 && accounts.tryAcquire(2, now) &&
+                 !accounts.tryAcquire(3, now) && accounts.tryAcquire(0, now);
+    
+    // 3. Peek agrees with the full parse
+    FIXMessage newOrder = FIXMessage::createNewOrder(
+        1, "AAPL", Side::BUY, OrderType::LIMIT, 100, doubleToPrice(150.00));
+    newOrder.setField(FIXMessage::TAG_ACCOUNT, "4711");
+    std::string raw = newOrder.serialize();
+    FIXMessage parsed = FIXMessage::parse(raw);
+    bool peeked = FIXMessage::peekMsgType(raw) == FIXMessage::MSG_NEW_ORDER &&
+                  FIXMessage::peekAccount(raw) == 4711 &&
+                  static_cast<int>(FIXMessage::peekAccount(raw)) ==
+                      parsed.getFieldAsInt(FIXMessage::TAG_ACCOUNT) &&
+                  FIXMessage::peekMsgType("garbage") == '\0';
+    
+    // 4. RiskManager enforces maxOrdersPerSecond
+    risk::RiskLimits limits;
+    limits.maxOrdersPerSecond = 50;
+    risk::RiskManager riskMgr(limits);
+    Order order(1, "AAPL", Side::BUY, OrderType::LIMIT, doubleToPrice(150.00), 10);
+    int accepted = 0;
+    int rateLimited = 0;
+    for (int i = 0; i < 60; ++i) {
+        auto result = riskMgr.validateOrder(order, doubleToPrice(150.00));
+        if (result == risk::RiskManager::ValidationResult::ACCEPTED) accepted++;
+        if (result == risk::RiskManager::ValidationResult::REJECTED_RATE_LIMIT) rateLimited++;
+    }
+    LOG_INFO("RiskManager at 50/s: ", accepted, " accepted, ", rateLimited, " rate limited");
+    
+    // 5. A flooding connection is cut off before the message callback,
+    // message by message however the bytes arrive
+    TCPServer server(9093);
+    server.setFraming(&FIXMessage::frameLength);
+    server.setSessionRateLimit(1.0, 5);
+    std::atomic<int> delivered{0};
+    std::atomic<int> mangled{0};
+    server.setMessageCallback([&](const std::string& message, socket_t) {
+        delivered++;
+        if (message != raw) mangled++;
+    });
+    
+    const int FLOOD = 20;
+    std::string flood;
+    for (int i = 0; i < FLOOD; ++i) {
+        flood += raw;
+    }
+    if (server.start()) {
+        socket_t client = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(9093);
+        inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        if (connect(client, (sockaddr*)&addr, sizeof(addr)) == 0) {
+            // Two writes split mid-message, each carrying several messages
+            size_t split = flood.length() / 2 + raw.length() / 3;
+            send(client, flood.c_str(), split, 0);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            send(client, flood.c_str() + split, flood.length() - split, 0);
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+#ifdef _WIN32
+        closesocket(client);
+#else
+        close(client);
+#endif
+        server.stop();
+    }
+    LOG_INFO("Session at 1/s, burst 5: ", delivered.load(), " delivered, ",
+             server.getMessagesThrottled(), " dropped");
+    bool throttled = delivered.load() == 5 && mangled.load() == 0 &&
+                     server.getMessagesThrottled() == static_cast<uint64_t>(FLOOD - 5);
+    
+    if (burst == 10 && refills && keyed && peeked && accepted == 50 && rateLimited == 10 &&
+        throttled) {
+        LOG_INFO("✓ Rate limits hold per session, per account and in the risk check");
+    } else {
+        LOG_ERROR("✗ Rate limit mismatch (bucket ", burst == 10 && refills, ", accounts ", keyed,
+                  ", peek ", peeked, ", risk ", accepted, "/", rateLimited,
+                  ", session ", throttled, ")");
+    }
+}
+
+// One request on a fresh loopback connection; returns the whole response
+std::string httpRequest(uint16_t port, const std::string& request) {
+    std::string response;
+    socket_t client = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(client, (sockaddr*)&addr, sizeof(addr)) == 0) {
+        send(client, request.c_str(), request.length(), 0);
+        char buffer[4096];
+        for (;;) {
+            auto received = recv(client, buffer, sizeof(buffer), 0);
+            if (received <= 0) break;
+            response.append(buffer, static_cast<size_t>(received));
+        }
+    }
+#ifdef _WIN32
+    closesocket(client);
+#else
+    close(client);
+#endif
+    return response;
+}
+
+void testMetricsExport() {
+    LOG_INFO("\n=== Test 8: Prometheus Metrics Export ===");
+    
+    SystemMetrics& metrics = SystemMetrics::getInstance();
+    LatencyTracer& tracer = LatencyTracer::getInstance();
+    uint64_t tracesBefore = metrics.getHistogram(SystemMetrics::Histogram::END_TO_END).count;
+    uint64_t samplesBefore = tracer.getSampledCount();
+    
+    MetricsExporter exporter(9094);
+    std::string scrape;
+    std::string query;
+    std::string longer;
+    std::string other;
+    if (exporter.start()) {
+        scrape = httpRequest(9094, "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        query = httpRequest(9094, "GET /metrics?name=x HTTP/1.1\r\n\r\n");
+        longer = httpRequest(9094, "GET /metricsXYZ HTTP/1.1\r\n\r\n");
+        other = httpRequest(9094, "GET /metrics-old HTTP/1.1\r\n\r\n");
+        exporter.stop();
+    }
+    
+    // Scrapes are not order flow: they must not land in the stage histograms
+    uint64_t tracesAfter = metrics.getHistogram(SystemMetrics::Histogram::END_TO_END).count;
+    bool served = scrape.compare(0, 15, "HTTP/1.1 200 OK") == 0 &&
+                  scrape.find("trading_") != std::string::npos;
+    bool untraced = tracesAfter == tracesBefore && tracer.getSampledCount() == samplesBefore;
+    
+    // Only the exact path (optionally with a query) is served
+    bool exactPath = query.compare(0, 15, "HTTP/1.1 200 OK") == 0 &&
+                     longer.compare(0, 12, "HTTP/1.1 404") == 0 &&
+                     other.compare(0, 12, "HTTP/1.1 404") == 0;
+    LOG_INFO("Scrape: ", scrape.size(), " bytes, traces ", tracesBefore, " -> ", tracesAfter);
+    
+    if (served && untraced && exactPath) {
+        LOG_INFO("✓ Metrics served on /metrics only, without tracing the scrape");
+    } else {
+        LOG_ERROR("✗ Metrics export mismatch (served ", served, ", untraced ", untraced,
+                  ", path ", exactPath, ")");
+    }
+}
+
 int main() {
     Logger::getInstance().setLogLevel(LogLevel::INFO);
     Logger::getInstance().setOutputFile("network_test.log");
@@ -285,6 +557,9 @@ int main() {
         testMarketDataFormatting();
         testTCPServer();
         testIntegratedSystem();
+        testLatencyTracing();
+        testRateLimits();
+        testMetricsExport();
         
         LOG_INFO("\n========================================");
         LOG_INFO("All Phase 5 tests completed successfully!");
@@ -3,9 +3,14 @@
 #include "engine/price_level.hpp"
 #include "engine/order_book.hpp"
 #include "utils/logger.hpp"
+#include "utils/memory_arena.hpp"
 #include "utils/timer.hpp"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <vector>
+#include <thread>
+#include <atomic>
 
 using namespace trading;
 using namespace trading::utils;
@@ -185,6 +190,164 @@ void testOrderModification() {
     LOG_INFO("✓ Order modification tests passed\n");
 }
 
+void testOrderAmend() {
+    LOG_INFO("=== Testing In-Place Order Amend ===");
+    
+    OrderBook book("AAPL");
+    Price price = doubleToPrice(150.00);
+    auto first = std::make_shared<Order>(1, "AAPL", Side::BUY, OrderType::LIMIT, price, 300);
+    auto second = std::make_shared<Order>(2, "AAPL", Side::BUY, OrderType::LIMIT, price, 200);
+    book.addOrder(first);
+    book.addOrder(second);
+    
+    // Amend down keeps the order at the front of the queue
+    bool reduced = book.amendOrder(1, price, 100);
+    bool keptPriority = reduced && book.getBestBidOrder() == first &&
+                        first->getRemainingQuantity() == 100 &&
+                        book.getTotalBidQuantity() == 300 &&
+                        book.getBidDepth(1)[0].quantity == 300;
+    LOG_INFO("Amend down: front order ", book.getBestBidOrder()->getId(),
+             ", level qty ", book.getBidDepth(1)[0].quantity);
+    
+    // Amend up loses priority but keeps the same Order object
+    bool increased = book.amendOrder(1, price, 400);
+    bool requeued = increased && book.getBestBidOrder() == second &&
+                    book.getOrder(1) == first && book.getTotalBidQuantity() == 600;
+    LOG_INFO("Amend up: front order ", book.getBestBidOrder()->getId(),
+             ", total bid qty ", book.getTotalBidQuantity());
+    
+    // Price change moves the order to its new level
+    bool moved = book.amendOrder(2, doubleToPrice(150.50), 200);
+    bool relevelled = moved && *book.getBestBid() == doubleToPrice(150.50) &&
+                      book.getBestBidOrder() == second &&
+                      book.getStats().bidLevels == 2 && book.getStats().bidOrders == 2;
+    
+    bool rejected = !book.amendOrder(99, price, 100) && !book.amendOrder(1, price, 0);
+    
+    if (keptPriority && requeued && relevelled && rejected) {
+        LOG_INFO("✓ Order amend tests passed\n");
+    } else {
+        LOG_ERROR("✗ Order amend produced wrong priority or totals\n");
+    }
+}
+
+void testMassCancel() {
+    LOG_INFO("=== Testing Mass Cancel ===");
+    
+    OrderBook book("AAPL");
+    const AccountId maker = 7;
+    const AccountId other = 8;
+    const int perSide = 10000;
+    
+    // Interleave the maker's quotes with another account's at the same levels
+    OrderId nextId = 1;
+    for (int i = 0; i < perSide; ++i) {
+        Price bid = doubleToPrice(149.00) - (i % 50) * doubleToPrice(0.01);
+        Price ask = doubleToPrice(151.00) + (i % 50) * doubleToPrice(0.01);
+        for (AccountId account : {maker, other}) {
+            auto buy = std::make_shared<Order>(nextId++, "AAPL", Side::BUY, OrderType::LIMIT, bid, 100);
+            auto sell = std::make_shared<Order>(nextId++, "AAPL", Side::SELL, OrderType::LIMIT, ask, 100);
+            buy->setAccountId(account);
+            sell->setAccountId(account);
+            book.addOrder(buy);
+            book.addOrder(sell);
+        }
+    }
+    
+    bool counted = book.getAccountOrderCount(maker) == 2 * perSide &&
+                   book.getAccountOrderCount(other) == 2 * perSide;
+    
+    // Side filter first, then everything left
+    auto start = std::chrono::high_resolution_clock::now();
+    auto bids = book.massCancel(maker, Side::BUY);
+    auto end = std::chrono::high_resolution_clock::now();
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    
+    bool bidsOnly = bids.size() == static_cast<size_t>(perSide) &&
+                    book.getAccountOrderCount(maker) == static_cast<size_t>(perSide) &&
+                    book.getStats().bidOrders == static_cast<size_t>(perSide) &&
+                    book.getStats().askOrders == static_cast<size_t>(2 * perSide);
+    bool allCancelled = std::all_of(bids.begin(), bids.end(), [](const std::shared_ptr<Order>& order) {
+        return order->getStatus() == OrderStatus::CANCELLED;
+    });
+    LOG_INFO("Cancelled ", bids.size(), " bids in ", micros, " us");
+    
+    auto rest = book.massCancel(maker);
+    bool emptied = rest.size() == static_cast<size_t>(perSide) &&
+                   book.getAccountOrderCount(maker) == 0 &&
+                   book.getStats().totalOrders == static_cast<size_t>(2 * perSide) &&
+                   book.getTotalBidQuantity() == static_cast<Quantity>(perSide) * 100 &&
+                   book.getStats().bidLevels == 50 && book.getStats().askLevels == 50;
+    
+    // The other account's queue is intact and an unknown account is a no-op
+    bool untouched = book.getBestBidOrder()->getAccountId() == other &&
+                     book.getBidDepth(1)[0].orderCount == static_cast<size_t>(perSide / 50) &&
+                     book.massCancel(99).empty() && book.massCancel(maker).empty();
+    
+    if (counted && bidsOnly && allCancelled && emptied && untouched) {
+        LOG_INFO("✓ Mass cancel tests passed\n");
+    } else {
+        LOG_ERROR("✗ Mass cancel left wrong orders or totals\n");
+    }
+}
+
+void testBookMemory() {
+    LOG_INFO("=== Testing Per-Book Node Pools ===");
+    
+    MemoryArena arena;
+    OrderBook aapl("AAPL", &arena);
+    OrderBook msft("MSFT");
+    const int levels = 500;
+    
+    auto fill = [&](OrderBook& book, const Symbol& symbol, OrderId firstId) {
+        std::vector<std::shared_ptr<Order>> orders;
+        for (int i = 0; i < levels; ++i) {
+            Price bid = doubleToPrice(100.00) - i * doubleToPrice(0.01);
+            Price ask = doubleToPrice(101.00) + i * doubleToPrice(0.01);
+            orders.push_back(std::make_shared<Order>(firstId++, symbol, Side::BUY, OrderType::LIMIT, bid, 100));
+            orders.push_back(std::make_shared<Order>(firstId++, symbol, Side::SELL, OrderType::LIMIT, ask, 100));
+            orders.back()->setAccountId(1 + i % 10);
+            book.addOrder(orders[orders.size() - 2]);
+            book.addOrder(orders.back());
+        }
+        return orders;
+    };
+    
+    auto aaplOrders = fill(aapl, "AAPL", 1);
+    fill(msft, "MSFT", 1);
+    
+    auto loaded = aapl.getMemoryStats();
+    auto other = msft.getMemoryStats();
+    LOG_INFO("AAPL book: ", loaded.bytesInUse, " bytes in use, ", loaded.chunks, " chunks (",
+             loaded.arenaChunks, " from the arena)");
+    
+    // Each book holds its own level nodes, the arena-backed one in the arena
+    bool separate = loaded.bytesInUse > 0 && other.bytesInUse > 0 &&
+                    loaded.arenaChunks == loaded.chunks && other.arenaChunks == 0 &&
+                    arena.getUsed() >= loaded.bytesReserved;
+    
+    // Emptying the book hands every level node back to its free lists...
+    for (const auto& order : aaplOrders) {
+        aapl.cancelOrder(order->getId());
+    }
+    auto emptied = aapl.getMemoryStats();
+    
+    // ...and refilling reuses them without new chunks
+    fill(aapl, "AAPL", 100000);
+    auto refilled = aapl.getMemoryStats();
+    
+    bool recycled = emptied.bytesInUse < loaded.bytesInUse &&
+                    refilled.chunks == loaded.chunks &&
+                    refilled.bytesInUse == loaded.bytesInUse &&
+                    aapl.getStats().bidLevels == static_cast<size_t>(levels);
+    
+    if (separate && recycled) {
+        LOG_INFO("✓ Per-book pool tests passed\n");
+    } else {
+        LOG_ERROR("✗ Book node pools shared, leaked or grew\n");
+    }
+}
+
 void testPerformance() {
     LOG_INFO("=== Testing Order Book Performance ===");
     
@@ -245,6 +408,154 @@ void testPerformance() {
     LOG_INFO("✓ Performance tests completed\n");
 }
 
+void testIncrementalAggregates() {
+    LOG_INFO("=== Testing Incremental Book Aggregates ===");
+    
+    OrderBook book("AAPL");
+    std::vector<std::shared_ptr<Order>> orders;
+    
+    // Reader thread: snapshots must always be internally consistent
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> snapshots{0};
+    std::atomic<uint64_t> inconsistent{0};
+    std::thread reader([&]() {
+        while (!done.load(std::memory_order_relaxed)) {
+            auto snap = book.getStatsSnapshot();
+            if (snap.totalOrders != snap.bidOrders + snap.askOrders ||
+                (snap.bidOrders == 0) != (snap.bidLevels == 0) ||
+                (snap.askOrders == 0) != (snap.askLevels == 0)) {
+                inconsistent++;
+            }
+            snapshots++;
+        }
+    });
+    
+    // Adds, cancels and partial/full fills across many levels
+    for (int i = 0; i < 20000; ++i) {
+        Side side = (i % 2 == 0) ? Side::BUY : Side::SELL;
+        Price price = side == Side::BUY ? doubleToPrice(149.00 + (i % 50) * 0.01)
+                                        : doubleToPrice(151.00 + (i % 50) * 0.01);
+        auto order = std::make_shared<Order>(i, "AAPL", side, OrderType::LIMIT,
+                                             price, 100 + (i % 7) * 10);
+        book.addOrder(order);
+        orders.push_back(order);
+        
+        if (i % 5 == 0) {
+            book.cancelOrder(i / 2);
+        } else if (i % 3 == 0) {
+            auto front = (i % 2 == 0) ? book.getBestBidOrder() : book.getBestAskOrder();
+            if (front) book.fillOrder(front, 60);
+        }
+    }
+    
+    done = true;
+    reader.join();
+    
+    // Compare running totals against a full scan
+    auto stats = book.getStats();
+    Quantity bidQty = 0, askQty = 0;
+    size_t bidOrders = 0, askOrders = 0;
+    int64_t bidNotional = 0, askNotional = 0;
+    for (const auto& level : book.getBidDepth(SIZE_MAX)) {
+        bidQty += level.quantity;
+        bidOrders += level.orderCount;
+        bidNotional += level.price * static_cast<int64_t>(level.quantity);
+    }
+    for (const auto& level : book.getAskDepth(SIZE_MAX)) {
+        askQty += level.quantity;
+        askOrders += level.orderCount;
+        askNotional += level.price * static_cast<int64_t>(level.quantity);
+    }
+    
+    bool match = stats.totalBidQty == bidQty && stats.totalAskQty == askQty &&
+                 stats.bidOrders == bidOrders && stats.askOrders == askOrders &&
+                 stats.bidNotional == bidNotional && stats.askNotional == askNotional;
+    
+    LOG_INFO("Orders: ", stats.totalOrders, ", Bid Qty: ", stats.totalBidQty,
+             ", Ask Qty: ", stats.totalAskQty);
+    LOG_INFO("Reader took ", snapshots.load(), " snapshots, ", 
+             inconsistent.load(), " inconsistent");
+    
+    if (match && inconsistent == 0) {
+        LOG_INFO("✓ Incremental aggregates match full scan\n");
+    } else {
+        LOG_ERROR("✗ Incremental aggregates diverged from full scan\n");
+    }
+}
+
+void testTopOfBookReaders() {
+    LOG_INFO("=== Testing Published Top of Book ===");
+    
+    OrderBook book("AAPL");
+    
+    // Readers: every snapshot must be sorted, uncrossed and non-empty per level
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> snapshots{0};
+    std::atomic<uint64_t> inconsistent{0};
+    auto readerLoop = [&]() {
+        while (!done.load(std::memory_order_relaxed)) {
+            TopOfBook top = book.getTopOfBook();
+            bool ok = top.bidLevels <= TopOfBook::MAX_DEPTH &&
+                      top.askLevels <= TopOfBook::MAX_DEPTH;
+            for (uint32_t i = 0; ok && i < top.bidLevels; ++i) {
+                ok = top.bids[i].quantity > 0 && top.bids[i].orderCount > 0 &&
+                     (i == 0 || top.bids[i].price < top.bids[i - 1].price);
+            }
+            for (uint32_t i = 0; ok && i < top.askLevels; ++i) {
+                ok = top.asks[i].quantity > 0 && top.asks[i].orderCount > 0 &&
+                     (i == 0 || top.asks[i].price > top.asks[i - 1].price);
+            }
+            if (ok && top.bidLevels > 0 && top.askLevels > 0) {
+                ok = top.bids[0].price < top.asks[0].price;
+            }
+            if (!ok) inconsistent++;
+            snapshots++;
+        }
+    };
+    std::thread reader1(readerLoop);
+    std::thread reader2(readerLoop);
+    
+    for (int i = 0; i < 20000; ++i) {
+        Side side = (i % 2 == 0) ? Side::BUY : Side::SELL;
+        Price price = side == Side::BUY ? doubleToPrice(149.00 + (i % 40) * 0.01)
+                                        : doubleToPrice(151.00 + (i % 40) * 0.01);
+        book.addOrder(std::make_shared<Order>(i, "AAPL", side, OrderType::LIMIT,
+                                              price, 100 + (i % 5) * 10));
+        
+        if (i % 4 == 0) {
+            book.cancelOrder(i / 2);
+        } else if (i % 3 == 0) {
+            auto front = (i % 2 == 0) ? book.getBestBidOrder() : book.getBestAskOrder();
+            if (front) book.fillOrder(front, 100);
+        }
+    }
+    
+    done = true;
+    reader1.join();
+    reader2.join();
+    
+    // Final snapshot must equal the live book's best levels
+    TopOfBook top = book.getTopOfBook();
+    auto bids = book.getBidDepth(TopOfBook::MAX_DEPTH);
+    auto asks = book.getAskDepth(TopOfBook::MAX_DEPTH);
+    bool match = top.bidLevels == bids.size() && top.askLevels == asks.size();
+    for (size_t i = 0; match && i < bids.size(); ++i) {
+        match = top.bids[i].price == bids[i].price && top.bids[i].quantity == bids[i].quantity;
+    }
+    for (size_t i = 0; match && i < asks.size(); ++i) {
+        match = top.asks[i].price == asks[i].price && top.asks[i].quantity == asks[i].quantity;
+    }
+    
+    LOG_INFO("Readers took ", snapshots.load(), " snapshots, ",
+             inconsistent.load(), " inconsistent");
+    
+    if (match && inconsistent == 0) {
+        LOG_INFO("✓ Top of book snapshots consistent\n");
+    } else {
+        LOG_ERROR("✗ Top of book snapshot inconsistent with live book\n");
+    }
+}
+
 int main() {
     // Set up logging
     Logger::getInstance().setLogLevel(LogLevel::INFO);
@@ -260,6 +571,11 @@ int main() {
         testOrderBookDisplay();
         testOrderCancellation();
         testOrderModification();
+        testOrderAmend();
+        testIncrementalAggregates();
+        testTopOfBookReaders();
+        testMassCancel();
+        testBookMemory();
         testPerformance();
         
         LOG_INFO("========================================");
@@ -1,12 +1,19 @@
 #include "core/types.hpp"
 #include "core/order.hpp"
 #include "engine/matching_engine.hpp"
+#include "engine/engine_runner.hpp"
+#include "engine/order_index.hpp"
+#include "utils/memory_arena.hpp"
 #include "utils/memory_pool.hpp"
 #include "utils/lockfree_queue.hpp"
 #include "utils/profiler.hpp"
 #include "utils/logger.hpp"
+#include <algorithm>
 #include <iostream>
+#include <random>
+#include <unordered_map>
 #include <thread>
+#include <atomic>
 #include <chrono>
 
 using namespace trading;
@@ -188,7 +195,7 @@ void testThroughput() {
     LOG_INFO("\nMatching Statistics:");
     LOG_INFO("  Total trades: ", stats.totalTrades);
     LOG_INFO("  Total volume: ", stats.totalVolume, " shares");
-    LOG_INFO("  Total value: $", static_cast<uint64_t>(stats.totalValue));
+    LOG_INFO("  Total value: $", static_cast<uint64_t>(notionalToDouble(stats.totalValue)));
     
     LOG_INFO("✓ Throughput test completed");
 }
@@ -237,17 +244,33 @@ void testCacheBehavior() {
 void testMultithreadedSubmission() {
     LOG_INFO("\n=== Test 6: Multi-threaded Order Submission ===");
     
-    MatchingEngine engine("AAPL");
+    // Producers enqueue; only the runner's thread touches the engine
+    EngineRunner runner("AAPL");
+    auto fills = runner.addConsumer();
     const int NUM_THREADS = 4;
     const int ORDERS_PER_THREAD = 25000;
     
     std::vector<std::thread> threads;
     std::atomic<uint64_t> totalLatency{0};
+    std::atomic<bool> done{false};
+    uint64_t tradesSeen = 0;
+    
+    // Downstream stage draining the event ring in parallel
+    std::thread consumer([&]() {
+        auto count = [&tradesSeen](const EngineEvent& event) {
+            if (event.type == EngineEventType::TRADE) tradesSeen++;
+        };
+        while (!done.load(std::memory_order_acquire)) {
+            if (fills.poll(count) == 0) std::this_thread::yield();
+        }
+        fills.poll(count);
+    });
     
+    runner.start();
     Timer timer;
     
     for (int t = 0; t < NUM_THREADS; ++t) {
-        threads.emplace_back([&engine, t, ORDERS_PER_THREAD, &totalLatency]() {
+        threads.emplace_back([&runner, t, ORDERS_PER_THREAD, &totalLatency]() {
             LatencyMeasurer latency;
             uint64_t threadLatency = 0;
             
@@ -255,13 +278,13 @@ void testMultithreadedSubmission() {
                 Side side = (i % 2 == 0) ? Side::BUY : Side::SELL;
                 
                 auto order = std::make_shared<Order>(
-                    t * ORDERS_PER_THREAD + i,
+                    t * ORDERS_PER_THREAD + i + 1,
                     "AAPL", side, OrderType::LIMIT,
                     doubleToPrice(150.0 + (i % 50) * 0.01), 100
                 );
                 
                 latency.start();
-                engine.submitOrder(order);
+                runner.submitOrder(std::move(order));
                 threadLatency += latency.end();
             }
             
@@ -273,18 +296,307 @@ void testMultithreadedSubmission() {
         thread.join();
     }
     
+    runner.stop();
     uint64_t elapsed = timer.elapsedMicros();
+    done.store(true, std::memory_order_release);
+    consumer.join();
+    
     int totalOrders = NUM_THREADS * ORDERS_PER_THREAD;
     
-    LOG_INFO("Processed ", totalOrders, " orders from ", NUM_THREADS, 
+    LOG_INFO("Processed ", runner.getCommandsProcessed(), " orders from ", NUM_THREADS, 
              " threads in ", elapsed, " µs");
     LOG_INFO("Throughput: ", (totalOrders * 1000000ULL) / elapsed, " orders/sec");
     
     uint64_t avgCycles = totalLatency.load() / totalOrders;
-    LOG_INFO("Average latency: ", avgCycles, " cycles");
+    LOG_INFO("Average enqueue latency: ", avgCycles, " cycles");
     LOG_INFO("Estimated: ", static_cast<uint64_t>(avgCycles / 2.5), " ns @ 2.5 GHz");
     
-    LOG_INFO("✓ Multi-threaded test completed");
+    auto stats = runner.getEngine().getStats();
+    if (runner.getCommandsProcessed() == static_cast<uint64_t>(totalOrders) &&
+        tradesSeen == stats.totalTrades) {
+        LOG_INFO("✓ Multi-threaded test completed");
+    } else {
+        LOG_ERROR("✗ Multi-threaded submission lost orders or trades");
+    }
+}
+
+void testOrderIndex() {
+    LOG_INFO("\n=== Test 7: Order Index vs unordered_map ===");
+    
+    const int NUM_ORDERS = 500000;
+    std::vector<std::shared_ptr<Order>> orders;
+    orders.reserve(NUM_ORDERS);
+    for (int i = 0; i < NUM_ORDERS; ++i) {
+        orders.push_back(std::make_shared<Order>(
+            i + 1, "AAPL", Side::BUY, OrderType::LIMIT, doubleToPrice(150.0), 100));
+    }
+    
+    // Cancels arrive out of order: erase in a shuffled sequence
+    std::vector<OrderId> eraseOrder;
+    eraseOrder.reserve(NUM_ORDERS);
+    for (int i = 0; i < NUM_ORDERS; ++i) eraseOrder.push_back(i + 1);
+    std::shuffle(eraseOrder.begin(), eraseOrder.end(), std::mt19937_64(42));
+    
+    // Same workload against both containers: insert, look up, erase half, look up again
+    auto run = [&](auto insert, auto lookup, auto erase, const char* name) {
+        Timer timer;
+        for (const auto& order : orders) insert(order);
+        uint64_t insertTime = timer.elapsedMicros();
+        
+        timer.reset();
+        size_t found = 0;
+        for (OrderId id = 1; id <= static_cast<OrderId>(NUM_ORDERS); ++id) {
+            found += lookup(id) ? 1 : 0;
+        }
+        uint64_t lookupTime = timer.elapsedMicros();
+        
+        timer.reset();
+        for (int i = 0; i < NUM_ORDERS / 2; ++i) erase(eraseOrder[i]);
+        uint64_t eraseTime = timer.elapsedMicros();
+        
+        timer.reset();
+        size_t remaining = 0;
+        for (OrderId id : eraseOrder) {
+            remaining += lookup(id) ? 1 : 0;
+        }
+        uint64_t churnLookupTime = timer.elapsedMicros();
+        
+        LOG_INFO(name, ": insert ", insertTime * 1000.0 / NUM_ORDERS,
+                 " ns, lookup ", lookupTime * 1000.0 / NUM_ORDERS,
+                 " ns, erase ", eraseTime * 1000.0 / (NUM_ORDERS / 2),
+                 " ns, lookup after churn ", churnLookupTime * 1000.0 / NUM_ORDERS, " ns");
+        return found == static_cast<size_t>(NUM_ORDERS) &&
+               remaining == static_cast<size_t>(NUM_ORDERS - NUM_ORDERS / 2);
+    };
+    
+    std::unordered_map<OrderId, std::shared_ptr<Order>> map;
+    bool mapOk = run(
+        [&](const std::shared_ptr<Order>& order) { map.emplace(order->getId(), order); },
+        [&](OrderId id) { auto it = map.find(id); return it != map.end() ? it->second.get() : nullptr; },
+        [&](OrderId id) { map.erase(id); },
+        "unordered_map");
+    
+    OrderIndex index;
+    bool indexOk = run(
+        [&](const std::shared_ptr<Order>& order) { index.insert(order->getId(), order); },
+        [&](OrderId id) { auto order = index.find(id); return order ? order->get() : nullptr; },
+        [&](OrderId id) { index.erase(id); },
+        "OrderIndex   ");
+    
+    // Every surviving id still maps to its own order after the backward shifts
+    bool consistent = index.size() == map.size();
+    for (const auto& [id, order] : map) {
+        auto entry = index.find(id);
+        consistent = consistent && entry && *entry == order;
+    }
+    
+    if (mapOk && indexOk && consistent) {
+        LOG_INFO("✓ Order index test completed");
+    } else {
+        LOG_ERROR("✗ Order index lookups disagree with unordered_map");
+    }
+}
+
+template<typename Pool>
+uint64_t churnPool(Pool& pool, int rounds, int batch) {
+    std::vector<Order*> live;
+    live.reserve(batch);
+    Timer timer;
+    for (int r = 0; r < rounds; ++r) {
+        for (int i = 0; i < batch; ++i) {
+            live.push_back(pool.construct(
+                r * batch + i, "AAPL", Side::BUY, OrderType::LIMIT,
+                doubleToPrice(150.0), 100
+            ));
+        }
+        for (Order* order : live) {
+            pool.destroy(order);
+        }
+        live.clear();
+    }
+    return timer.elapsedMicros();
+}
+
+void testLocalMemoryPool() {
+    LOG_INFO("\n=== Test 8: Single-Owner Pool with Remote Free ===");
+    
+    const int ROUNDS = 2000;
+    const int BATCH = 500;
+    const double OPS = 2.0 * ROUNDS * BATCH;  // allocate + free
+    
+    // Owner-only churn: CAS free list vs plain pointer free list
+    MemoryPool<Order, 1024> shared;
+    LocalMemoryPool<Order, 1024> local;
+    uint64_t sharedTime = churnPool(shared, ROUNDS, BATCH);
+    uint64_t localTime = churnPool(local, ROUNDS, BATCH);
+    
+    LOG_INFO("Shared pool: ", sharedTime * 1000.0 / OPS, " ns per op");
+    LOG_INFO("Local pool:  ", localTime * 1000.0 / OPS, " ns per op");
+    
+    // Cross-thread: the owner allocates and hands orders to a releaser
+    // thread (as the engine hands them to a publisher), which frees them
+    const int HANDOFFS = 200000;
+    LocalMemoryPool<Order, 1024> owned;
+    LockFreeQueue<Order*, 4096> handoff;
+    std::atomic<bool> producing{true};
+    
+    std::thread releaser([&]() {
+        Order* order = nullptr;
+        for (;;) {
+            if (handoff.tryPop(order)) {
+                owned.destroyRemote(order);
+            } else if (!producing.load(std::memory_order_acquire)) {
+                if (!handoff.tryPop(order)) break;
+                owned.destroyRemote(order);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    
+    Timer timer;
+    for (int i = 0; i < HANDOFFS; ++i) {
+        Order* order = owned.construct(
+            i, "AAPL", Side::SELL, OrderType::LIMIT, doubleToPrice(150.0), 100
+        );
+        while (!handoff.tryPush(order)) {
+            std::this_thread::yield();
+        }
+    }
+    producing.store(false, std::memory_order_release);
+    releaser.join();
+    uint64_t handoffTime = timer.elapsedMicros();
+    owned.reclaimRemote();
+    
+    auto stats = owned.getStats();
+    LOG_INFO("Cross-thread: ", HANDOFFS, " orders allocated here and freed remotely in ",
+             handoffTime, " µs (", handoffTime * 1000.0 / HANDOFFS, " ns per order)");
+    LOG_INFO("Pool stats: ", stats.blocksAllocated, " blocks, ", stats.totalCapacity,
+             " capacity, ", stats.remoteReclaimed, " reclaimed from remote frees");
+    
+    // Every remote free came back, and the pool recycled instead of growing
+    bool recycled = stats.remoteReclaimed == static_cast<size_t>(HANDOFFS) &&
+                    stats.totalCapacity < static_cast<size_t>(HANDOFFS);
+    
+    // All capacity is on the local list again: draining it needs no new block
+    std::vector<Order*> drained;
+    for (size_t i = 0; i < stats.totalCapacity; ++i) {
+        drained.push_back(owned.allocate());
+    }
+    bool noGrowth = owned.getStats().blocksAllocated == stats.blocksAllocated;
+    for (Order* order : drained) {
+        owned.deallocate(order);
+    }
+    
+    if (recycled && noGrowth) {
+        LOG_INFO("✓ Local memory pool test completed");
+    } else {
+        LOG_ERROR("✗ Remote frees were not reclaimed");
+    }
+}
+
+void testArenaPools() {
+    LOG_INFO("\n=== Test 9: Pre-faulted Arena-Backed Pools ===");
+    
+    ArenaSettings settings;
+    settings.bytes = 32 * 1024 * 1024;
+    
+    Timer timer;
+    MemoryArena arena(settings);
+    auto arenaStats = arena.getStats();
+    LOG_INFO("Arena: ", arenaStats.capacity >> 20, " MB mapped and pre-faulted in ",
+             timer.elapsedMicros(), " µs (",
+             arenaStats.hugePages ? "hugepages" : "normal pages", ", ",
+             arenaStats.locked ? "locked" : "not locked", ")");
+    
+    // Reserve at startup, then trade without growing
+    const int NUM_ORDERS = 50000;
+    SharedPool<Order> orders(&arena);
+    orders.reserve(NUM_ORDERS);
+    size_t usedAfterReserve = arena.getUsed();
+    auto reserved = orders.getStats();
+    
+    std::vector<std::shared_ptr<Order>> live;
+    live.reserve(NUM_ORDERS);
+    
+    timer.reset();
+    for (int i = 0; i < NUM_ORDERS; ++i) {
+        live.push_back(orders.make(
+            i, "AAPL", Side::BUY, OrderType::LIMIT, doubleToPrice(150.0), 100
+        ));
+    }
+    uint64_t pooledTime = timer.elapsedMicros();
+    live.clear();
+    
+    timer.reset();
+    for (int i = 0; i < NUM_ORDERS; ++i) {
+        live.push_back(std::make_shared<Order>(
+            i, "AAPL", Side::BUY, OrderType::LIMIT, doubleToPrice(150.0), 100
+        ));
+    }
+    uint64_t heapTime = timer.elapsedMicros();
+    live.clear();
+    
+    // Several threads making and dropping orders at once, as client
+    // readers and the engine do: a slot handed out twice would change an
+    // order under its owner
+    const int THREADS = 4;
+    const int CHURN = 100000;
+    const size_t WINDOW = 16;
+    std::atomic<int> clobbered{0};
+    std::vector<std::thread> churners;
+    for (int t = 0; t < THREADS; ++t) {
+        churners.emplace_back([&, t]() {
+            std::vector<std::shared_ptr<Order>> held;
+            held.reserve(WINDOW);
+            for (int i = 0; i < CHURN; ++i) {
+                OrderId id = static_cast<OrderId>(t) * CHURN + i;
+                held.push_back(orders.make(
+                    id, "AAPL", Side::BUY, OrderType::LIMIT, doubleToPrice(150.0), 100
+                ));
+                if (held.size() == WINDOW) {
+                    for (size_t k = 0; k < WINDOW; ++k) {
+                        if (held[k]->getId() != id - (WINDOW - 1) + k) clobbered++;
+                    }
+                    held.clear();
+                }
+            }
+        });
+    }
+    for (auto& thread : churners) {
+        thread.join();
+    }
+    LOG_INFO("Concurrent churn: ", THREADS, " threads x ", CHURN, " orders, ",
+             clobbered.load(), " clobbered");
+    
+    auto after = orders.getStats();
+    LOG_INFO("Pooled orders: ", pooledTime * 1000.0 / NUM_ORDERS, " ns each; make_shared: ",
+             heapTime * 1000.0 / NUM_ORDERS, " ns each");
+    LOG_INFO("Order pool: ", after.blocksAllocated, " blocks, ", after.arenaBlocks,
+             " from the arena, ", after.heapBlocks, " from the heap, ",
+             after.bytesReserved >> 10, " KB");
+    
+    // A pool larger than the arena spills to the heap and says so
+    ArenaSettings small;
+    small.bytes = MemoryArena::HUGE_PAGE_SIZE;
+    small.lock = false;
+    MemoryArena smallArena(small);
+    MemoryPool<Order, 1024> spill(&smallArena);
+    spill.reserve(20000);
+    auto spillStats = spill.getStats();
+    LOG_INFO("Undersized arena: ", spillStats.arenaBlocks, " arena blocks, ",
+             spillStats.heapBlocks, " heap blocks");
+    
+    bool noGrowth = after.blocksAllocated == reserved.blocksAllocated &&
+                    after.heapBlocks == 0 && arena.getUsed() == usedAfterReserve;
+    bool spilled = spillStats.arenaBlocks > 0 && spillStats.heapBlocks > 0 &&
+                   spillStats.totalCapacity >= 20000;
+    
+    if (noGrowth && spilled && clobbered == 0) {
+        LOG_INFO("✓ Arena pool test completed");
+    } else {
+        LOG_ERROR("✗ Arena-backed pools grew during trading or misreported usage");
+    }
 }
 
 int main() {
@@ -302,6 +614,9 @@ int main() {
         testThroughput();
         testCacheBehavior();
         testMultithreadedSubmission();
+        testOrderIndex();
+        testLocalMemoryPool();
+        testArenaPools();
         
         LOG_INFO("\n========================================");
         LOG_INFO("All Phase 4 tests completed successfully!");
@@ -2,12 +2,24 @@
 #include "core/order.hpp"
 #include "core/trade.hpp"
 #include "engine/matching_engine.hpp"
+#include "engine/engine_runner.hpp"
 #include "risk/risk_manager.hpp"
+#include "risk/risk_shard.hpp"
 #include "utils/config.hpp"
 #include "utils/metrics.hpp"
+#include "utils/latency_trace.hpp"
 #include "utils/logger.hpp"
+#include "utils/thread_pool.hpp"
+#include "utils/thread_runtime.hpp"
+#include "utils/timer.hpp"
 #include <iostream>
 #include <fstream>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
 
 using namespace trading;
 using namespace trading::risk;
@@ -59,23 +71,23 @@ void testRiskManagement() {
     // Set up risk limits
     RiskLimits limits;
     limits.maxOrderSize = 1000;
-    limits.maxOrderValue = 150000.0;
+    limits.maxOrderValue = doubleToNotional(150000.0);
     limits.maxPositionSize = 5000;
-    limits.maxDailyLoss = 50000.0;
+    limits.maxDailyLoss = doubleToNotional(50000.0);
     
     RiskManager riskMgr(limits);
     
     // Test 1: Valid order
     Order validOrder(1, "AAPL", Side::BUY, OrderType::LIMIT, 
                      doubleToPrice(150.00), 500);
-    auto result = riskMgr.validateOrder(validOrder, 150.00);
+    auto result = riskMgr.validateOrder(validOrder, doubleToPrice(150.00));
     LOG_INFO("Valid order (500 shares): ", 
              RiskManager::validationResultToString(result));
     
     // Test 2: Order too large
     Order tooLarge(2, "AAPL", Side::BUY, OrderType::LIMIT,
                    doubleToPrice(150.00), 2000);
-    result = riskMgr.validateOrder(tooLarge, 150.00);
+    result = riskMgr.validateOrder(tooLarge, doubleToPrice(150.00));
     LOG_INFO("Too large order (2000 shares): ",
              RiskManager::validationResultToString(result));
     
@@ -88,8 +100,8 @@ void testRiskManagement() {
     const Position& pos = riskMgr.getPosition("AAPL");
     LOG_INFO("After buying 300 shares:");
     LOG_INFO("  Position: ", pos.quantity, " shares");
-    LOG_INFO("  Avg Price: $", pos.averagePrice);
-    LOG_INFO("  Realized P&L: $", pos.realizedPnL);
+    LOG_INFO("  Avg Price: $", priceToDouble(pos.getAveragePrice()));
+    LOG_INFO("  Realized P&L: $", notionalToDouble(pos.realizedPnL));
     
     // Sell some
     Trade trade2(2, 101, "AAPL", doubleToPrice(152.00), 100);
@@ -98,16 +110,36 @@ void testRiskManagement() {
     const Position& pos2 = riskMgr.getPosition("AAPL");
     LOG_INFO("\nAfter selling 100 shares at $152:");
     LOG_INFO("  Position: ", pos2.quantity, " shares");
-    LOG_INFO("  Realized P&L: $", pos2.realizedPnL);
-    LOG_INFO("  Daily P&L: $", riskMgr.getDailyPnL());
+    LOG_INFO("  Realized P&L: $", notionalToDouble(pos2.realizedPnL));
+    LOG_INFO("  Daily P&L: $", notionalToDouble(riskMgr.getDailyPnL()));
     
     // Test 4: Position limit
     Order wouldExceedLimit(3, "AAPL", Side::BUY, OrderType::LIMIT,
                            doubleToPrice(150.00), 5000);
-    result = riskMgr.validateOrder(wouldExceedLimit, 150.00);
+    result = riskMgr.validateOrder(wouldExceedLimit, doubleToPrice(150.00));
     LOG_INFO("\nOrder that would exceed position limit:");
     LOG_INFO("  ", RiskManager::validationResultToString(result));
     
+    // Test 5: P&L is exact to the cent, even when the average price is
+    // not a whole tick and the position is closed in uneven pieces
+    RiskManager exact;
+    const Price buys[] = {doubleToPrice(100.00), doubleToPrice(100.01), doubleToPrice(100.01)};
+    for (int i = 0; i < 3; ++i) {
+        exact.updatePosition(Trade(10 + i, 20 + i, "MSFT", buys[i], 1), Side::BUY);
+    }
+    exact.updatePosition(Trade(30, 31, "MSFT", doubleToPrice(101.00), 1), Side::SELL);
+    exact.updatePosition(Trade(32, 33, "MSFT", doubleToPrice(99.00), 2), Side::SELL);
+    // Bought for $300.02, sold for $299.00
+    const Position& roundTrip = exact.getPosition("MSFT");
+    if (pos2.realizedPnL == doubleToNotional(200.00) && roundTrip.isFlat() &&
+        roundTrip.costBasis == 0 && roundTrip.realizedPnL == doubleToNotional(-1.02)) {
+        LOG_INFO("\n✓ Realized P&L exact: $", notionalToDouble(pos2.realizedPnL),
+                 ", round trip $", notionalToDouble(roundTrip.realizedPnL));
+    } else {
+        LOG_ERROR("\n✗ Realized P&L off: $", notionalToDouble(pos2.realizedPnL),
+                  ", round trip $", notionalToDouble(roundTrip.realizedPnL));
+    }
+    
     LOG_INFO("\n✓ Risk management tests completed");
 }
 
@@ -130,7 +162,7 @@ void testMetrics() {
     
     // Record some trades
     for (int i = 0; i < 50; ++i) {
-        metrics.recordTrade(100, 15000.0);
+        metrics.recordTrade(100, doubleToNotional(15000.0));
         metrics.recordLatency(1500);  // 1.5 microseconds
     }
     
@@ -145,6 +177,58 @@ void testMetrics() {
     LOG_INFO("✓ Metrics test completed");
 }
 
+void testConcurrentMetrics() {
+    LOG_INFO("\n=== Test 3b: Per-Thread Metrics & Prometheus Export ===");
+    
+    SystemMetrics& metrics = SystemMetrics::getInstance();
+    metrics.reset();
+    
+    const int NUM_THREADS = 4;
+    const int ORDERS_PER_THREAD = 100000;
+    
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+        threads.emplace_back([&metrics, ORDERS_PER_THREAD]() {
+            for (int i = 0; i < ORDERS_PER_THREAD; ++i) {
+                metrics.recordOrderSubmitted();
+                metrics.recordLatency(200 + (i % 1000) * 10);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    uint64_t expected = static_cast<uint64_t>(NUM_THREADS) * ORDERS_PER_THREAD;
+    uint64_t submitted = metrics.getOrdersSubmitted();
+    if (submitted == expected) {
+        LOG_INFO("✓ Per-thread counters summed correctly: ", submitted);
+    } else {
+        LOG_ERROR("✗ Expected ", expected, " orders, got ", submitted);
+    }
+    
+    metrics.setGauge(SystemMetrics::Gauge::BID_LEVELS, 12);
+    
+    std::string exposition = metrics.toPrometheus();
+    bool hasCounter = exposition.find("trading_orders_submitted_total " +
+                                      std::to_string(expected)) != std::string::npos;
+    bool hasHistogram = exposition.find("trading_order_latency_ns_bucket{le=\"+Inf\"} " +
+                                        std::to_string(expected)) != std::string::npos;
+    bool hasGauge = exposition.find("trading_bid_levels 12") != std::string::npos;
+    
+    if (hasCounter && hasHistogram && hasGauge) {
+        LOG_INFO("✓ Prometheus exposition contains counters, histogram and gauges");
+    } else {
+        LOG_ERROR("✗ Prometheus exposition incomplete");
+        std::cout << exposition << std::endl;
+    }
+    
+    LOG_INFO("  P99 latency bucket: <= ", 
+             metrics.getHistogram(SystemMetrics::Histogram::ORDER_LATENCY).percentile(99), " ns");
+    
+    LOG_INFO("✓ Concurrent metrics test completed");
+}
+
 void testIntegratedSystem() {
     LOG_INFO("\n=== Test 4: Integrated System with Risk & Metrics ===");
     
@@ -162,7 +246,7 @@ void testIntegratedSystem() {
     // Track trades
     engine.setTradeCallback([&](const Trade& trade) {
         LOG_INFO("TRADE: ", trade.toString());
-        metrics.recordTrade(trade.getQuantity(), trade.getValue());
+        metrics.recordTrade(trade.getQuantity(), trade.getNotional());
         
         // Update positions (determine aggressor)
         riskMgr.updatePosition(trade, Side::BUY);  // Simplified
@@ -173,8 +257,7 @@ void testIntegratedSystem() {
         metrics.recordOrderSubmitted();
         
         // Validate
-        auto result = riskMgr.validateOrder(*order, 
-                                            priceToDouble(order->getPrice()));
+        auto result = riskMgr.validateOrder(*order, order->getPrice());
         
         if (result != RiskManager::ValidationResult::ACCEPTED) {
             LOG_WARN("Order rejected: ", 
@@ -220,8 +303,8 @@ void testIntegratedSystem() {
     const Position& pos = riskMgr.getPosition("AAPL");
     LOG_INFO("\nFinal Position:");
     LOG_INFO("  Quantity: ", pos.quantity, " shares");
-    LOG_INFO("  Avg Price: $", pos.averagePrice);
-    LOG_INFO("  Realized P&L: $", pos.realizedPnL);
+    LOG_INFO("  Avg Price: $", priceToDouble(pos.getAveragePrice()));
+    LOG_INFO("  Realized P&L: $", notionalToDouble(pos.realizedPnL));
     LOG_INFO("  Total Bought: ", pos.totalBought);
     LOG_INFO("  Total Sold: ", pos.totalSold);
     
@@ -238,12 +321,12 @@ void testConfigurableSystem() {
     RiskLimits limits;
     limits.maxOrderSize = config.getInt("risk.max_order_size", 10000);
     limits.maxPositionSize = config.getInt("risk.max_position_size", 50000);
-    limits.maxDailyLoss = config.getDouble("risk.max_daily_loss", 100000.0);
+    limits.maxDailyLoss = doubleToNotional(config.getDouble("risk.max_daily_loss", 100000.0));
     
     LOG_INFO("Risk limits loaded from config:");
     LOG_INFO("  Max Order Size: ", limits.maxOrderSize);
     LOG_INFO("  Max Position Size: ", limits.maxPositionSize);
-    LOG_INFO("  Max Daily Loss: $", limits.maxDailyLoss);
+    LOG_INFO("  Max Daily Loss: $", notionalToDouble(limits.maxDailyLoss));
     
     RiskManager riskMgr(limits);
     MatchingEngine engine("AAPL");
@@ -255,7 +338,7 @@ void testConfigurableSystem() {
     int tradesExecuted = 0;
     engine.setTradeCallback([&](const Trade& trade) {
         tradesExecuted++;
-        metrics.recordTrade(trade.getQuantity(), trade.getValue());
+        metrics.recordTrade(trade.getQuantity(), trade.getNotional());
         riskMgr.updatePosition(trade, Side::BUY);
     });
     
@@ -270,7 +353,7 @@ void testConfigurableSystem() {
         
         metrics.recordOrderSubmitted();
         
-        auto result = riskMgr.validateOrder(*order, 150.0);
+        auto result = riskMgr.validateOrder(*order, doubleToPrice(150.0));
         if (result == RiskManager::ValidationResult::ACCEPTED) {
             metrics.recordOrderAccepted();
             engine.submitOrder(order);
@@ -284,11 +367,326 @@ void testConfigurableSystem() {
     LOG_INFO("  Orders accepted: ", metrics.getOrdersAccepted());
     LOG_INFO("  Orders rejected: ", metrics.getOrdersRejected());
     LOG_INFO("  Trades executed: ", tradesExecuted);
-    LOG_INFO("  Daily P&L: $", riskMgr.getDailyPnL());
+    LOG_INFO("  Daily P&L: $", notionalToDouble(riskMgr.getDailyPnL()));
     
     LOG_INFO("\n✓ Configured system test completed");
 }
 
+void testThreadRuntime() {
+    LOG_INFO("\n=== Test 6: Thread Runtime (Affinity, Wait Strategies) ===");
+    
+    Config& config = Config::getInstance();
+    config.set("engine.cpu", "0");
+    config.set("engine.priority", "80");
+    config.set("engine.wait", "park");
+    config.set("engine.numa_local", "false");
+    
+    ThreadSettings engineSettings = ThreadSettings::fromConfig("engine");
+    ThreadSettings defaults = ThreadSettings::fromConfig("unconfigured");
+    
+    if (engineSettings.cpu == 0 && engineSettings.realtimePriority == 80 &&
+        engineSettings.wait == WaitStrategy::PARK && !engineSettings.numaLocal &&
+        defaults.cpu == -1 && defaults.realtimePriority == 0 &&
+        defaults.wait == WaitStrategy::SPIN_THEN_YIELD && defaults.numaLocal) {
+        LOG_INFO("✓ Thread settings read from config (engine.wait=",
+                 waitStrategyToString(engineSettings.wait), ")");
+    } else {
+        LOG_ERROR("✗ Thread settings not read from config");
+    }
+    
+    if (ThreadRuntime::cpuListContains("1,3-5,8", 4) &&
+        !ThreadRuntime::cpuListContains("1,3-5,8", 6) &&
+        !ThreadRuntime::cpuListContains("", 0)) {
+        LOG_INFO("✓ Isolated CPU list parsed");
+    } else {
+        LOG_ERROR("✗ Isolated CPU list misparsed");
+    }
+    
+    // Pinning: SCHED_FIFO usually needs privileges, so only the CPU is asserted
+    ThreadSettings pinned;
+    pinned.cpu = 0;
+    std::atomic<int> ranOn{-2};
+    std::atomic<int> node{-2};
+    std::thread worker = ThreadRuntime::spawn("pinned-test", pinned, [&]() {
+        ranOn = ThreadRuntime::currentCpu();
+        node = ThreadRuntime::currentNumaNode();
+    });
+    worker.join();
+#ifdef __linux__
+    if (ranOn == 0) {
+        LOG_INFO("✓ Spawned thread pinned to CPU 0 (NUMA node ", node.load(), ")");
+    } else {
+        LOG_ERROR("✗ Spawned thread ran on CPU ", ranOn.load());
+    }
+#endif
+    
+    // Parked consumer: every item is seen and a notify wakes it promptly
+    for (WaitStrategy strategy : {WaitStrategy::BUSY_SPIN, WaitStrategy::SPIN_THEN_YIELD,
+                                  WaitStrategy::PARK}) {
+        WakeSignal signal;
+        std::atomic<uint64_t> published{0};
+        std::atomic<bool> done{false};
+        uint64_t consumed = 0;
+        
+        std::thread consumer([&]() {
+            IdleStrategy idle(strategy, &signal);
+            auto ready = [&] { return published.load() > consumed || done.load(); };
+            while (!done || consumed < published.load()) {
+                if (published.load(std::memory_order_acquire) > consumed) {
+                    consumed++;
+                    idle.reset();
+                } else {
+                    idle.idle(ready);
+                }
+            }
+        });
+        
+        const int ITEMS = 200;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < ITEMS; ++i) {
+            published.fetch_add(1, std::memory_order_release);
+            signal.notify();
+            if (i % 20 == 0) {
+                // Let the consumer run out of work and park
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+        }
+        done = true;
+        signal.notify();
+        consumer.join();
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        
+        if (consumed == ITEMS) {
+            LOG_INFO("✓ ", waitStrategyToString(strategy), ": consumed ", consumed,
+                     " items in ", elapsed, " ms");
+        } else {
+            LOG_ERROR("✗ ", waitStrategyToString(strategy), ": consumed ", consumed,
+                      " of ", ITEMS);
+        }
+    }
+}
+
+void testRiskShard() {
+    LOG_INFO("\n=== Test 7: Per-Account Risk Shard ===");
+    
+    // 1. One account tracked by both: same positions and P&L as RiskManager
+    RiskManager single;
+    RiskShard shard({"AAPL"});
+    std::mt19937 rng(11);
+    Price price = doubleToPrice(150.00);
+    for (int i = 0; i < 2000; ++i) {
+        price += (static_cast<Price>(rng() % 11) - 5) * doubleToPrice(0.01);
+        AccountId buyer = 1 + rng() % 5;
+        AccountId seller = 1 + rng() % 5;
+        Trade trade(2 * i + 1, 2 * i + 2, "AAPL", price, 10 + rng() % 90);
+        trade.setAccounts(buyer, seller);
+        shard.onTrade(trade);
+        if (buyer == 1) single.updatePosition(trade, Side::BUY);
+        if (seller == 1) single.updatePosition(trade, Side::SELL);
+    }
+    single.updateUnrealizedPnL("AAPL", price);
+    shard.markToMarket("AAPL", price);
+    
+    const Position& expected = single.getPosition("AAPL");
+    Position actual = shard.getPosition(1, "AAPL");
+    bool samePosition = expected.quantity == actual.quantity &&
+                        expected.costBasis == actual.costBasis &&
+                        expected.realizedPnL == actual.realizedPnL;
+    bool sameEquity = single.getTotalPnL() == shard.getAccount(1)->getEquity();
+    
+    // Trades are zero-sum: at one mark, the accounts' equity adds up to nothing
+    Notional totalEquity = 0;
+    for (AccountId account = 1; account <= 5; ++account) {
+        totalEquity += shard.getAccount(account)->getEquity();
+    }
+    LOG_INFO("Account 1: ", actual.quantity, " shares, realized $",
+             notionalToDouble(actual.realizedPnL), ", equity $",
+             notionalToDouble(shard.getAccount(1)->getEquity()), " (RiskManager $",
+             notionalToDouble(single.getTotalPnL()), "); all accounts $",
+             notionalToDouble(totalEquity));
+    
+    // 2. Accounts beyond capacity are rejected rather than left untracked
+    RiskShard small({"AAPL"}, RiskLimits(), 2);
+    Trade first(1, 2, "AAPL", doubleToPrice(150.00), 10);
+    first.setAccounts(10, 11);
+    small.onTrade(first);
+    Order known(3, "AAPL", Side::BUY, OrderType::LIMIT, doubleToPrice(150.00), 10);
+    known.setAccountId(10);
+    Order unknown(4, "AAPL", Side::BUY, OrderType::LIMIT, doubleToPrice(150.00), 10);
+    unknown.setAccountId(12);
+    bool capacityHeld = small.validateOrder(known) == RiskShard::ValidationResult::ACCEPTED &&
+                        small.validateOrder(unknown) ==
+                            RiskShard::ValidationResult::REJECTED_ACCOUNT_LIMIT &&
+                        small.getAccountCount() == 3;  // No-account slot + 2
+    
+    // 3. Check cost with many accounts
+    const int ACCOUNTS = 1000;
+    RiskShard wide({"AAPL", "MSFT", "GOOGL"}, RiskLimits(), ACCOUNTS);
+    std::vector<Order> orders;
+    for (int i = 0; i < ACCOUNTS; ++i) {
+        Trade fill(i + 1, i + 100001, "MSFT", doubleToPrice(300.00), 100);
+        fill.setAccounts(static_cast<AccountId>(i + 1), static_cast<AccountId>(ACCOUNTS - i));
+        wide.onTrade(fill);
+        orders.emplace_back(i + 1, "MSFT", i % 2 ? Side::BUY : Side::SELL, OrderType::LIMIT,
+                            doubleToPrice(300.00), 100);
+        orders.back().setAccountId(static_cast<AccountId>(i + 1));
+    }
+    const int CHECKS = 1000000;
+    int accepted = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < CHECKS; ++i) {
+        accepted += wide.validateOrder(orders[i % ACCOUNTS]) == RiskShard::ValidationResult::ACCEPTED;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("Pre-trade check: ", elapsed / CHECKS, " ns over ", ACCOUNTS, " accounts (",
+             accepted, " accepted)");
+    
+    // 4. On the matching thread: rejects come back as order updates
+    RiskLimits limits;
+    limits.maxPositionSize = 300;
+    EngineRunner runner("AAPL");
+    runner.enableRisk(limits);
+    auto feed = runner.addConsumer();
+    runner.start();
+    auto submit = [&runner](OrderId id, Side side, AccountId account) {
+        auto order = std::make_shared<Order>(id, "AAPL", side, OrderType::LIMIT,
+                                             doubleToPrice(150.00), 200);
+        order->setAccountId(account);
+        runner.submitOrder(order, id);
+    };
+    submit(1, Side::SELL, 7);
+    {
+        TraceScope trace;  // Follows order 2 through risk and matching
+        submit(2, Side::BUY, 8);
+    }
+    submit(3, Side::BUY, 8);  // Would take account 8 to 400
+    runner.stop();
+    
+    bool rejected = false;
+    bool traced = false;
+    feed.poll([&](const EngineEvent& event) {
+        if (event.type == EngineEventType::ORDER_UPDATE && event.orderId == 3) {
+            rejected = event.order->getStatus() == OrderStatus::REJECTED;
+        }
+        if (event.trace.stageMask != 0) {
+            traced = event.orderId == 2 && event.trace.has(TraceStage::SOCKET_READ) &&
+                     event.trace.has(TraceStage::RISK_CHECK) &&
+                     event.trace.has(TraceStage::MATCH);
+        }
+    });
+    const RiskShard* runnerRisk = runner.getRiskShard();
+    bool positionsTracked = runnerRisk->getPosition(8, "AAPL").quantity == 200 &&
+                            runnerRisk->getPosition(7, "AAPL").quantity == -200;
+    LOG_INFO("Runner: order 3 ", rejected ? "rejected" : "accepted", ", account 8 holds ",
+             runnerRisk->getPosition(8, "AAPL").quantity);
+    
+    if (samePosition && sameEquity && totalEquity == 0 && capacityHeld &&
+        rejected && positionsTracked && traced) {
+        LOG_INFO("✓ Risk shard tracks every account and enforces limits in place");
+    } else {
+        LOG_ERROR("✗ Risk shard mismatch (position ", samePosition, ", equity ", sameEquity,
+                  ", capacity ", capacityHeld, ", runner ", rejected && positionsTracked,
+                  ", trace ", traced, ")");
+    }
+}
+
+void testPortfolioRevaluation() {
+    LOG_INFO("\n=== Test 8: Portfolio Revaluation ===");
+    
+    const std::vector<Symbol> symbols = {"AAPL", "MSFT", "GOOGL", "AMZN",
+                                         "NVDA", "META", "TSLA", "NFLX"};
+    const size_t ACCOUNTS = 20000;
+    RiskShard shard(symbols, RiskLimits(), ACCOUNTS);
+    std::mt19937 rng(23);
+    std::vector<Price> marks(symbols.size());
+    for (size_t s = 0; s < symbols.size(); ++s) {
+        marks[s] = doubleToPrice(100.00 + 50.0 * s);
+    }
+    for (int i = 0; i < 200000; ++i) {
+        size_t s = rng() % symbols.size();
+        Price price = marks[s] + (static_cast<Price>(rng() % 201) - 100);
+        Trade trade(2 * i + 1, 2 * i + 2, symbols[s], price, 1 + rng() % 500);
+        trade.setAccounts(1 + rng() % ACCOUNTS, 1 + rng() % ACCOUNTS);
+        shard.onTrade(trade);
+    }
+    
+    // Every account's equity and exposure, from its positions at `at`
+    auto matches = [&](const RiskShard& risk, const std::vector<Price>& at) {
+        Notional total = 0;
+        for (AccountId account = 1; account <= ACCOUNTS; ++account) {
+            auto totals = risk.getAccount(account);
+            if (!totals) continue;
+            Notional unrealized = 0;
+            Notional exposure = 0;
+            for (size_t s = 0; s < symbols.size(); ++s) {
+                Position position = risk.getPosition(account, symbols[s]);
+                unrealized += at[s] * position.quantity - position.costBasis;
+                exposure += at[s] * std::abs(position.quantity);
+            }
+            if (totals->unrealizedPnL != unrealized || totals->grossExposure != exposure) {
+                return false;
+            }
+            total += totals->getEquity();
+        }
+        return total == 0;  // Zero-sum across accounts
+    };
+    
+    // 1. Per-symbol kernel, as on a BBO change
+    Timer timer;
+    const int ROUNDS = 100;
+    for (int round = 0; round < ROUNDS; ++round) {
+        for (size_t s = 0; s < symbols.size(); ++s) {
+            shard.markToMarket(symbols[s], marks[s] + (round % 2));
+        }
+    }
+    uint64_t kernelNs = timer.elapsedNanos();
+    for (size_t s = 0; s < symbols.size(); ++s) {
+        shard.markToMarket(symbols[s], marks[s]);
+    }
+    bool kernelExact = matches(shard, marks);
+    LOG_INFO("Mark one symbol across ", shard.getAccountCount(), " accounts: ",
+             kernelNs / (ROUNDS * symbols.size()), " ns (",
+             static_cast<double>(kernelNs) / (ROUNDS * symbols.size() * shard.getAccountCount()),
+             " ns per position)");
+    
+    // 2. End-of-interval sweep: new marks everywhere, then one pass,
+    //    on this thread and split across a pool
+    RiskShard pooled = shard;
+    for (size_t s = 0; s < symbols.size(); ++s) {
+        marks[s] += static_cast<Price>(rng() % 1001) - 500;
+        shard.setMark(symbols[s], marks[s]);
+        pooled.setMark(symbols[s], marks[s]);
+    }
+    timer.reset();
+    shard.revalueAll();
+    uint64_t serialNs = timer.elapsedNanos();
+    
+    ThreadPool pool(3);
+    timer.reset();
+    pooled.revalueAll(&pool);
+    uint64_t pooledNs = timer.elapsedNanos();
+    
+    bool sweepExact = matches(shard, marks) && matches(pooled, marks);
+    for (AccountId account = 1; account <= ACCOUNTS && sweepExact; ++account) {
+        auto a = shard.getAccount(account);
+        auto b = pooled.getAccount(account);
+        sweepExact = a.has_value() == b.has_value() &&
+                     (!a || (a->getEquity() == b->getEquity() && a->peakEquity == b->peakEquity));
+    }
+    LOG_INFO("Full sweep of ", shard.getAccountCount() * symbols.size(), " positions: ",
+             serialNs / 1000, " µs on one thread, ", pooledNs / 1000, " µs on ",
+             pool.getThreadCount(), " threads (", std::thread::hardware_concurrency(),
+             " cores)");
+    
+    if (kernelExact && sweepExact) {
+        LOG_INFO("✓ Kernel and parallel sweep agree with the positions to the cent");
+    } else {
+        LOG_ERROR("✗ Revaluation mismatch (kernel ", kernelExact, ", sweep ", sweepExact, ")");
+    }
+}
+
 int main() {
     Logger::getInstance().setLogLevel(LogLevel::INFO);
     Logger::getInstance().setOutputFile("production_test.log");
@@ -301,8 +699,12 @@ int main() {
         testConfiguration();
         testRiskManagement();
         testMetrics();
+        testConcurrentMetrics();
         testIntegratedSystem();
         testConfigurableSystem();
+        testThreadRuntime();
+        testRiskShard();
+        testPortfolioRevaluation();
         
         LOG_INFO("\n========================================");
         LOG_INFO("All Phase 6 tests completed successfully!");